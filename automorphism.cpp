@@ -0,0 +1,239 @@
+#include "automorphism.hpp"
+
+#include <cmath>
+
+#include "isomorphism.hpp"
+
+using namespace std;
+
+namespace
+{
+    double log10Factorial(int n)
+    {
+        return lgamma(n + 1.0) / log(10.0);
+    }
+
+    // Union-find over vertices; an orbit is marked failed once no
+    // automorphism takes the fixed vertex into it
+    class OrbitSets
+    {
+    public:
+        explicit OrbitSets(int n) : m_parent(n), m_size(n, 1), m_failed(n, 0)
+        {
+            for (int v = 0; v < n; v++)
+                m_parent[v] = v;
+        }
+
+        int find(int v)
+        {
+            while (m_parent[v] != v)
+            {
+                m_parent[v] = m_parent[m_parent[v]];
+                v = m_parent[v];
+            }
+            return v;
+        }
+
+        void unite(int a, int b)
+        {
+            a = find(a);
+            b = find(b);
+            if (a == b)
+                return;
+            if (m_size[a] < m_size[b])
+                swap(a, b);
+            m_parent[b] = a;
+            m_size[a] += m_size[b];
+            m_failed[a] |= m_failed[b];
+        }
+
+        int size(int v) { return m_size[find(v)]; }
+        bool failed(int v) { return m_failed[find(v)] != 0; }
+
+        void markFailed(int v)
+        {
+            m_failed[find(v)] = 1;
+            m_marked.push_back(v);
+        }
+
+        // Unions carry the mark to the new root, so clear where each mark
+        // started and where it ended up
+        void clearFailed()
+        {
+            for (int v : m_marked)
+            {
+                m_failed[v] = 0;
+                m_failed[find(v)] = 0;
+            }
+            m_marked.clear();
+        }
+
+    private:
+        vector<int> m_parent;
+        vector<int> m_size;
+        vector<char> m_failed;
+        vector<int> m_marked;
+    };
+
+    // Individualise the first vertex of the target cell level by level down
+    // to a discrete partition. Then, from the deepest level up, look for an
+    // automorphism fixing the vertices above that level and moving its fixed
+    // vertex to each other vertex of the cell. Generators found deeper fix
+    // more, so the orbits at each level are already those of its stabiliser;
+    // vertices in the fixed vertex's orbit, or in one already ruled out, are
+    // skipped without a search.
+    template <typename G>
+    AutomorphismGroup computeGroup(const G& graph)
+    {
+        int n = graph.size();
+        AutomorphismGroup group;
+        group.numVertices = n;
+
+        vector<Partition<G::capacity>> path(1);
+        path[0].reset(n);
+        splitByKeys(path[0], vertexInvariants(graph));
+        refinePartition(graph, path[0], -1);
+
+        vector<int> cells, fixed;
+        vector<uint64_t> traces;
+        while (!path.back().discrete())
+        {
+            int cell = path.back().targetCell();
+            Partition<G::capacity> next = path.back();
+            int v = next.at(cell);
+            next.individualise(v);
+            traces.push_back(refinePartition(graph, next, cell));
+            cells.push_back(cell);
+            fixed.push_back(v);
+            path.push_back(next);
+        }
+
+        OrbitSets orbits(n);
+        IsomorphismSearch<G> search(graph, graph);
+        for (int level = (int)cells.size() - 1; level >= 0; level--)
+        {
+            const Partition<G::capacity>& parent = path[level];
+            int cell = cells[level];
+            int u = fixed[level];
+            orbits.clearFailed();
+
+            for (int p = cell; p < cell + parent.lengthOf(cell); p++)
+            {
+                int v = parent.at(p);
+                if (orbits.find(v) == orbits.find(u) || orbits.failed(v))
+                    continue;
+
+                Partition<G::capacity> candidate = parent;
+                candidate.individualise(v);
+                uint64_t trace = refinePartition(graph, candidate, cell);
+                if (trace != traces[level] || candidate.cellCount() != path[level + 1].cellCount() || !search.match(path[level + 1], candidate))
+                {
+                    orbits.markFailed(v);
+                    continue;
+                }
+
+                const vector<int>& generator = search.mapping();
+                for (int w = 0; w < n; w++)
+                    orbits.unite(w, generator[w]);
+                group.generators.push_back(generator);
+            }
+            group.stabiliserOrbits.push_back(orbits.size(u));
+        }
+
+        group.orbits.assign(n, -1);
+        vector<int> smallest(n, -1);
+        for (int v = 0; v < n; v++)
+        {
+            int root = orbits.find(v);
+            if (smallest[root] == -1)
+                smallest[root] = v;
+            group.orbits[v] = smallest[root];
+        }
+        return group;
+    }
+}
+
+int AutomorphismGroup::orbitCount() const
+{
+    int count = 0;
+    for (int v = 0; v < numVertices; v++)
+    {
+        if (orbits[v] == v)
+            count++;
+    }
+    return count;
+}
+
+double AutomorphismGroup::log10Order() const
+{
+    double total = 0.0;
+    for (int length : stabiliserOrbits)
+        total += log10((double)length);
+    return total;
+}
+
+string AutomorphismGroup::order() const
+{
+    // Little-endian decimal digits
+    vector<int> digits(1, 1);
+    for (int length : stabiliserOrbits)
+    {
+        long long carry = 0;
+        for (int& digit : digits)
+        {
+            long long value = (long long)digit * length + carry;
+            digit = (int)(value % 10);
+            carry = value / 10;
+        }
+        for (; carry > 0; carry /= 10)
+            digits.push_back((int)(carry % 10));
+    }
+
+    string text;
+    for (auto it = digits.rbegin(); it != digits.rend(); ++it)
+        text += (char)('0' + *it);
+    return text;
+}
+
+bool AutomorphismGroup::isSymmetric() const
+{
+    // The order divides n!, so short of it means at most half of it
+    return log10Factorial(numVertices) - log10Order() < 0.15;
+}
+
+AutomorphismGroup automorphismGroup(int numVertices, const vector<pair<int, int>>& edgeList)
+{
+    if (numVertices <= SmallGraph::capacity)
+        return computeGroup(makeSmallGraph(numVertices, edgeList));
+    return computeGroup(buildGraph(numVertices, edgeList));
+}
+
+bool isAutomorphism(int numVertices, const vector<pair<int, int>>& edgeList, const vector<int>& permutation)
+{
+    if (numVertices <= SmallGraph::capacity)
+    {
+        SmallGraph graph = makeSmallGraph(numVertices, edgeList);
+        return isIsomorphism(graph, graph, permutation.data());
+    }
+    Graph graph = buildGraph(numVertices, edgeList);
+    return isIsomorphism(graph, graph, permutation.data());
+}
+
+double puzzleDifficulty(const AutomorphismGroup& group)
+{
+    double relabelings = log10Factorial(group.numVertices);
+    if (relabelings <= 0.0)
+        return 0.0;
+    return 10.0 * max(relabelings - group.log10Order(), 0.0) / relabelings;
+}
+
+const char* difficultyName(double difficulty)
+{
+    if (difficulty < trivialDifficulty)
+        return "trivial";
+    if (difficulty < 4.0)
+        return "easy";
+    if (difficulty < 7.0)
+        return "medium";
+    return "hard";
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Automorphism group of a graph (loops and repeated edges ignored) as a set
+// of generating permutations and the vertex orbits they give
+struct AutomorphismGroup
+{
+    int numVertices = 0;
+    std::vector<std::vector<int>> generators; // vertex v goes to generators[k][v]
+    std::vector<int> orbits;                  // smallest vertex in the orbit of each vertex
+    std::vector<int> stabiliserOrbits;        // orbit lengths down the stabiliser chain; the order is their product
+
+    int orbitCount() const;
+    double log10Order() const;
+
+    // Exact order in decimal, which can run far past 64 bits
+    std::string order() const;
+
+    // Whether every permutation is an automorphism (empty and complete graphs)
+    bool isSymmetric() const;
+};
+
+// Generators, orbits and order by individualisation and refinement along one
+// path, pruned by the orbits found so far. Up to 64 vertices runs on
+// SmallGraph bitboards.
+AutomorphismGroup automorphismGroup(int numVertices, const std::vector<std::pair<int, int>>& edgeList);
+
+// Whether the permutation takes the edges onto themselves
+bool isAutomorphism(int numVertices, const std::vector<std::pair<int, int>>& edgeList, const std::vector<int>& permutation);
+
+// Puzzle difficulty from 0 to 10: the share of the n! relabelings that give
+// a different graph 2, on a log scale. Each distinct graph 2 has |Aut|
+// correct answers, so 0 means every relabeling gives graph 1 back and 10
+// means the graph has no symmetry at all.
+double puzzleDifficulty(const AutomorphismGroup& group);
+
+// Ratings below this leave so few distinct graph 2s that the puzzle is trivial
+const double trivialDifficulty = 1.0;
+
+// Short word for a difficulty rating, for log messages
+const char* difficultyName(double difficulty);
@@ -0,0 +1,677 @@
+#include "batch.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+
+#include "automorphism.hpp"
+#include "crossings.hpp"
+#include "exporter.hpp"
+#include "graph.hpp"
+#include "isomorphism.hpp"
+#include "logger.hpp"
+#include "mappedfile.hpp"
+#include "parallel.hpp"
+#include "paths.hpp"
+#include "random.hpp"
+#include "scanner.hpp"
+
+using namespace std;
+using namespace sf;
+
+namespace
+{
+    // Puzzles generated and written per round, so huge inputs are not held
+    // in memory all at once
+    const int puzzlesPerRound = 4096;
+
+    // Centres on a circle in the middle of the area, in a random order. The
+    // jitter moves each vertex in or out, like the circle layout of graph 2.
+    vector<Vector2f> circlePositions(int n, const FloatRect& area, bool jitter, Random& rng)
+    {
+        Vector2f centre(area.left + area.width / 2.f, area.top + area.height / 2.f);
+        float radius = 100.f;
+
+        vector<Vector2f> positions(n);
+        for (int i = 0; i < n; i++)
+        {
+            float angle = i * 6.28318f / n;
+            float r = jitter ? radius - rng.between(-40, 60) : radius;
+            positions[i] = Vector2f(centre.x + r * cos(angle), centre.y + r * sin(angle));
+        }
+        permute(positions, rng);
+        return positions;
+    }
+
+    vector<Vector2f> segmentsOf(const vector<pair<int, int>>& edges, const vector<Vector2f>& positions)
+    {
+        vector<Vector2f> segmentEnds;
+        segmentEnds.reserve(edges.size() * 2);
+        for (const auto& edge : edges)
+        {
+            if (edge.first == edge.second)
+                continue;
+            segmentEnds.push_back(positions[edge.first]);
+            segmentEnds.push_back(positions[edge.second]);
+        }
+        return segmentEnds;
+    }
+
+    void appendNumber(string& text, long long value)
+    {
+        char number[24];
+        text.append(number, to_chars(number, number + sizeof(number), value).ptr);
+    }
+
+    // Coordinates are written with one decimal
+    void appendCoordinate(string& text, float value)
+    {
+        long long tenths = llround(value * 10.0);
+        if (tenths < 0)
+        {
+            text += '-';
+            tenths = -tenths;
+        }
+        appendNumber(text, tenths / 10);
+        text += '.';
+        text += (char)('0' + tenths % 10);
+    }
+
+    const char* layoutName(LayoutMode mode)
+    {
+        switch (mode)
+        {
+        case LayoutMode::Circle:
+            return "circle";
+        case LayoutMode::Force:
+            return "force";
+        case LayoutMode::Stress:
+            return "stress";
+        }
+        return "";
+    }
+
+    const char* challengeName(Challenge challenge)
+    {
+        switch (challenge)
+        {
+        case Challenge::None:
+            return "none";
+        case Challenge::EulerTrail:
+            return "euler";
+        case Challenge::HamiltonianPath:
+            return "hamiltonian";
+        }
+        return "";
+    }
+
+    // Empty if the graph has an answer to the challenge, otherwise why not.
+    // Loops and repeated edges count for Euler trails only.
+    string challengeProblem(int numVertices, const vector<pair<int, int>>& edges, Challenge challenge)
+    {
+        if (challenge == Challenge::EulerTrail)
+        {
+            EulerTrail trail;
+            if (!eulerTrail(numVertices, edges, trail))
+                return "no Euler trail";
+        }
+        else if (challenge == Challenge::HamiltonianPath)
+        {
+            vector<int> path;
+            Solvability solvability = hamiltonianPath(buildGraph(numVertices, edges), path);
+            if (solvability == Solvability::Unsolvable)
+                return "no Hamiltonian path";
+            if (solvability == Solvability::Unknown)
+                return "Hamiltonian path search gave up";
+        }
+        return "";
+    }
+
+    string fileName(const string& path)
+    {
+        size_t slash = path.find_last_of("/\\");
+        return slash == string::npos ? path : path.substr(slash + 1);
+    }
+
+    // Seed of one puzzle, mixed from the run seed, the graph and the relabeling
+    unsigned puzzleSeed(unsigned seed, long long graphIndex, int relabeling)
+    {
+        return (unsigned)mixSeed(mixSeed(seed, (uint64_t)graphIndex), (uint64_t)relabeling);
+    }
+
+    int generatePuzzles(const vector<string>& inputs, const PuzzleOptions& options, const string& outputDirectory)
+    {
+        auto started = chrono::steady_clock::now();
+        long long written = 0, rejected = 0, unsolvable = 0;
+        int failedFiles = 0;
+
+        for (const string& input : inputs)
+        {
+            vector<ImportedGraph> graphs;
+            string error;
+            if (!importGraphs(input, graphs, error))
+            {
+                logError(error);
+                failedFiles++;
+                continue;
+            }
+
+            string outputPath = outputDirectory + "/" + fileName(input) + ".puzzle";
+            BufferedWriter out(outputPath);
+            if (!out.isOpen())
+            {
+                logError("Could not write " + outputPath);
+                failedFiles++;
+                continue;
+            }
+
+            // Graphs with no answer to the challenge are not served at all.
+            // Each graph is one task; the layouts and searches inside it call
+            // parallelFor too, which runs serially within a pool task, so the
+            // machine is not oversubscribed.
+            vector<string> challengeProblems(graphs.size());
+            if (options.challenge != Challenge::None)
+            {
+                parallelFor((int)graphs.size(), [&](int begin, int end, int)
+                {
+                    for (int i = begin; i < end; i++)
+                        challengeProblems[i] = challengeProblem(graphs[i].numVertices, graphs[i].edgeList, options.challenge);
+                }, 8);
+            }
+            long long skipped = 0;
+            for (size_t i = 0; i < graphs.size(); i++)
+            {
+                if (!challengeProblems[i].empty())
+                {
+                    logInfo(input + ": graph " + to_string(i + 1) + " skipped: " + challengeProblems[i]);
+                    skipped++;
+                }
+            }
+            unsolvable += skipped;
+
+            // Every (graph, relabeling) pair is an independent job; each round
+            // is generated in parallel and then written in order. The first
+            // job of each graph also rates its difficulty.
+            long long total = (long long)graphs.size() * options.relabelings;
+            vector<float> difficulties(graphs.size(), 0.f);
+            vector<string> texts;
+            for (long long first = 0; first < total; first += puzzlesPerRound)
+            {
+                int count = (int)min<long long>(puzzlesPerRound, total - first);
+                texts.assign(count, string());
+                vector<char> valid(count, 0);
+                parallelFor(count, [&](int begin, int end, int)
+                {
+                    string problem;
+                    for (int i = begin; i < end; i++)
+                    {
+                        long long job = first + i;
+                        long long graphIndex = job / options.relabelings;
+                        int relabeling = (int)(job % options.relabelings);
+                        if (!challengeProblems[graphIndex].empty())
+                            continue;
+                        if (relabeling == 0)
+                            difficulties[graphIndex] = (float)puzzleDifficulty(automorphismGroup(graphs[graphIndex].numVertices, graphs[graphIndex].edgeList));
+                        Puzzle puzzle = generatePuzzle(graphs[graphIndex], options, puzzleSeed(options.seed, graphIndex, relabeling));
+                        if (validatePuzzle(puzzle, options, problem))
+                        {
+                            appendPuzzle(texts[i], puzzle);
+                            valid[i] = 1;
+                        }
+                        else
+                            logError(input + ": graph " + to_string(graphIndex + 1) + ": " + problem);
+                    }
+                }, 8);
+
+                for (int i = 0; i < count; i++)
+                {
+                    if (!challengeProblems[(first + i) / options.relabelings].empty())
+                        continue;
+                    out.write(texts[i]);
+                    (valid[i] ? written : rejected)++;
+                }
+            }
+
+            if (!out.close())
+            {
+                logError("Could not write " + outputPath);
+                failedFiles++;
+                continue;
+            }
+            logInfo("Wrote " + to_string(total - skipped * options.relabelings) + " puzzles for " + to_string(graphs.size() - skipped) +
+                    " graphs to " + outputPath);
+
+            double difficultySum = 0.0;
+            long long trivial = 0;
+            for (size_t i = 0; i < graphs.size(); i++)
+            {
+                if (!challengeProblems[i].empty())
+                    continue;
+                difficultySum += difficulties[i];
+                if (difficulties[i] < trivialDifficulty)
+                    trivial++;
+            }
+            if ((long long)graphs.size() > skipped)
+            {
+                logInfo("Mean difficulty " + to_string(difficultySum / (graphs.size() - skipped)) + " of 10, " + to_string(trivial) +
+                        " graphs trivial through symmetry");
+            }
+        }
+
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        string summary = "Generated " + to_string(written) + " puzzles in " + to_string(seconds) + " s (" +
+                         to_string((long long)(written / max(seconds, 1e-9))) + " per second), " + to_string(rejected) + " rejected";
+        if (options.challenge != Challenge::None)
+            summary += ", " + to_string(unsolvable) + " graphs skipped for the " + challengeName(options.challenge) + " challenge";
+        logInfo(summary);
+        return failedFiles == 0 && rejected == 0 ? 0 : 1;
+    }
+
+    int validatePuzzleFiles(const vector<string>& inputs, const PuzzleOptions& options)
+    {
+        long long checked = 0, failed = 0;
+        int failedFiles = 0;
+        for (const string& input : inputs)
+        {
+            vector<Puzzle> puzzles;
+            string error;
+            if (!readPuzzles(input, puzzles, error))
+            {
+                logError(error);
+                failedFiles++;
+                continue;
+            }
+
+            vector<string> problems(puzzles.size());
+            parallelFor((int)puzzles.size(), [&](int begin, int end, int)
+            {
+                for (int i = begin; i < end; i++)
+                {
+                    if (validatePuzzle(puzzles[i], options, problems[i]))
+                        problems[i] = challengeProblem(puzzles[i].numVertices, puzzles[i].edges1, options.challenge);
+                }
+            }, 64);
+
+            for (size_t i = 0; i < puzzles.size(); i++)
+            {
+                if (!problems[i].empty())
+                {
+                    logError(input + ": puzzle " + to_string(i + 1) + ": " + problems[i]);
+                    failed++;
+                }
+            }
+            checked += (long long)puzzles.size();
+        }
+
+        logInfo("Validated " + to_string(checked) + " puzzles, " + to_string(failed) + " invalid");
+        return failedFiles == 0 && failed == 0 ? 0 : 1;
+    }
+}
+
+Puzzle generatePuzzle(const ImportedGraph& graph, const PuzzleOptions& options, unsigned seed)
+{
+    Random rng(seed);
+    int n = graph.numVertices;
+
+    Puzzle puzzle;
+    puzzle.seed = seed;
+    puzzle.numVertices = n;
+    puzzle.edges1 = graph.edgeList;
+
+    // Graph 2 is graph 1 under a random relabeling, its edges listed in a
+    // random order so the file does not give the answer away. A relabeling
+    // in the automorphism group would give graph 1 back unchanged, so draw
+    // again unless every relabeling does. Automorphisms are at most half of
+    // all relabelings then, so few draws are needed.
+    puzzle.relabeling = randomPermutation(n, rng);
+    if (isAutomorphism(n, puzzle.edges1, puzzle.relabeling) && !automorphismGroup(n, puzzle.edges1).isSymmetric())
+    {
+        while (isAutomorphism(n, puzzle.edges1, puzzle.relabeling))
+            permute(puzzle.relabeling, rng);
+    }
+    puzzle.edges2.reserve(puzzle.edges1.size());
+    for (const auto& edge : puzzle.edges1)
+        puzzle.edges2.push_back(make_pair(puzzle.relabeling[edge.first], puzzle.relabeling[edge.second]));
+    permute(puzzle.edges2, rng);
+
+    puzzle.positions1 = circlePositions(n, options.area1, false, rng);
+    if (n == 0)
+        return puzzle;
+
+    // Keep the graph 2 layout whose crossing count differs most from graph 1
+    long long crossings1 = countCrossings(segmentsOf(puzzle.edges1, puzzle.positions1));
+    Graph graph2 = buildGraph(n, puzzle.edges2);
+    long long bestDifference = -1;
+    for (int candidate = 0; candidate < max(options.candidates, 1); candidate++)
+    {
+        vector<Vector2f> positions;
+        if (options.mode == LayoutMode::Circle)
+            positions = circlePositions(n, options.area2, true, rng);
+        else if (options.mode == LayoutMode::Stress)
+            stressLayout(graph2, options.area2, positions, (unsigned)mixSeed(seed, candidate));
+        else
+            multilevelLayout(graph2, options.area2, positions, (unsigned)mixSeed(seed, candidate));
+
+        long long crossings2 = countCrossings(segmentsOf(puzzle.edges2, positions));
+        long long difference = crossings2 > crossings1 ? crossings2 - crossings1 : crossings1 - crossings2;
+        if (difference > bestDifference)
+        {
+            bestDifference = difference;
+            puzzle.positions2 = positions;
+        }
+    }
+    return puzzle;
+}
+
+bool validatePuzzle(const Puzzle& puzzle, const PuzzleOptions& options, string& problem)
+{
+    int n = puzzle.numVertices;
+    problem.clear();
+
+    if ((int)puzzle.relabeling.size() != n || (int)puzzle.positions1.size() != n || (int)puzzle.positions2.size() != n)
+    {
+        problem = "wrong number of vertices";
+        return false;
+    }
+
+    vector<char> seen(n, 0);
+    for (int label : puzzle.relabeling)
+    {
+        if (label < 0 || label >= n || seen[label])
+        {
+            problem = "relabeling is not a permutation";
+            return false;
+        }
+        seen[label] = 1;
+    }
+
+    auto sorted = [n](vector<pair<int, int>> edges, bool& inRange)
+    {
+        for (auto& edge : edges)
+        {
+            if (edge.first < 0 || edge.second < 0 || edge.first >= n || edge.second >= n)
+                inRange = false;
+            if (edge.first > edge.second)
+                swap(edge.first, edge.second);
+        }
+        sort(edges.begin(), edges.end());
+        return edges;
+    };
+
+    bool inRange = true;
+    vector<pair<int, int>> mapped;
+    mapped.reserve(puzzle.edges1.size());
+    for (const auto& edge : sorted(puzzle.edges1, inRange))
+    {
+        if (!inRange)
+            break;
+        mapped.push_back(make_pair(puzzle.relabeling[edge.first], puzzle.relabeling[edge.second]));
+    }
+    vector<pair<int, int>> edges2 = sorted(puzzle.edges2, inRange);
+    if (!inRange)
+    {
+        problem = "edge vertex out of range";
+        return false;
+    }
+    if (sorted(mapped, inRange) != edges2)
+    {
+        // Say whether only the answer key is wrong or no answer exists at all
+        if (areIsomorphic(n, puzzle.edges1, puzzle.edges2))
+            problem = "relabeling does not map graph 1 onto graph 2, though another relabeling does";
+        else
+            problem = "graph 1 and graph 2 are not isomorphic";
+        return false;
+    }
+
+    // Allow for the one decimal the files keep
+    auto inside = [](const FloatRect& area, Vector2f point)
+    {
+        return isfinite(point.x) && isfinite(point.y) && point.x >= area.left - 0.1f && point.x <= area.left + area.width + 0.1f &&
+               point.y >= area.top - 0.1f && point.y <= area.top + area.height + 0.1f;
+    };
+    for (int v = 0; v < n; v++)
+    {
+        if (!inside(options.area1, puzzle.positions1[v]) || !inside(options.area2, puzzle.positions2[v]))
+        {
+            problem = "vertex " + to_string(v + 1) + " is outside its panel";
+            return false;
+        }
+    }
+    return true;
+}
+
+void appendPuzzle(string& text, const Puzzle& puzzle)
+{
+    text += "puzzle ";
+    appendNumber(text, puzzle.seed);
+    text += ' ';
+    appendNumber(text, puzzle.numVertices);
+    text += ' ';
+    appendNumber(text, (long long)puzzle.edges1.size());
+    text += '\n';
+
+    auto appendEdges = [&](const char* title, const vector<pair<int, int>>& edges)
+    {
+        text += title;
+        for (const auto& edge : edges)
+        {
+            text += ' ';
+            appendNumber(text, edge.first);
+            text += ' ';
+            appendNumber(text, edge.second);
+        }
+        text += '\n';
+    };
+    auto appendPositions = [&](const char* title, const vector<Vector2f>& positions)
+    {
+        text += title;
+        for (const Vector2f& position : positions)
+        {
+            text += ' ';
+            appendCoordinate(text, position.x);
+            text += ' ';
+            appendCoordinate(text, position.y);
+        }
+        text += '\n';
+    };
+
+    appendEdges("edges1", puzzle.edges1);
+    appendPositions("positions1", puzzle.positions1);
+    appendEdges("edges2", puzzle.edges2);
+    appendPositions("positions2", puzzle.positions2);
+
+    text += "answer";
+    for (int label : puzzle.relabeling)
+    {
+        text += ' ';
+        appendNumber(text, label);
+    }
+    text += '\n';
+}
+
+bool readPuzzles(const string& path, vector<Puzzle>& puzzles, string& error)
+{
+    MappedFile file(path);
+    if (!file.isOpen())
+    {
+        error = "Could not open " + path;
+        return false;
+    }
+
+    Scanner scanner = {file.data(), file.data() + file.size(), 1};
+    auto fail = [&](const char* message)
+    {
+        error = path + ": Line " + to_string(scanner.line) + ": " + message;
+        return false;
+    };
+
+    auto readEdges = [&](const char* title, long long m, vector<pair<int, int>>& edges)
+    {
+        if (!scanner.readWord(title))
+            return false;
+        edges.resize(m);
+        for (auto& edge : edges)
+        {
+            long long start, end;
+            if (!scanner.readNumber(start) || !scanner.readNumber(end))
+                return false;
+            edge = make_pair((int)start, (int)end);
+        }
+        bool complete = scanner.atLineEnd();
+        scanner.nextLine();
+        return complete;
+    };
+    auto readPositions = [&](const char* title, int n, vector<Vector2f>& positions)
+    {
+        if (!scanner.readWord(title))
+            return false;
+        positions.resize(n);
+        for (auto& position : positions)
+        {
+            double x, y;
+            if (!scanner.readDecimal(x) || !scanner.readDecimal(y))
+                return false;
+            position = Vector2f((float)x, (float)y);
+        }
+        bool complete = scanner.atLineEnd();
+        scanner.nextLine();
+        return complete;
+    };
+
+    while (!scanner.atEnd())
+    {
+        if (scanner.atLineEnd())
+        {
+            scanner.nextLine();
+            continue;
+        }
+
+        Puzzle puzzle;
+        long long seed, n, m;
+        if (!scanner.readWord("puzzle") || !scanner.readNumber(seed, 4294967295LL) || !scanner.readNumber(n) || !scanner.readNumber(m))
+            return fail("expected \"puzzle <seed> <vertices> <edges>\"");
+        scanner.nextLine();
+
+        // Every vertex and edge takes at least a byte of what is left, so
+        // larger counts are damage, not something to allocate for
+        long long remaining = scanner.end - scanner.pos;
+        if (n > remaining || m > remaining)
+            return fail("vertex or edge count is larger than the rest of the file");
+        puzzle.seed = (unsigned)seed;
+        puzzle.numVertices = (int)n;
+
+        if (!readEdges("edges1", m, puzzle.edges1))
+            return fail("bad edges1 line");
+        if (!readPositions("positions1", (int)n, puzzle.positions1))
+            return fail("bad positions1 line");
+        if (!readEdges("edges2", m, puzzle.edges2))
+            return fail("bad edges2 line");
+        if (!readPositions("positions2", (int)n, puzzle.positions2))
+            return fail("bad positions2 line");
+
+        if (!scanner.readWord("answer"))
+            return fail("missing answer line");
+        puzzle.relabeling.resize(n);
+        for (int& label : puzzle.relabeling)
+        {
+            long long value;
+            if (!scanner.readNumber(value))
+                return fail("bad answer line");
+            label = (int)value;
+        }
+        scanner.nextLine();
+
+        puzzles.push_back(move(puzzle));
+    }
+    return true;
+}
+
+bool batchModeRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        string argument = argv[i];
+        if (argument == "--batch" || argument == "--validate")
+            return true;
+    }
+    return false;
+}
+
+int runBatch(int argc, char* argv[])
+{
+    PuzzleOptions options;
+    options.seed = seedFromArguments(argc, argv);
+    string outputDirectory = ".";
+    bool validating = false;
+    vector<string> inputs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument == "--batch")
+            validating = false;
+        else if (argument == "--validate")
+            validating = true;
+        else if (argument == "--relabelings" && hasValue)
+            options.relabelings = max(1, atoi(argv[++i]));
+        else if (argument == "--seed" && hasValue)
+            i++;
+        else if (argument == "--out" && hasValue)
+            outputDirectory = argv[++i];
+        else if (argument == "--challenge" && hasValue)
+        {
+            string challenge = argv[++i];
+            if (challenge == challengeName(Challenge::EulerTrail))
+                options.challenge = Challenge::EulerTrail;
+            else if (challenge == challengeName(Challenge::HamiltonianPath))
+                options.challenge = Challenge::HamiltonianPath;
+            else if (challenge == challengeName(Challenge::None))
+                options.challenge = Challenge::None;
+            else
+            {
+                logError("Unknown challenge " + challenge + "; use euler, hamiltonian or none.");
+                return 1;
+            }
+        }
+        else if (argument == "--layout" && hasValue)
+        {
+            string mode = argv[++i];
+            if (mode == layoutName(LayoutMode::Circle))
+                options.mode = LayoutMode::Circle;
+            else if (mode == layoutName(LayoutMode::Stress))
+                options.mode = LayoutMode::Stress;
+            else if (mode == layoutName(LayoutMode::Force))
+                options.mode = LayoutMode::Force;
+            else
+            {
+                logError("Unknown layout " + mode + "; use circle, force or stress.");
+                return 1;
+            }
+        }
+        else if (argument == "--quiet" || argument == "-q" || argument == "--verbose" || argument == "-v")
+            continue;
+        else if (!argument.empty() && argument[0] == '-')
+        {
+            logError("Unknown option " + argument);
+            return 1;
+        }
+        else
+            inputs.push_back(argument);
+    }
+
+    if (inputs.empty())
+    {
+        logError("Usage: main --batch [--relabelings N] [--layout circle|force|stress] [--challenge euler|hamiltonian] [--seed S] [--out DIR] graph files...");
+        logError("       main --validate [--challenge euler|hamiltonian] puzzle files...");
+        return 1;
+    }
+
+    if (validating)
+        return validatePuzzleFiles(inputs, options);
+
+    logInfo(string("Generating ") + to_string(options.relabelings) + " relabelings per graph with the " + layoutName(options.mode) +
+            " layout, seed " + to_string(options.seed));
+    return generatePuzzles(inputs, options, outputDirectory);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "importer.hpp"
+#include "layout.hpp"
+
+// One generated puzzle: a graph and an isomorphic relabeling of it, each with
+// its own layout, plus the answer key mapping one onto the other
+struct Puzzle
+{
+    unsigned seed = 0;
+    int numVertices = 0;
+    std::vector<std::pair<int, int>> edges1;
+    std::vector<std::pair<int, int>> edges2;
+    std::vector<int> relabeling;           // graph 2 vertex of each graph 1 vertex
+    std::vector<sf::Vector2f> positions1;  // vertex centres of graph 1
+    std::vector<sf::Vector2f> positions2;  // vertex centres of graph 2
+};
+
+// Extra task a served puzzle's graph must have an answer to
+enum class Challenge
+{
+    None,
+    EulerTrail,
+    HamiltonianPath
+};
+
+// How puzzles are generated; the areas default to the two game panels
+struct PuzzleOptions
+{
+    int relabelings = 1;
+    Challenge challenge = Challenge::None;
+    LayoutMode mode = LayoutMode::Force;
+    int candidates = 4; // graph 2 layouts tried, as in the game
+    unsigned seed = 1;
+    sf::FloatRect area1 = sf::FloatRect(400.f, 0.f, 400.f, 600.f);
+    sf::FloatRect area2 = sf::FloatRect(800.f, 0.f, 400.f, 600.f);
+};
+
+// Generate one puzzle from a graph. The same graph, options and seed always
+// give the same puzzle.
+Puzzle generatePuzzle(const ImportedGraph& graph, const PuzzleOptions& options, unsigned seed);
+
+// Check that the relabeling is a permutation taking the edges of graph 1 onto
+// those of graph 2 and that every vertex sits inside its panel.
+// On failure returns false and describes the problem.
+bool validatePuzzle(const Puzzle& puzzle, const PuzzleOptions& options, std::string& problem);
+
+// Text form used by puzzle files
+void appendPuzzle(std::string& text, const Puzzle& puzzle);
+
+// Read every puzzle in a puzzle file
+bool readPuzzles(const std::string& path, std::vector<Puzzle>& puzzles, std::string& error);
+
+// Whether the command line asks for a headless run (--batch or --validate)
+bool batchModeRequested(int argc, char* argv[]);
+
+// Headless command line mode, no window is opened:
+//   --batch [--relabelings N] [--layout circle|force|stress] [--challenge euler|hamiltonian] [--seed S] [--out DIR] graph files...
+//       writes DIR/<graph file name>.puzzle with N puzzles per input graph,
+//       skipping graphs with no answer to the challenge
+//   --validate [--challenge euler|hamiltonian] puzzle files...
+//       checks every puzzle in the given files
+// Returns the process exit code.
+int runBatch(int argc, char* argv[]);
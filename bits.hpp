@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+// Bit helpers for the uint64_t adjacency rows of small graphs
+inline int popcount64(std::uint64_t x)
+{
+    return __builtin_popcountll(x);
+}
+
+// Index of the lowest set bit; x must not be zero
+inline int lowestBit(std::uint64_t x)
+{
+    return __builtin_ctzll(x);
+}
+
+inline std::uint64_t bitOf(int i)
+{
+    return (std::uint64_t)1 << i;
+}
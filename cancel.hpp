@@ -0,0 +1,19 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+// Flag shared between the render thread and an analysis job. Copies share the
+// same flag, so the render thread can cancel a job that captured its token
+// once the graph the job was started on has changed.
+class CancelToken
+{
+public:
+    CancelToken() : m_cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() { m_cancelled->store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return m_cancelled->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+};
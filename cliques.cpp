@@ -0,0 +1,542 @@
+#include "cliques.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "bits.hpp"
+#include "parallel.hpp"
+
+using namespace std;
+
+namespace
+{
+    // Search nodes between looks at the cancel token
+    const long long nodesPerCancelCheck = 1024;
+
+    // Greedy cliques tried before the exact search, one from each of the
+    // first this many vertices
+    const int greedyStarts = 64;
+
+    // Neighbour bit rows with the vertices renumbered, row by row
+    struct BitRows
+    {
+        int size = 0;
+        int words = 0;
+        vector<uint64_t> bits;
+
+        uint64_t* row(int v) { return bits.data() + (size_t)v * words; }
+        const uint64_t* row(int v) const { return bits.data() + (size_t)v * words; }
+    };
+
+    // Rows of graph with vertex v renumbered index[v]; with forwardOnly a row
+    // only keeps the neighbours numbered above its own vertex
+    BitRows bitRows(const Graph& graph, const vector<int>& index, bool forwardOnly)
+    {
+        BitRows rows;
+        rows.size = graph.numVertices;
+        rows.words = (graph.numVertices + 63) / 64;
+        rows.bits.assign((size_t)rows.size * rows.words, 0);
+        for (int v = 0; v < graph.numVertices; v++)
+        {
+            uint64_t* row = rows.row(index[v]);
+            graph.forEachNeighbour(v, [&](int w) {
+                if (!forwardOnly || index[w] > index[v])
+                    row[index[w] >> 6] |= bitOf(index[w] & 63);
+            });
+        }
+        return rows;
+    }
+
+    bool isEmpty(const uint64_t* set, int from, int words)
+    {
+        for (int i = from; i < words; i++)
+        {
+            if (set[i] != 0)
+                return false;
+        }
+        return true;
+    }
+
+    int countBits(const uint64_t* set, int from, int words)
+    {
+        int count = 0;
+        for (int i = from; i < words; i++)
+            count += popcount64(set[i]);
+        return count;
+    }
+
+    // target = a & b over words from .. words - 1; true if anything is left
+    bool intersect(uint64_t* target, const uint64_t* a, const uint64_t* b, int from, int words)
+    {
+        uint64_t any = 0;
+        for (int i = from; i < words; i++)
+        {
+            target[i] = a[i] & b[i];
+            any |= target[i];
+        }
+        return any != 0;
+    }
+
+    int intersectCount(const uint64_t* a, const uint64_t* b, int from, int words)
+    {
+        int count = 0;
+        for (int i = from; i < words; i++)
+            count += popcount64(a[i] & b[i]);
+        return count;
+    }
+
+    // Index of each vertex with the last one removed in smallest-last order
+    // numbered 0, so the densest core comes first
+    vector<int> coreFirstIndex(const Graph& graph, int& degeneracy)
+    {
+        vector<int> order = degeneracyOrder(graph, degeneracy);
+        vector<int> index(graph.numVertices);
+        for (int i = 0; i < graph.numVertices; i++)
+            index[order[i]] = graph.numVertices - 1 - i;
+        return index;
+    }
+
+    // Position of each vertex in smallest-last order; every vertex has at
+    // most degeneracy neighbours after it
+    vector<int> removalIndex(const Graph& graph, int& degeneracy)
+    {
+        vector<int> order = degeneracyOrder(graph, degeneracy);
+        vector<int> index(graph.numVertices);
+        for (int i = 0; i < graph.numVertices; i++)
+            index[order[i]] = i;
+        return index;
+    }
+
+    class CliqueSearch
+    {
+    public:
+        // No clique, and so no search path, is longer than maxDepth; the
+        // buffers for every depth are made up front so none of them moves
+        CliqueSearch(const BitRows& rows, int maxDepth, const CancelToken* cancel)
+            : m_rows(rows), m_words(rows.words), m_cancel(cancel), m_levels(maxDepth + 1, vector<uint64_t>(rows.words)),
+              m_uncoloured(maxDepth + 1, vector<uint64_t>(rows.words)), m_vertices(maxDepth + 1), m_colours(maxDepth + 1)
+        {
+        }
+
+        // Best clique found by growing from each of the first vertices, always
+        // taking the lowest numbered candidate
+        void greedy()
+        {
+            vector<uint64_t> candidates(m_words);
+            for (int start = 0; start < min(m_rows.size, greedyStarts); start++)
+            {
+                vector<int> clique = {start};
+                copy(m_rows.row(start), m_rows.row(start) + m_words, candidates.begin());
+                for (int i = 0; i < m_words; i++)
+                {
+                    while (candidates[i] != 0)
+                    {
+                        int v = i * 64 + lowestBit(candidates[i]);
+                        clique.push_back(v);
+                        intersect(candidates.data(), candidates.data(), m_rows.row(v), i, m_words);
+                    }
+                }
+                if (clique.size() > m_best.size())
+                    m_best = clique;
+            }
+        }
+
+        // Exact search over all vertices; false if cancelled
+        bool run()
+        {
+            for (int v = 0; v < m_rows.size; v++)
+                m_levels[0][v >> 6] |= bitOf(v & 63);
+            expand(0);
+            return !m_stopped;
+        }
+
+        const vector<int>& best() const { return m_best; }
+
+    private:
+        // Greedy colouring of the candidates, lowest numbered first, into
+        // independent sets; a candidate coloured k is in no clique of more
+        // than k candidates. Only those whose colour could still lift the
+        // clique past the best are kept to branch on, in colour order.
+        void colourCandidates(int depth)
+        {
+            const vector<uint64_t>& candidates = m_levels[depth];
+            vector<uint64_t>& uncoloured = m_uncoloured[depth];
+            vector<int>& vertices = m_vertices[depth];
+            vector<int>& colours = m_colours[depth];
+            vertices.clear();
+            colours.clear();
+            uncoloured = candidates;
+            int minColour = max(1, (int)m_best.size() - (int)m_current.size() + 1);
+
+            int first = 0;
+            for (int colour = 1;; colour++)
+            {
+                while (first < m_words && uncoloured[first] == 0)
+                    first++;
+                if (first == m_words)
+                    break;
+
+                // One colour class: each pick rules out its neighbours
+                m_class.assign(uncoloured.begin(), uncoloured.end());
+                for (int i = first; i < m_words; i++)
+                {
+                    while (m_class[i] != 0)
+                    {
+                        int v = i * 64 + lowestBit(m_class[i]);
+                        uint64_t bit = bitOf(v & 63);
+                        uncoloured[i] &= ~bit;
+                        m_class[i] &= ~bit;
+                        const uint64_t* row = m_rows.row(v);
+                        for (int j = i; j < m_words; j++)
+                            m_class[j] &= ~row[j];
+                        if (colour >= minColour)
+                        {
+                            vertices.push_back(v);
+                            colours.push_back(colour);
+                        }
+                    }
+                }
+            }
+        }
+
+        void expand(int depth)
+        {
+            if (++m_nodes % nodesPerCancelCheck == 0 && m_cancel != nullptr && m_cancel->cancelled())
+            {
+                m_stopped = true;
+                return;
+            }
+
+            colourCandidates(depth);
+            for (int i = (int)m_vertices[depth].size() - 1; i >= 0 && !m_stopped; i--)
+            {
+                // Colours only fall from here on
+                if (m_current.size() + m_colours[depth][i] <= m_best.size())
+                    return;
+
+                int v = m_vertices[depth][i];
+                m_current.push_back(v);
+                if (intersect(m_levels[depth + 1].data(), m_levels[depth].data(), m_rows.row(v), 0, m_words))
+                    expand(depth + 1);
+                else if (m_current.size() > m_best.size())
+                    m_best = m_current;
+                m_current.pop_back();
+                m_levels[depth][v >> 6] &= ~bitOf(v & 63);
+            }
+        }
+
+        const BitRows& m_rows;
+        int m_words;
+        const CancelToken* m_cancel;
+        vector<vector<uint64_t>> m_levels;     // candidates at each depth
+        vector<vector<uint64_t>> m_uncoloured; // colouring scratch at each depth
+        vector<vector<int>> m_vertices;        // candidates to branch on at each depth
+        vector<vector<int>> m_colours;         // and their colours
+        vector<uint64_t> m_class;
+        vector<int> m_current;
+        vector<int> m_best;
+        long long m_nodes = 0;
+        bool m_stopped = false;
+    };
+
+    // Bron-Kerbosch with candidates P and excluded X at each depth
+    class MaximalCliqueCounter
+    {
+    public:
+        MaximalCliqueCounter(const BitRows& rows, int maxDepth, long long limit, const CancelToken* cancel)
+            : m_rows(rows), m_words(rows.words), m_limit(limit), m_cancel(cancel), m_candidates(maxDepth + 1, vector<uint64_t>(rows.words)),
+              m_excluded(maxDepth + 1, vector<uint64_t>(rows.words)), m_branches(maxDepth + 1, vector<uint64_t>(rows.words))
+        {
+        }
+
+        // Every maximal clique whose first vertex in smallest-last order is v:
+        // P is the neighbours after v, X those before it (Eppstein, Loffler
+        // and Strash), so P never holds more than degeneracy vertices
+        void countFrom(int v)
+        {
+            const uint64_t* row = m_rows.row(v);
+            for (int i = 0; i < m_words; i++)
+            {
+                uint64_t later = i > (v >> 6) ? ~(uint64_t)0 : i < (v >> 6) ? 0 : ~((bitOf(v & 63) << 1) - 1);
+                m_candidates[0][i] = row[i] & later;
+                m_excluded[0][i] = row[i] & ~later;
+            }
+            expand(0);
+        }
+
+        long long count() const { return m_count; }
+        bool stopped() const { return m_stopped; }
+
+    private:
+        void expand(int depth)
+        {
+            if (m_stopped)
+                return;
+            if (++m_nodes % nodesPerCancelCheck == 0 && m_cancel != nullptr && m_cancel->cancelled())
+            {
+                m_stopped = true;
+                return;
+            }
+
+            vector<uint64_t>& candidates = m_candidates[depth];
+            vector<uint64_t>& excluded = m_excluded[depth];
+            if (isEmpty(candidates.data(), 0, m_words))
+            {
+                if (isEmpty(excluded.data(), 0, m_words) && ++m_count >= m_limit)
+                    m_stopped = true;
+                return;
+            }
+
+            // Tomita's pivot: the vertex of P or X with the most neighbours in
+            // P; only the candidates outside its neighbourhood are branched on
+            int pivot = -1, pivotCount = -1;
+            for (const vector<uint64_t>* set : {&candidates, &excluded})
+            {
+                for (int i = 0; i < m_words; i++)
+                {
+                    for (uint64_t bits = (*set)[i]; bits != 0; bits &= bits - 1)
+                    {
+                        int u = i * 64 + lowestBit(bits);
+                        int count = intersectCount(candidates.data(), m_rows.row(u), 0, m_words);
+                        if (count > pivotCount)
+                        {
+                            pivot = u;
+                            pivotCount = count;
+                        }
+                    }
+                }
+            }
+
+            vector<uint64_t>& branches = m_branches[depth];
+            const uint64_t* pivotRow = m_rows.row(pivot);
+            for (int i = 0; i < m_words; i++)
+                branches[i] = candidates[i] & ~pivotRow[i];
+            for (int i = 0; i < m_words && !m_stopped; i++)
+            {
+                for (uint64_t bits = branches[i]; bits != 0; bits &= bits - 1)
+                {
+                    int v = i * 64 + lowestBit(bits);
+                    const uint64_t* row = m_rows.row(v);
+                    intersect(m_candidates[depth + 1].data(), candidates.data(), row, 0, m_words);
+                    intersect(m_excluded[depth + 1].data(), excluded.data(), row, 0, m_words);
+                    expand(depth + 1);
+                    if (m_stopped)
+                        return;
+                    candidates[i] &= ~bitOf(v & 63);
+                    excluded[i] |= bitOf(v & 63);
+                }
+            }
+        }
+
+        const BitRows& m_rows;
+        int m_words;
+        long long m_limit;
+        const CancelToken* m_cancel;
+        vector<vector<uint64_t>> m_candidates;
+        vector<vector<uint64_t>> m_excluded;
+        vector<vector<uint64_t>> m_branches;
+        long long m_count = 0;
+        long long m_nodes = 0;
+        bool m_stopped = false;
+    };
+
+    // Adds the cliques grown from the current one, whose common forward
+    // neighbours are candidates, to counts; levels holds a buffer per size
+    void growCliques(const BitRows& rows, const uint64_t* candidates, int from, int size, int maxSize, vector<vector<uint64_t>>& levels,
+                     vector<long long>& counts)
+    {
+        counts[size + 1] += countBits(candidates, from, rows.words);
+        if (size + 1 == maxSize)
+            return;
+        uint64_t* next = levels[size + 1].data();
+        for (int i = from; i < rows.words; i++)
+        {
+            for (uint64_t bits = candidates[i]; bits != 0; bits &= bits - 1)
+            {
+                int v = i * 64 + lowestBit(bits);
+                if (size + 2 == maxSize)
+                    counts[size + 2] += intersectCount(candidates, rows.row(v), v >> 6, rows.words);
+                else if (intersect(next, candidates, rows.row(v), v >> 6, rows.words))
+                    growCliques(rows, next, v >> 6, size + 1, maxSize, levels, counts);
+            }
+        }
+    }
+}
+
+vector<int> degeneracyOrder(const Graph& graph, int& degeneracy)
+{
+    // Batagelj and Zaversnik's bucket arrays: vertices sorted by current
+    // degree, bucketStart[d] the first position of degree d
+    int n = graph.numVertices;
+    vector<int> degree(n);
+    int maxDegree = 0;
+    for (int v = 0; v < n; v++)
+    {
+        degree[v] = graph.degree(v);
+        maxDegree = max(maxDegree, degree[v]);
+    }
+    vector<int> bucketStart(maxDegree + 2, 0);
+    for (int v = 0; v < n; v++)
+        bucketStart[degree[v] + 1]++;
+    for (int d = 0; d <= maxDegree; d++)
+        bucketStart[d + 1] += bucketStart[d];
+    vector<int> order(n), position(n);
+    {
+        vector<int> next(bucketStart.begin(), bucketStart.end() - 1);
+        for (int v = 0; v < n; v++)
+        {
+            position[v] = next[degree[v]]++;
+            order[position[v]] = v;
+        }
+    }
+
+    degeneracy = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int v = order[i];
+        degeneracy = max(degeneracy, degree[v]);
+        graph.forEachNeighbour(v, [&](int u) {
+            if (degree[u] <= degree[v])
+                return;
+            // Move u to the front of its bucket, then shrink the bucket past it
+            int d = degree[u];
+            int front = bucketStart[d];
+            int w = order[front];
+            if (w != u)
+            {
+                swap(order[front], order[position[u]]);
+                position[w] = position[u];
+                position[u] = front;
+            }
+            bucketStart[d]++;
+            degree[u]--;
+        });
+    }
+    return order;
+}
+
+bool maximumClique(const Graph& graph, vector<int>& clique, const CancelToken* cancel)
+{
+    clique.clear();
+    if (graph.numVertices > cliqueVertexLimit)
+        return false;
+    if (graph.numVertices == 0)
+        return true;
+
+    int degeneracy = 0;
+    vector<int> index = coreFirstIndex(graph, degeneracy);
+    vector<int> vertexAt(graph.numVertices);
+    for (int v = 0; v < graph.numVertices; v++)
+        vertexAt[index[v]] = v;
+    BitRows rows = bitRows(graph, index, false);
+
+    CliqueSearch search(rows, degeneracy + 2, cancel);
+    search.greedy();
+    bool complete = true;
+    if ((int)search.best().size() <= degeneracy)
+        complete = search.run();
+
+    for (int v : search.best())
+        clique.push_back(vertexAt[v]);
+    sort(clique.begin(), clique.end());
+    return complete;
+}
+
+long long countTriangles(const Graph& graph)
+{
+    // Each triangle is found once, from its first vertex in smallest-last
+    // order, whose later neighbours number at most the degeneracy
+    int n = graph.numVertices;
+    int degeneracy = 0;
+    vector<int> index = removalIndex(graph, degeneracy);
+    vector<int> forwardOffsets(n + 1, 0), forward;
+    for (int v = 0; v < n; v++)
+    {
+        graph.forEachNeighbour(v, [&](int w) {
+            if (index[w] > index[v])
+                forward.push_back(w);
+        });
+        forwardOffsets[v + 1] = (int)forward.size();
+    }
+
+    int workers = workerCount();
+    vector<long long> counts(workers, 0);
+    vector<vector<char>> marks(workers);
+    parallelFor(n, [&](int begin, int end, int worker) {
+        vector<char>& marked = marks[worker];
+        marked.resize(n, 0);
+        long long count = 0;
+        for (int v = begin; v < end; v++)
+        {
+            for (int i = forwardOffsets[v]; i < forwardOffsets[v + 1]; i++)
+                marked[forward[i]] = 1;
+            for (int i = forwardOffsets[v]; i < forwardOffsets[v + 1]; i++)
+            {
+                int u = forward[i];
+                for (int j = forwardOffsets[u]; j < forwardOffsets[u + 1]; j++)
+                    count += marked[forward[j]];
+            }
+            for (int i = forwardOffsets[v]; i < forwardOffsets[v + 1]; i++)
+                marked[forward[i]] = 0;
+        }
+        counts[worker] += count;
+    }, 1024);
+
+    long long total = 0;
+    for (long long count : counts)
+        total += count;
+    return total;
+}
+
+bool countCliques(const Graph& graph, int maxSize, vector<long long>& counts, const CancelToken* cancel)
+{
+    counts.assign(max(maxSize, 0) + 1, 0);
+    if (graph.numVertices > cliqueVertexLimit)
+        return false;
+    counts[0] = 1;
+    if (maxSize >= 1)
+        counts[1] = graph.numVertices;
+    if (maxSize < 2)
+        return true;
+
+    int degeneracy = 0;
+    vector<int> index = removalIndex(graph, degeneracy);
+    BitRows rows = bitRows(graph, index, true);
+
+    int workers = workerCount();
+    vector<vector<long long>> workerCounts(workers, vector<long long>(maxSize + 1, 0));
+    parallelFor(graph.numVertices, [&](int begin, int end, int worker) {
+        vector<vector<uint64_t>> levels(maxSize + 1, vector<uint64_t>(rows.words));
+        for (int v = begin; v < end; v++)
+        {
+            if (cancel != nullptr && cancel->cancelled())
+                return;
+            growCliques(rows, rows.row(v), v >> 6, 1, maxSize, levels, workerCounts[worker]);
+        }
+    }, 16);
+    if (cancel != nullptr && cancel->cancelled())
+        return false;
+
+    for (const vector<long long>& partial : workerCounts)
+    {
+        for (int k = 2; k <= maxSize; k++)
+            counts[k] += partial[k];
+    }
+    return true;
+}
+
+bool countMaximalCliques(const Graph& graph, long long limit, long long& count, const CancelToken* cancel)
+{
+    count = 0;
+    if (graph.numVertices > cliqueVertexLimit)
+        return false;
+
+    int degeneracy = 0;
+    vector<int> index = removalIndex(graph, degeneracy);
+    BitRows rows = bitRows(graph, index, false);
+    MaximalCliqueCounter counter(rows, degeneracy + 2, limit, cancel);
+    for (int v = 0; v < graph.numVertices && !counter.stopped(); v++)
+        counter.countFrom(v);
+    count = counter.count();
+    return !counter.stopped() || count >= limit;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+
+#include "cancel.hpp"
+#include "graph.hpp"
+
+// Largest graph the clique searches take on. They keep a bit row of
+// neighbours per vertex, n^2 / 8 bytes in all.
+const int cliqueVertexLimit = 20000;
+
+// Maximal cliques counted in the analysis report before giving up; dense
+// graphs have exponentially many
+const long long maximalCliqueLimit = 1000000;
+
+// Smallest-last order (Matula and Beck): repeatedly remove a vertex of
+// minimum degree, in O(V + E). Returns the vertices in removal order and
+// sets degeneracy to the largest degree seen at removal, so no clique has
+// more than degeneracy + 1 vertices.
+std::vector<int> degeneracyOrder(const Graph& graph, int& degeneracy);
+
+// Maximum clique by branch and bound over bit rows (San Segundo's BBMC):
+// vertices are renumbered highest core first, and each node greedily colours
+// its candidates so that Tomita's colour bound prunes every branch that
+// cannot beat the best clique so far. False if the graph is over
+// cliqueVertexLimit or the token was cancelled; clique then holds the best
+// found so far.
+bool maximumClique(const Graph& graph, std::vector<int>& clique, const CancelToken* cancel = nullptr);
+
+// Triangles, each counted once, by intersecting the neighbours ranked above
+// each vertex along every edge. Works on graphs of any size.
+long long countTriangles(const Graph& graph);
+
+// counts[k] is the number of k-vertex cliques for k up to maxSize (counts[0]
+// is 1, counts[1] the vertices, counts[2] the edges). Each clique is grown
+// through the neighbours ranked above its last vertex, so it is seen once,
+// and the last level is a popcount of an AND of bit rows. False if the
+// graph is over cliqueVertexLimit or the token was cancelled.
+bool countCliques(const Graph& graph, int maxSize, std::vector<long long>& counts, const CancelToken* cancel = nullptr);
+
+// Maximal cliques, by Bron and Kerbosch's algorithm with Tomita's pivot (the
+// vertex with the most candidates among its neighbours). Stops counting at
+// limit. False if the graph is over cliqueVertexLimit or the token was
+// cancelled.
+bool countMaximalCliques(const Graph& graph, long long limit, long long& count, const CancelToken* cancel = nullptr);
@@ -0,0 +1,216 @@
+#include "colouring.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <queue>
+#include <tuple>
+#include <unordered_set>
+
+using namespace std;
+
+namespace
+{
+    // Search nodes between looks at the cancel token
+    const long long nodesPerCancelCheck = 1024;
+
+    class ColouringSearch
+    {
+    public:
+        ColouringSearch(const Graph& graph, const vector<int>& best, const CancelToken* cancel)
+            : m_graph(graph), m_n(graph.numVertices), m_best(best), m_bestCount(colourCount(best)), m_cancel(cancel),
+              m_colours(graph.numVertices, -1), m_saturation(graph.numVertices, 0), m_uncolouredDegree(graph.numVertices),
+              m_stride(m_bestCount), m_adjacent((size_t)graph.numVertices * m_bestCount, 0)
+        {
+            for (int v = 0; v < m_n; v++)
+                m_uncolouredDegree[v] = graph.degree(v);
+        }
+
+        // Colour the clique 0, 1, ... and search the rest; false if stopped
+        // before the best colouring was proved optimal
+        bool run(const vector<int>& clique)
+        {
+            m_lowerBound = max((int)clique.size(), m_n > 0 ? 1 : 0);
+            if (m_graph.numEdges() > 0)
+                m_lowerBound = max(m_lowerBound, 2);
+            if (m_bestCount <= m_lowerBound)
+                return true;
+
+            for (int i = 0; i < (int)clique.size(); i++)
+                assign(clique[i], i);
+            search((int)clique.size(), (int)clique.size());
+            return !m_stopped;
+        }
+
+        const vector<int>& best() const { return m_best; }
+
+    private:
+        int& adjacent(int v, int colour) { return m_adjacent[(size_t)v * m_stride + colour]; }
+
+        void assign(int v, int colour)
+        {
+            m_colours[v] = colour;
+            m_graph.forEachNeighbour(v, [&](int w) {
+                if (adjacent(w, colour)++ == 0)
+                    m_saturation[w]++;
+                m_uncolouredDegree[w]--;
+            });
+        }
+
+        void unassign(int v)
+        {
+            int colour = m_colours[v];
+            m_colours[v] = -1;
+            m_graph.forEachNeighbour(v, [&](int w) {
+                if (--adjacent(w, colour) == 0)
+                    m_saturation[w]--;
+                m_uncolouredDegree[w]++;
+            });
+        }
+
+        // Uncoloured vertex with the most distinct neighbour colours, ties to
+        // the most uncoloured neighbours
+        int choose() const
+        {
+            int chosen = -1;
+            for (int v = 0; v < m_n; v++)
+            {
+                if (m_colours[v] != -1)
+                    continue;
+                if (chosen == -1 || m_saturation[v] > m_saturation[chosen] ||
+                    (m_saturation[v] == m_saturation[chosen] && m_uncolouredDegree[v] > m_uncolouredDegree[chosen]))
+                    chosen = v;
+            }
+            return chosen;
+        }
+
+        void search(int coloured, int used)
+        {
+            if (++m_nodes > chromaticNodeLimit ||
+                (m_nodes % nodesPerCancelCheck == 0 && m_cancel != nullptr && m_cancel->cancelled()))
+            {
+                m_stopped = true;
+                return;
+            }
+
+            if (coloured == m_n)
+            {
+                m_best = m_colours;
+                m_bestCount = used;
+                if (m_bestCount <= m_lowerBound)
+                    m_done = true;
+                return;
+            }
+
+            // Colours from 0 up, one new colour at most, and only while the
+            // total stays under the best so far
+            int v = choose();
+            for (int colour = 0; colour <= used && colour < m_bestCount - 1; colour++)
+            {
+                if (adjacent(v, colour) != 0)
+                    continue;
+                assign(v, colour);
+                search(coloured + 1, max(used, colour + 1));
+                unassign(v);
+                if (m_stopped || m_done)
+                    return;
+            }
+        }
+
+        const Graph& m_graph;
+        int m_n;
+        vector<int> m_best;
+        int m_bestCount;
+        const CancelToken* m_cancel;
+        vector<int> m_colours;
+        vector<int> m_saturation;       // distinct colours among the neighbours
+        vector<int> m_uncolouredDegree;
+        int m_stride;                   // colours of the starting colouring
+        vector<int> m_adjacent;         // neighbours of each vertex in each colour
+        int m_lowerBound = 0;
+        long long m_nodes = 0;
+        bool m_stopped = false;
+        bool m_done = false;
+    };
+}
+
+vector<int> dsaturColouring(const Graph& graph)
+{
+    int n = graph.numVertices;
+    vector<int> colours(n, -1), saturation(n, 0);
+
+    // (vertex, colour) pairs for every colour next to an uncoloured vertex
+    unordered_set<uint64_t> seen;
+    seen.reserve(graph.neighbours.size());
+    auto key = [](int v, int colour) { return (uint64_t)v << 32 | (uint32_t)colour; };
+
+    // Entries go stale when a vertex's saturation rises; the newer entry comes
+    // out first and the stale one is skipped later
+    priority_queue<tuple<int, int, int>> queue;
+    for (int v = 0; v < n; v++)
+        queue.emplace(0, graph.degree(v), -v);
+
+    vector<int> seenBy(n + 1, -1);
+    while (!queue.empty())
+    {
+        auto [entrySaturation, degree, negated] = queue.top();
+        queue.pop();
+        int v = -negated;
+        if (colours[v] != -1 || entrySaturation != saturation[v])
+            continue;
+
+        graph.forEachNeighbour(v, [&](int w) {
+            if (colours[w] != -1)
+                seenBy[colours[w]] = v;
+        });
+        int colour = 0;
+        while (seenBy[colour] == v)
+            colour++;
+        colours[v] = colour;
+
+        graph.forEachNeighbour(v, [&](int w) {
+            if (colours[w] == -1 && seen.insert(key(w, colour)).second)
+            {
+                saturation[w]++;
+                queue.emplace(saturation[w], graph.degree(w), -w);
+            }
+        });
+    }
+    return colours;
+}
+
+int colourCount(const vector<int>& colours)
+{
+    int count = 0;
+    for (int colour : colours)
+        count = max(count, colour + 1);
+    return count;
+}
+
+bool isProperColouring(const Graph& graph, const vector<int>& colours)
+{
+    if ((int)colours.size() != graph.numVertices)
+        return false;
+    for (int v = 0; v < graph.numVertices; v++)
+    {
+        if (colours[v] < 0)
+            return false;
+        for (const int* w = graph.neighboursBegin(v); w != graph.neighboursEnd(v); ++w)
+        {
+            if (colours[*w] == colours[v])
+                return false;
+        }
+    }
+    return true;
+}
+
+bool chromaticColouring(const Graph& graph, const vector<int>& clique, vector<int>& colours, const CancelToken* cancel)
+{
+    colours = dsaturColouring(graph);
+    if (graph.numVertices > chromaticVertexLimit)
+        return false;
+
+    ColouringSearch search(graph, colours, cancel);
+    bool proved = search.run(clique);
+    colours = search.best();
+    return proved;
+}
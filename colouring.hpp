@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+#include "cancel.hpp"
+#include "graph.hpp"
+
+// Largest graph the exact colouring search takes on
+const int chromaticVertexLimit = 200;
+
+// Search nodes the exact colouring tries before settling for the best found
+const long long chromaticNodeLimit = 20000000;
+
+// Brelaz's DSATUR: repeatedly colour the uncoloured vertex seeing the most
+// distinct colours among its neighbours (ties to the higher degree) with the
+// smallest colour none of them has. Proper, usually close to optimal, and
+// O((V + E) log V). Colours are numbered from 0.
+std::vector<int> dsaturColouring(const Graph& graph);
+
+// Number of colours in a colouring, the largest colour plus one
+int colourCount(const std::vector<int>& colours);
+
+// Whether no edge joins two vertices of the same colour
+bool isProperColouring(const Graph& graph, const std::vector<int>& colours);
+
+// Exact chromatic number by DSATUR branch and bound. The search starts from
+// the DSATUR colouring as the bound to beat, with the vertices of clique (a
+// maximum clique if known, or empty) fixed to distinct colours both as the
+// lower bound and to break colour symmetry. colours gets the best colouring
+// found. True when it is proved optimal; false if the graph is over
+// chromaticVertexLimit, the node limit was reached or the token cancelled.
+bool chromaticColouring(const Graph& graph, const std::vector<int>& clique, std::vector<int>& colours, const CancelToken* cancel = nullptr);
@@ -0,0 +1,129 @@
+#include "connectivity.hpp"
+
+#include <utility>
+
+using namespace std;
+
+IncrementalConnectivity::IncrementalConnectivity(int capacity)
+{
+    reset(capacity);
+}
+
+void IncrementalConnectivity::reset(int capacity)
+{
+    m_parent.resize(capacity);
+    m_rank.assign(capacity, 0);
+    m_parity.assign(capacity, 0);
+    for (int v = 0; v < capacity; v++)
+        m_parent[v] = v;
+    m_history.clear();
+    m_vertices = 0;
+    m_components = 0;
+    m_oddCycleEdges = 0;
+}
+
+void IncrementalConnectivity::addVertex()
+{
+    if (m_vertices == (int)m_parent.size())
+    {
+        m_parent.push_back(m_vertices);
+        m_rank.push_back(0);
+        m_parity.push_back(0);
+    }
+    m_vertices++;
+    m_components++;
+}
+
+int IncrementalConnectivity::find(int v, int& parity) const
+{
+    parity = 0;
+    while (m_parent[v] != v)
+    {
+        parity ^= m_parity[v];
+        v = m_parent[v];
+    }
+    return v;
+}
+
+void IncrementalConnectivity::addEdge(int u, int v)
+{
+    int parityU, parityV;
+    int rootU = find(u, parityU);
+    int rootV = find(v, parityV);
+
+    Change change = {-1, -1, false, false};
+    if (rootU == rootV)
+    {
+        // Both ends already joined: equal parity means an odd cycle (a loop
+        // included, as u and v are then the same vertex)
+        change.oddCycle = parityU == parityV;
+        if (change.oddCycle)
+            m_oddCycleEdges++;
+    }
+    else
+    {
+        if (m_rank[rootU] < m_rank[rootV])
+            swap(rootU, rootV);
+        change.child = rootV;
+        change.parent = rootU;
+        change.rankRaised = m_rank[rootU] == m_rank[rootV];
+
+        // Give u and v opposite parities across the new link
+        m_parent[rootV] = rootU;
+        m_parity[rootV] = (char)(parityU ^ parityV ^ 1);
+        if (change.rankRaised)
+            m_rank[rootU]++;
+        m_components--;
+    }
+    m_history.push_back(change);
+}
+
+void IncrementalConnectivity::undoEdge()
+{
+    if (m_history.empty())
+        return;
+
+    Change change = m_history.back();
+    m_history.pop_back();
+    if (change.oddCycle)
+        m_oddCycleEdges--;
+    if (change.child != -1)
+    {
+        m_parent[change.child] = change.child;
+        m_parity[change.child] = 0;
+        if (change.rankRaised)
+            m_rank[change.parent]--;
+        m_components++;
+    }
+}
+
+bool IncrementalConnectivity::restore(int vertices, int capacity, const int* parents, const int* ranks, const char* parities, int oddCycleEdges)
+{
+    if (vertices < 0 || vertices > capacity || oddCycleEdges < 0)
+        return false;
+    int components = 0;
+    for (int v = 0; v < capacity; v++)
+    {
+        int parent = parents[v];
+        if (parent < 0 || parent >= capacity || (parent != v && (ranks[parent] <= ranks[v] || v >= vertices || parent >= vertices)) ||
+            ranks[v] < 0 || ranks[v] > 31 || (parities[v] != 0 && parities[v] != 1))
+            return false;
+        if (parent == v && v < vertices)
+            components++;
+    }
+
+    m_parent.assign(parents, parents + capacity);
+    m_rank.assign(ranks, ranks + capacity);
+    m_parity.assign(parities, parities + capacity);
+    m_history.clear();
+    m_vertices = vertices;
+    m_components = components;
+    m_oddCycleEdges = oddCycleEdges;
+    return true;
+}
+
+bool IncrementalConnectivity::connected(int u, int v) const
+{
+    int parityU, parityV;
+    return find(u, parityU) == find(v, parityV);
+}
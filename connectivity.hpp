@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+
+// Live component count and bipartite check for the graph being drawn.
+// Union-find where every vertex also stores the parity of its link to its
+// parent, so an edge joining two vertices of equal parity in one component
+// closes an odd cycle. Union by rank without path compression keeps finds at
+// O(log n) and leaves exactly one change per edge to take back on undo.
+class IncrementalConnectivity
+{
+public:
+    explicit IncrementalConnectivity(int capacity = 0);
+
+    // Forget every vertex and edge, making room for capacity vertices
+    void reset(int capacity);
+
+    // Vertices are numbered in the order they are added
+    void addVertex();
+    void addEdge(int u, int v);
+
+    // Take back the most recent addEdge
+    void undoEdge();
+
+    int componentCount() const { return m_components; }
+    bool bipartite() const { return m_oddCycleEdges == 0; }
+    bool connected(int u, int v) const;
+
+    // The forest as plain arrays, one entry per vertex of the capacity, so a
+    // saved session can put it back without replaying every edge
+    const std::vector<int>& parents() const { return m_parent; }
+    const std::vector<int>& ranks() const { return m_rank; }
+    const std::vector<char>& parities() const { return m_parity; }
+    int oddCycleEdges() const { return m_oddCycleEdges; }
+
+    // Take the forest from saved arrays of capacity entries, with the first
+    // vertices placed. Edges restored this way cannot be undone. False, with
+    // nothing changed, unless every rank is below its parent's, which keeps
+    // the forest free of cycles.
+    bool restore(int vertices, int capacity, const int* parents, const int* ranks, const char* parities, int oddCycleEdges);
+
+private:
+    // Root of v and the parity of the path up to it
+    int find(int v, int& parity) const;
+
+    // What one addEdge changed
+    struct Change
+    {
+        int child;       // root linked under another root, or -1
+        int parent;      // the root it was linked under
+        bool rankRaised; // whether parent's rank went up
+        bool oddCycle;   // whether the edge closed an odd cycle
+    };
+
+    std::vector<int> m_parent;
+    std::vector<int> m_rank;
+    std::vector<char> m_parity; // parity of the link to the parent
+    std::vector<Change> m_history;
+    int m_vertices = 0;
+    int m_components = 0;
+    int m_oddCycleEdges = 0;
+};
@@ -0,0 +1,313 @@
+#include "crossings.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <map>
+#include <set>
+
+using namespace std;
+using namespace sf;
+
+namespace
+{
+    // Relative precision of the tests. Coordinates are compared within
+    // epsilon times the largest coordinate, not an absolute amount that is
+    // lost in the rounding of pixel-scale floats.
+    const double epsilon = 1e-9;
+
+    struct Point
+    {
+        double x, y;
+    };
+
+    // Tolerance for coordinates of the given segment ends and extra points
+    double coordinateTolerance(const vector<Vector2f>& segmentEnds, std::initializer_list<Vector2f> extra = {})
+    {
+        double scale = 1.0;
+        for (Vector2f point : segmentEnds)
+            scale = max(scale, max(fabs((double)point.x), fabs((double)point.y)));
+        for (Vector2f point : extra)
+            scale = max(scale, max(fabs((double)point.x), fabs((double)point.y)));
+        return epsilon * scale;
+    }
+
+    // Event order: left to right, then bottom to top
+    bool pointLess(const Point& a, const Point& b, double tolerance)
+    {
+        if (fabs(a.x - b.x) > tolerance)
+            return a.x < b.x;
+        if (fabs(a.y - b.y) > tolerance)
+            return a.y < b.y;
+        return false;
+    }
+
+    bool samePoint(const Point& a, const Point& b, double tolerance)
+    {
+        return !pointLess(a, b, tolerance) && !pointLess(b, a, tolerance);
+    }
+
+    struct PointLess
+    {
+        double tolerance;
+        bool operator()(const Point& a, const Point& b) const { return pointLess(a, b, tolerance); }
+    };
+
+    // Segment stored with its endpoints in event order
+    struct Segment
+    {
+        Point left, right;
+        double slope; // infinity for vertical segments
+    };
+
+    // Current position of the sweep line
+    struct Sweep
+    {
+        const vector<Segment>* segments;
+        Point point;
+        double tolerance;
+
+        // Height of a segment on the sweep line. Vertical segments sit at the
+        // event point itself, clamped to their extent.
+        double heightOf(int s) const
+        {
+            const Segment& segment = (*segments)[s];
+            if (isinf(segment.slope))
+                return min(max(point.y, segment.left.y), segment.right.y);
+            return segment.left.y + (point.x - segment.left.x) * segment.slope;
+        }
+    };
+
+    // Height searched for when looking up the segments through an event point
+    struct Probe
+    {
+        double y;
+    };
+
+    // Status order: by height on the sweep line, ties broken by slope so that
+    // segments through the current event point come out in their order just
+    // to the right of it
+    struct StatusLess
+    {
+        using is_transparent = void;
+        const Sweep* sweep;
+
+        bool operator()(int a, int b) const
+        {
+            double heightA = sweep->heightOf(a);
+            double heightB = sweep->heightOf(b);
+            if (fabs(heightA - heightB) > sweep->tolerance)
+                return heightA < heightB;
+            double slopeA = (*sweep->segments)[a].slope;
+            double slopeB = (*sweep->segments)[b].slope;
+            if (slopeA != slopeB)
+                return slopeA < slopeB;
+            return a < b;
+        }
+        bool operator()(int a, Probe probe) const { return sweep->heightOf(a) < probe.y - sweep->tolerance; }
+        bool operator()(Probe probe, int a) const { return probe.y + sweep->tolerance < sweep->heightOf(a); }
+    };
+
+    bool parallel(const Segment& a, const Segment& b)
+    {
+        double ax = a.right.x - a.left.x, ay = a.right.y - a.left.y;
+        double bx = b.right.x - b.left.x, by = b.right.y - b.left.y;
+        double scale = sqrt((ax * ax + ay * ay) * (bx * bx + by * by));
+        return fabs(ax * by - ay * bx) <= epsilon * scale;
+    }
+
+    // Intersection point of two non-parallel segments, if they meet. The
+    // parameters along both segments are unitless, so epsilon applies as is.
+    bool intersect(const Segment& a, const Segment& b, Point& point)
+    {
+        if (parallel(a, b))
+            return false;
+
+        double ax = a.right.x - a.left.x, ay = a.right.y - a.left.y;
+        double bx = b.right.x - b.left.x, by = b.right.y - b.left.y;
+        double denominator = ax * by - ay * bx;
+        double cx = b.left.x - a.left.x, cy = b.left.y - a.left.y;
+        double t = (cx * by - cy * bx) / denominator;
+        double u = (cx * ay - cy * ax) / denominator;
+        if (t < -epsilon || t > 1.0 + epsilon || u < -epsilon || u > 1.0 + epsilon)
+            return false;
+
+        point.x = a.left.x + t * ax;
+        point.y = a.left.y + t * ay;
+        return true;
+    }
+
+    // Segment from two points, or false for a zero length segment
+    bool makeSegment(Vector2f start, Vector2f end, double tolerance, Segment& segment)
+    {
+        Point a = {start.x, start.y};
+        Point b = {end.x, end.y};
+        if (samePoint(a, b, tolerance))
+            return false;
+        if (pointLess(b, a, tolerance))
+            swap(a, b);
+
+        segment.left = a;
+        segment.right = b;
+        segment.slope = fabs(b.x - a.x) <= tolerance ? INFINITY : (b.y - a.y) / (b.x - a.x);
+        return true;
+    }
+}
+
+long long countCrossings(const vector<Vector2f>& segmentEnds)
+{
+    double tolerance = coordinateTolerance(segmentEnds);
+    vector<Segment> segments;
+    segments.reserve(segmentEnds.size() / 2);
+    for (size_t i = 0; i + 1 < segmentEnds.size(); i += 2)
+    {
+        Segment segment;
+        if (makeSegment(segmentEnds[i], segmentEnds[i + 1], tolerance, segment))
+            segments.push_back(segment);
+    }
+
+    // Event queue: each point with the segments that start there
+    map<Point, vector<int>, PointLess> events(PointLess{tolerance});
+    for (int s = 0; s < (int)segments.size(); s++)
+    {
+        events[segments[s].left].push_back(s);
+        events[segments[s].right];
+    }
+
+    Sweep sweep = {&segments, {0.0, 0.0}, tolerance};
+    set<int, StatusLess> status(StatusLess{&sweep});
+    vector<set<int, StatusLess>::iterator> where(segments.size(), status.end());
+
+    auto findEvent = [&](int a, int b, const Point& after)
+    {
+        Point point;
+        if (intersect(segments[a], segments[b], point) && pointLess(after, point, tolerance))
+            events[point];
+    };
+
+    long long crossings = 0;
+    vector<int> through, reinsert;
+    vector<pair<double, bool>> directions;
+    while (!events.empty())
+    {
+        Point point = events.begin()->first;
+        vector<int> starting = move(events.begin()->second);
+        events.erase(events.begin());
+        sweep.point = point;
+
+        // Segments already in the status that pass through or end at this point
+        auto range = status.equal_range(Probe{point.y});
+        through.assign(range.first, range.second);
+
+        // Count the pairs meeting here, except pairs that both end here (a
+        // shared vertex) and pairs running in the same direction (overlaps)
+        if (starting.size() + through.size() > 1)
+        {
+            directions.clear();
+            for (int s : starting)
+                directions.push_back(make_pair(segments[s].slope, true));
+            for (int s : through)
+                directions.push_back(make_pair(segments[s].slope, samePoint(segments[s].right, point, tolerance)));
+            sort(directions.begin(), directions.end());
+
+            auto pairsMeeting = [](long long inside, long long ends)
+            {
+                return inside * (inside - 1) / 2 + inside * ends;
+            };
+
+            long long inside = 0, ends = 0;
+            for (const auto& direction : directions)
+                (direction.second ? ends : inside)++;
+            crossings += pairsMeeting(inside, ends);
+
+            for (size_t i = 0; i < directions.size();)
+            {
+                size_t j = i;
+                long long groupInside = 0, groupEnds = 0;
+                while (j < directions.size() && (directions[j].first == directions[i].first ||
+                       fabs(directions[j].first - directions[i].first) <= epsilon * max(1.0, fabs(directions[i].first))))
+                {
+                    (directions[j].second ? groupEnds : groupInside)++;
+                    j++;
+                }
+                crossings -= pairsMeeting(groupInside, groupEnds);
+                i = j;
+            }
+        }
+
+        // Remove everything through the point, then reinsert the segments that
+        // continue past it in their new order
+        reinsert = starting;
+        for (int s : through)
+        {
+            status.erase(where[s]);
+            where[s] = status.end();
+            if (!samePoint(segments[s].right, point, tolerance))
+                reinsert.push_back(s);
+        }
+        for (int s : reinsert)
+            where[s] = status.insert(s).first;
+
+        if (reinsert.empty())
+        {
+            auto above = status.lower_bound(Probe{point.y});
+            if (above != status.end() && above != status.begin())
+                findEvent(*prev(above), *above, point);
+        }
+        else
+        {
+            auto lowest = status.lower_bound(Probe{point.y});
+            auto above = status.upper_bound(Probe{point.y});
+            if (lowest != status.begin())
+                findEvent(*prev(lowest), *lowest, point);
+            if (above != status.end())
+                findEvent(*prev(above), *above, point);
+        }
+    }
+
+    return crossings;
+}
+
+long long countCrossingsWith(const vector<Vector2f>& segmentEnds, Vector2f start, Vector2f end)
+{
+    double tolerance = coordinateTolerance(segmentEnds, {start, end});
+    Segment added;
+    if (!makeSegment(start, end, tolerance, added))
+        return 0;
+
+    long long crossings = 0;
+    for (size_t i = 0; i + 1 < segmentEnds.size(); i += 2)
+    {
+        Segment other;
+        Point point;
+        if (!makeSegment(segmentEnds[i], segmentEnds[i + 1], tolerance, other) || !intersect(added, other, point))
+            continue;
+
+        // Meeting at an endpoint of both segments is a shared vertex, not a crossing
+        bool endOfAdded = samePoint(point, added.left, tolerance) || samePoint(point, added.right, tolerance);
+        bool endOfOther = samePoint(point, other.left, tolerance) || samePoint(point, other.right, tolerance);
+        if (!(endOfAdded && endOfOther))
+            crossings++;
+    }
+    return crossings;
+}
+
+vector<Vector2f> panelSegments(const vector<CircleShape>& panel, const vector<vector<int>>& adjacencyMatrix)
+{
+    vector<Vector2f> segmentEnds;
+    int n = (int)adjacencyMatrix.size();
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = i + 1; j < n; j++)
+        {
+            if (adjacencyMatrix[i][j] > 0)
+            {
+                float radius = panel[i].getRadius();
+                segmentEnds.push_back(panel[i].getPosition() + Vector2f(radius, radius));
+                radius = panel[j].getRadius();
+                segmentEnds.push_back(panel[j].getPosition() + Vector2f(radius, radius));
+            }
+        }
+    }
+    return segmentEnds;
+}
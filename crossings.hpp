@@ -0,0 +1,20 @@
+#pragma once
+
+#include <SFML/Graphics/CircleShape.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <vector>
+
+// Count the pairs of straight segments that cross, using a Bentley-Ottmann
+// sweep in O((E + K) log E). Segments are given as consecutive start/end
+// points. Segments that only touch at a shared endpoint (a shared vertex)
+// and collinear overlaps do not count; an endpoint resting on the inside of
+// another segment does. Zero length segments (loops) are ignored. Points
+// within a billionth of the largest coordinate count as the same point.
+long long countCrossings(const std::vector<sf::Vector2f>& segmentEnds);
+
+// Number of segments crossed by one more segment from start to end, under the
+// same rules. O(E), for keeping a running count while edges are added or undone.
+long long countCrossingsWith(const std::vector<sf::Vector2f>& segmentEnds, sf::Vector2f start, sf::Vector2f end);
+
+// Straight-line edges of a generated panel, one segment per adjacent pair i < j
+std::vector<sf::Vector2f> panelSegments(const std::vector<sf::CircleShape>& panel, const std::vector<std::vector<int>>& adjacencyMatrix);
@@ -0,0 +1,219 @@
+#include "distances.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "bits.hpp"
+#include "parallel.hpp"
+
+using namespace std;
+
+namespace
+{
+    // Sources per batch, one bit each in the search words
+    const int batchSize = 64;
+
+    // Search state for one batch of sources, reused batch after batch by a worker
+    struct BatchSearch
+    {
+        vector<uint64_t> seen;     // sources that have reached each vertex
+        vector<uint64_t> frontier; // sources that reached it on the last level
+        vector<uint64_t> next;     // sources arriving from a frontier neighbour
+        vector<int> current, touched;
+
+        void resize(int n)
+        {
+            seen.assign(n, 0);
+            frontier.assign(n, 0);
+            next.assign(n, 0);
+        }
+    };
+
+    // Vertices in breadth-first order, component by component, so the sources
+    // of a batch lie close together and their searches share frontier vertices
+    vector<int> sourceOrder(const Graph& graph)
+    {
+        int n = graph.numVertices;
+        vector<int> order;
+        order.reserve(n);
+        vector<char> placed(n, 0);
+        for (int start = 0; start < n; start++)
+        {
+            if (placed[start])
+                continue;
+            placed[start] = 1;
+            order.push_back(start);
+            for (size_t head = order.size() - 1; head < order.size(); head++)
+            {
+                int v = order[head];
+                for (const int* it = graph.neighboursBegin(v); it != graph.neighboursEnd(v); ++it)
+                {
+                    if (!placed[*it])
+                    {
+                        placed[*it] = 1;
+                        order.push_back(*it);
+                    }
+                }
+            }
+        }
+        return order;
+    }
+
+    // Breadth-first search from up to 64 sources at once. Each level ORs the
+    // frontier words of a vertex into its neighbours, so one pass over the
+    // frontier edges advances every search. found(vertex, bits, level) is
+    // called with the sources (bit i for sources[i]) first reaching vertex.
+    template <typename Found>
+    void searchBatch(const Graph& graph, const int* sources, int count, BatchSearch& search, Found found)
+    {
+        search.current.clear();
+        for (int i = 0; i < count; i++)
+        {
+            search.seen[sources[i]] = bitOf(i);
+            search.frontier[sources[i]] = bitOf(i);
+            search.current.push_back(sources[i]);
+        }
+
+        for (int level = 1; !search.current.empty(); level++)
+        {
+            search.touched.clear();
+            for (int u : search.current)
+            {
+                uint64_t word = search.frontier[u];
+                for (const int* it = graph.neighboursBegin(u); it != graph.neighboursEnd(u); ++it)
+                {
+                    if (search.next[*it] == 0)
+                        search.touched.push_back(*it);
+                    search.next[*it] |= word;
+                }
+            }
+            for (int u : search.current)
+                search.frontier[u] = 0;
+
+            search.current.clear();
+            for (int w : search.touched)
+            {
+                uint64_t bits = search.next[w] & ~search.seen[w];
+                search.next[w] = 0;
+                if (bits == 0)
+                    continue;
+                search.seen[w] |= bits;
+                search.frontier[w] = bits;
+                search.current.push_back(w);
+                found(w, bits, level);
+            }
+        }
+
+        fill(search.seen.begin(), search.seen.end(), 0);
+    }
+
+    // Run fn(sources, count, search, worker) on every batch of sources in
+    // parallel, stopping early once cancelled
+    template <typename Function>
+    void forEachBatch(const Graph& graph, const CancelToken* cancel, Function fn)
+    {
+        int n = graph.numVertices;
+        vector<int> order = sourceOrder(graph);
+        vector<BatchSearch> searches(workerCount());
+        int batches = (n + batchSize - 1) / batchSize;
+        parallelFor(batches, [&](int begin, int end, int worker)
+        {
+            BatchSearch& search = searches[worker];
+            if (search.seen.empty())
+                search.resize(n);
+            for (int batch = begin; batch < end; batch++)
+            {
+                if (cancel && cancel->cancelled())
+                    return;
+                int first = batch * batchSize;
+                fn(order.data() + first, min(batchSize, n - first), search, worker);
+            }
+        }, 1);
+    }
+}
+
+bool distanceInvariants(const Graph& graph, DistanceInvariants& invariants, const CancelToken* cancel)
+{
+    int n = graph.numVertices;
+    invariants = DistanceInvariants();
+    invariants.eccentricities.assign(n, 0);
+    invariants.distanceHistogram.assign(1, 0);
+
+    // By symmetry the furthest level any search reaches a vertex on is its
+    // eccentricity, so everything is summed per vertex and per worker without
+    // looking at individual source bits
+    int workers = workerCount();
+    vector<vector<int>> furthest(workers);
+    vector<vector<long long>> histograms(workers);
+    vector<long long> reached(workers, 0);
+    forEachBatch(graph, cancel, [&](const int* sources, int count, BatchSearch& search, int worker)
+    {
+        vector<int>& far = furthest[worker];
+        vector<long long>& histogram = histograms[worker];
+        if (far.empty())
+            far.assign(n, 0);
+        searchBatch(graph, sources, count, search, [&](int v, uint64_t bits, int level)
+        {
+            int found = popcount64(bits);
+            far[v] = max(far[v], level);
+            if ((int)histogram.size() <= level)
+                histogram.resize(level + 1, 0);
+            histogram[level] += found;
+            reached[worker] += found;
+        });
+    });
+    if (cancel && cancel->cancelled())
+        return false;
+
+    long long orderedPairs = 0;
+    for (int worker = 0; worker < workers; worker++)
+    {
+        orderedPairs += reached[worker];
+        for (int v = 0; v < (int)furthest[worker].size(); v++)
+            invariants.eccentricities[v] = max(invariants.eccentricities[v], furthest[worker][v]);
+        const vector<long long>& histogram = histograms[worker];
+        if (invariants.distanceHistogram.size() < histogram.size())
+            invariants.distanceHistogram.resize(histogram.size(), 0);
+        for (size_t level = 1; level < histogram.size(); level++)
+            invariants.distanceHistogram[level] += histogram[level];
+    }
+
+    // Every unordered pair was found from both ends
+    for (size_t level = 1; level < invariants.distanceHistogram.size(); level++)
+    {
+        invariants.distanceHistogram[level] /= 2;
+        invariants.wienerIndex += (long long)level * invariants.distanceHistogram[level];
+    }
+    invariants.connected = orderedPairs == (long long)n * (n - 1);
+    if (n > 0)
+    {
+        invariants.diameter = *max_element(invariants.eccentricities.begin(), invariants.eccentricities.end());
+        invariants.radius = *min_element(invariants.eccentricities.begin(), invariants.eccentricities.end());
+    }
+    return true;
+}
+
+void allPairsDistances(const Graph& graph, vector<int>& distances)
+{
+    int n = graph.numVertices;
+    distances.assign((size_t)n * n, -1);
+    for (int v = 0; v < n; v++)
+        distances[(size_t)v * n + v] = 0;
+
+    // Each batch writes only the rows of its own sources
+    forEachBatch(graph, nullptr, [&](const int* sources, int count, BatchSearch& search, int)
+    {
+        searchBatch(graph, sources, count, search, [&](int v, uint64_t bits, int level)
+        {
+            for (; bits; bits &= bits - 1)
+                distances[(size_t)sources[lowestBit(bits)] * n + v] = level;
+        });
+    });
+}
+
+string distanceSummary(const DistanceInvariants& invariants)
+{
+    string summary = invariants.connected ? "" : "Disconnected  ";
+    return summary + "Diameter " + to_string(invariants.diameter) + "  Radius " + to_string(invariants.radius) + "  Wiener index " +
+           to_string(invariants.wienerIndex);
+}
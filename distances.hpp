@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "cancel.hpp"
+#include "graph.hpp"
+
+// Largest graph the distance invariants are worked out for; the all-pairs
+// search is quadratic in the vertex count
+const int distanceVertexLimit = 20000;
+
+// Hop distance invariants over every pair of vertices. In a disconnected
+// graph eccentricities are taken within each vertex's component and pairs in
+// different components are left out of the Wiener index and the histogram.
+struct DistanceInvariants
+{
+    bool connected = true;
+    int diameter = 0; // largest eccentricity
+    int radius = 0;   // smallest eccentricity
+    std::vector<int> eccentricities;
+    long long wienerIndex = 0;                // sum of distances over unordered pairs
+    std::vector<long long> distanceHistogram; // unordered pairs at each distance, [0] unused
+};
+
+// Bit-parallel breadth-first search from 64 sources at a time, the batches
+// shared out across the worker threads. Returns false if cancelled.
+bool distanceInvariants(const Graph& graph, DistanceInvariants& invariants, const CancelToken* cancel = nullptr);
+
+// All-pairs hop distances row by row, -1 where unreachable, by the same search
+void allPairsDistances(const Graph& graph, std::vector<int>& distances);
+
+// "Diameter 4  Radius 2  Wiener index 1234", or "Disconnected" first
+std::string distanceSummary(const DistanceInvariants& invariants);
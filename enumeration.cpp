@@ -0,0 +1,580 @@
+#include "enumeration.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+#include "exporter.hpp"
+#include "isomorphism.hpp"
+#include "logger.hpp"
+#include "parallel.hpp"
+
+using namespace std;
+
+namespace
+{
+    typedef array<uint8_t, 64> Permutation;
+
+    // Search tree subtrees written per round, so the output is streamed
+    const int tasksPerRound = 256;
+
+    uint64_t applyPermutation(const Permutation& permutation, uint64_t set)
+    {
+        uint64_t image = 0;
+        for (; set != 0; set &= set - 1)
+            image |= bitOf(permutation[lowestBit(set)]);
+        return image;
+    }
+
+    // Canonical labelling of a small graph: the leaf of the individualisation
+    // refinement tree with the greatest refinement traces, then the greatest
+    // relabelled rows. Leaves equal to the first or best leaf give
+    // automorphisms, which prune the children of later nodes; together they
+    // generate the whole group.
+    class CanonicalLabeller
+    {
+    public:
+        void run(const SmallGraph& graph, vector<Permutation>& generators, int* labels)
+        {
+            m_graph = &graph;
+            m_generators = &generators;
+            generators.clear();
+            m_haveFirst = false;
+
+            Partition<64> root;
+            root.reset(graph.numVertices);
+            splitByKeys(root, vertexInvariants(graph));
+            refinePartition(graph, root, -1);
+            explore(root, 0);
+            copy(m_bestLabels, m_bestLabels + graph.numVertices, labels);
+        }
+
+    private:
+        // Compare the traces down to depth with a stored path, up to the shorter
+        int compareTraces(int depth, const uint64_t* traces, int tracesDepth) const
+        {
+            for (int i = 0; i < min(depth, tracesDepth); i++)
+            {
+                if (m_traces[i] != traces[i])
+                    return m_traces[i] < traces[i] ? -1 : 1;
+            }
+            return 0;
+        }
+
+        // Orbit of v under the automorphisms found so far that fix the
+        // vertices individualised above this depth
+        uint64_t orbitOf(int v, int depth) const
+        {
+            uint64_t orbit = bitOf(v);
+            bool grown = true;
+            while (grown)
+            {
+                grown = false;
+                for (const Permutation& generator : *m_generators)
+                {
+                    bool fixesPath = true;
+                    for (int i = 0; i < depth && fixesPath; i++)
+                        fixesPath = generator[m_path[i]] == m_path[i];
+                    uint64_t image = fixesPath ? applyPermutation(generator, orbit) : 0;
+                    if ((image & ~orbit) != 0)
+                    {
+                        orbit |= image;
+                        grown = true;
+                    }
+                }
+            }
+            return orbit;
+        }
+
+        void explore(const Partition<64>& partition, int depth)
+        {
+            bool equalFirst = m_haveFirst && depth <= m_firstDepth && compareTraces(depth, m_firstTraces, m_firstDepth) == 0;
+            int versusBest = m_haveFirst ? compareTraces(depth, m_bestTraces, m_bestDepth) : 1;
+            if (!equalFirst && versusBest < 0)
+                return;
+            if (partition.discrete())
+            {
+                leaf(partition, depth, equalFirst, versusBest);
+                return;
+            }
+
+            int cell = partition.targetCell();
+            uint64_t explored = 0;
+            for (int p = cell; p < cell + partition.lengthOf(cell); p++)
+            {
+                int v = partition.at(p);
+                if (explored != 0 && (orbitOf(v, depth) & explored) != 0)
+                    continue;
+                explored |= bitOf(v);
+
+                Partition<64> next = partition;
+                next.individualise(v);
+                m_path[depth] = v;
+                m_traces[depth] = refinePartition(*m_graph, next, cell);
+                explore(next, depth + 1);
+            }
+        }
+
+        void leaf(const Partition<64>& partition, int depth, bool equalFirst, int versusBest)
+        {
+            int n = m_graph->numVertices;
+            int labels[64];
+            for (int p = 0; p < n; p++)
+                labels[partition.at(p)] = p;
+            SmallGraph relabelled = relabel(*m_graph, labels);
+
+            if (!m_haveFirst)
+            {
+                m_haveFirst = true;
+                store(depth, labels, relabelled, m_firstDepth, m_firstTraces, m_firstLabels, m_firstRows);
+                store(depth, labels, relabelled, m_bestDepth, m_bestTraces, m_bestLabels, m_bestRows);
+                return;
+            }
+            if (equalFirst && depth == m_firstDepth && equal(relabelled.rows, relabelled.rows + n, m_firstRows))
+            {
+                addAutomorphism(m_firstLabels, labels);
+                return;
+            }
+
+            int order = versusBest;
+            if (order == 0)
+                order = depth != m_bestDepth ? (depth < m_bestDepth ? -1 : 1) : compareRows(relabelled.rows, m_bestRows, n);
+            if (order == 0)
+                addAutomorphism(m_bestLabels, labels);
+            else if (order > 0)
+                store(depth, labels, relabelled, m_bestDepth, m_bestTraces, m_bestLabels, m_bestRows);
+        }
+
+        static int compareRows(const uint64_t* a, const uint64_t* b, int n)
+        {
+            for (int v = 0; v < n; v++)
+            {
+                if (a[v] != b[v])
+                    return a[v] < b[v] ? -1 : 1;
+            }
+            return 0;
+        }
+
+        void store(int depth, const int* labels, const SmallGraph& relabelled, int& storedDepth, uint64_t* traces, int* storedLabels, uint64_t* rows)
+        {
+            storedDepth = depth;
+            copy(m_traces, m_traces + depth, traces);
+            copy(labels, labels + m_graph->numVertices, storedLabels);
+            copy(relabelled.rows, relabelled.rows + m_graph->numVertices, rows);
+        }
+
+        // Two leaves with the same relabelled graph differ by an automorphism
+        void addAutomorphism(const int* fromLabels, const int* toLabels)
+        {
+            int n = m_graph->numVertices;
+            int vertexAt[64];
+            for (int v = 0; v < n; v++)
+                vertexAt[toLabels[v]] = v;
+            Permutation generator;
+            bool identity = true;
+            for (int v = 0; v < n; v++)
+            {
+                generator[v] = (uint8_t)vertexAt[fromLabels[v]];
+                identity = identity && generator[v] == v;
+            }
+            if (!identity)
+                m_generators->push_back(generator);
+        }
+
+        const SmallGraph* m_graph = nullptr;
+        vector<Permutation>* m_generators = nullptr;
+        int m_path[64];
+        uint64_t m_traces[64];
+
+        bool m_haveFirst = false;
+        int m_firstDepth = 0, m_bestDepth = 0;
+        uint64_t m_firstTraces[64], m_bestTraces[64];
+        int m_firstLabels[64], m_bestLabels[64];
+        uint64_t m_firstRows[64], m_bestRows[64];
+    };
+
+    // Subtree of the search tree handed to one worker
+    struct Task
+    {
+        SmallGraph graph;
+        int edges = 0;
+        vector<Permutation> generators;
+    };
+
+    // Canonical augmentation by vertices. The canonical vertex to delete is
+    // one of minimum degree with the greatest neighbour degree sum, ties
+    // broken by the largest canonical label; a child is kept when its new
+    // vertex is in that vertex's orbit. Only one neighbourhood per orbit of
+    // the parent's automorphism group is tried.
+    class Enumerator
+    {
+    public:
+        Enumerator(int numVertices, int numEdges, bool complement)
+            : m_numVertices(numVertices), m_numEdges(numEdges), m_complement(complement), m_seen(numVertices)
+        {
+            // One table per level, as the children are searched before the
+            // parent's marks are cleared
+            for (int k = 0; k < numVertices; k++)
+                m_seen[k].assign((size_t)1 << k, 0);
+        }
+
+        // Collect the accepted graphs with the given number of vertices
+        void collect(const Task& node, int vertices, vector<Task>& tasks)
+        {
+            if (node.graph.numVertices == vertices)
+            {
+                tasks.push_back(node);
+                return;
+            }
+            forEachChild(node.graph, node.edges, node.generators, [&](const SmallGraph& child, int edges, const vector<Permutation>& generators)
+            {
+                Task task;
+                task.graph = child;
+                task.edges = edges;
+                task.generators = generators;
+                collect(task, vertices, tasks);
+            });
+        }
+
+        // Append every complete graph below node to text
+        long long generate(const SmallGraph& graph, int edges, const vector<Permutation>& generators, string& text)
+        {
+            if (graph.numVertices == m_numVertices)
+            {
+                emit(graph, text);
+                return 1;
+            }
+            long long count = 0;
+            forEachChild(graph, edges, generators, [&](const SmallGraph& child, int childEdges, const vector<Permutation>& childGenerators)
+            {
+                count += generate(child, childEdges, childGenerators, text);
+            });
+            return count;
+        }
+
+    private:
+        void emit(const SmallGraph& graph, string& text)
+        {
+            if (!m_complement)
+            {
+                appendGraph6(text, graph.numVertices, graph.rows);
+                return;
+            }
+            SmallGraph complement = graph;
+            uint64_t all = graph.numVertices == 64 ? ~0ULL : bitOf(graph.numVertices) - 1;
+            for (int v = 0; v < graph.numVertices; v++)
+                complement.rows[v] = ~graph.rows[v] & all & ~bitOf(v);
+            appendGraph6(text, complement.numVertices, complement.rows);
+        }
+
+        // Whether the new last vertex of child is its canonical deletion.
+        // Cheap invariants settle most cases; the canonical labelling is
+        // only needed for ties, and its automorphisms are kept for the
+        // child's own children.
+        bool canonicalChild(const SmallGraph& child, vector<Permutation>& generators, bool& labelled)
+        {
+            int last = child.numVertices - 1;
+            int degree = child.degree(last);
+            labelled = false;
+
+            uint64_t candidates = 0;
+            for (int v = 0; v <= last; v++)
+            {
+                if (child.degree(v) == degree)
+                    candidates |= bitOf(v);
+            }
+            if (candidates == bitOf(last))
+                return true;
+
+            auto degreeSum = [&](int v)
+            {
+                int sum = 0;
+                child.forEachNeighbour(v, [&](int u) { sum += child.degree(u); });
+                return sum;
+            };
+            int lastSum = degreeSum(last);
+            uint64_t ties = 0;
+            for (uint64_t bits = candidates; bits != 0; bits &= bits - 1)
+            {
+                int v = lowestBit(bits);
+                int sum = degreeSum(v);
+                if (sum > lastSum)
+                    return false;
+                if (sum == lastSum)
+                    ties |= bitOf(v);
+            }
+            if (ties == bitOf(last))
+                return true;
+
+            int labels[64];
+            m_labeller.run(child, generators, labels);
+            labelled = true;
+            int chosen = last;
+            for (uint64_t bits = ties; bits != 0; bits &= bits - 1)
+            {
+                int v = lowestBit(bits);
+                if (labels[v] > labels[chosen])
+                    chosen = v;
+            }
+            if (chosen == last)
+                return true;
+
+            // Same orbit as the chosen vertex under the whole group
+            uint64_t orbit = bitOf(chosen);
+            bool grown = true;
+            while (grown)
+            {
+                grown = false;
+                for (const Permutation& generator : generators)
+                {
+                    uint64_t image = applyPermutation(generator, orbit);
+                    if ((image & ~orbit) != 0)
+                    {
+                        orbit |= image;
+                        grown = true;
+                    }
+                }
+            }
+            return (orbit & bitOf(last)) != 0;
+        }
+
+        template <typename Visit>
+        void forEachChild(const SmallGraph& graph, int edges, const vector<Permutation>& generators, Visit visit)
+        {
+            int k = graph.numVertices;
+            int n = m_numVertices;
+
+            // Edges the vertices after this new one can still add
+            int laterEdges = n * (n - 1) / 2 - k * (k + 1) / 2;
+            int smallest = max(0, m_numEdges - edges - laterEdges);
+            int largest = min(k, m_numEdges - edges);
+
+            int minimumDegree = k;
+            for (int v = 0; v < k; v++)
+                minimumDegree = min(minimumDegree, graph.degree(v));
+            largest = min(largest, minimumDegree + 1);
+
+            vector<Permutation> childGenerators;
+            int free[64];
+            for (int s = smallest; s <= largest; s++)
+            {
+                // The new vertex must keep the minimum degree, so vertices of
+                // degree s - 1 must be its neighbours
+                uint64_t required = 0, optional = 0;
+                for (int v = 0; v < k; v++)
+                {
+                    if (graph.degree(v) < s - 1)
+                        required = ~0ULL;
+                    else if (graph.degree(v) == s - 1)
+                        required |= bitOf(v);
+                    else
+                        optional |= bitOf(v);
+                }
+                if (required == ~0ULL)
+                    continue;
+                int choose = s - popcount64(required);
+                int freeCount = popcount64(optional);
+                if (choose < 0 || choose > freeCount)
+                    continue;
+                for (int i = 0, bits = 0; i < k; i++)
+                {
+                    if ((optional >> i) & 1)
+                        free[bits++] = i;
+                }
+
+                // Subsets of the optional vertices in colexicographic order
+                vector<uint64_t> marked;
+                uint64_t combination = choose == 0 ? 0 : bitOf(choose) - 1;
+                while (true)
+                {
+                    uint64_t neighbours = required;
+                    for (uint64_t bits = combination; bits != 0; bits &= bits - 1)
+                        neighbours |= bitOf(free[lowestBit(bits)]);
+
+                    bool representative = true;
+                    if (!generators.empty())
+                    {
+                        if (m_seen[k][neighbours])
+                            representative = false;
+                        else
+                            markOrbit(m_seen[k], neighbours, generators, marked);
+                    }
+
+                    if (representative)
+                    {
+                        SmallGraph child = graph;
+                        child.numVertices = k + 1;
+                        child.rows[k] = neighbours;
+                        for (uint64_t bits = neighbours; bits != 0; bits &= bits - 1)
+                            child.rows[lowestBit(bits)] |= bitOf(k);
+
+                        bool labelled;
+                        if (canonicalChild(child, childGenerators, labelled))
+                        {
+                            if (!labelled)
+                                childGenerators.clear();
+                            if (!labelled && k + 1 < n)
+                            {
+                                int labels[64];
+                                m_labeller.run(child, childGenerators, labels);
+                            }
+                            visit(child, edges + s, childGenerators);
+                        }
+                    }
+
+                    // Next combination of the same size (Gosper's hack)
+                    if (choose == 0)
+                        break;
+                    uint64_t low = combination & (0 - combination);
+                    uint64_t ripple = combination + low;
+                    combination = ripple | (((combination ^ ripple) >> 2) / low);
+                    if (combination >= bitOf(freeCount) && freeCount < 64)
+                        break;
+                }
+
+                for (uint64_t set : marked)
+                    m_seen[k][set] = 0;
+            }
+        }
+
+        // Mark every image of a neighbourhood under the group as tried
+        void markOrbit(vector<char>& seen, uint64_t neighbours, const vector<Permutation>& generators, vector<uint64_t>& marked)
+        {
+            size_t first = marked.size();
+            seen[neighbours] = 1;
+            marked.push_back(neighbours);
+            for (size_t i = first; i < marked.size(); i++)
+            {
+                for (const Permutation& generator : generators)
+                {
+                    uint64_t image = applyPermutation(generator, marked[i]);
+                    if (!seen[image])
+                    {
+                        seen[image] = 1;
+                        marked.push_back(image);
+                    }
+                }
+            }
+        }
+
+        int m_numVertices;
+        int m_numEdges;
+        bool m_complement;
+        vector<vector<char>> m_seen; // neighbourhoods tried, by parent vertex count
+        CanonicalLabeller m_labeller;
+    };
+}
+
+bool enumerateGraphs(int numVertices, int numEdges, const string& path, long long& count, string& error)
+{
+    count = 0;
+    int pairs = numVertices * (numVertices - 1) / 2;
+    if (numVertices < 1 || numVertices > maxEnumerationVertices)
+    {
+        error = "The vertex count must be between 1 and " + to_string(maxEnumerationVertices);
+        return false;
+    }
+    if (numEdges < 0 || numEdges > pairs)
+    {
+        error = "The edge count must be between 0 and " + to_string(pairs);
+        return false;
+    }
+
+    BufferedWriter out(path);
+    if (!out.isOpen())
+    {
+        error = "Could not write " + path;
+        return false;
+    }
+
+    // Dense graphs are the complements of sparse ones, which prune better
+    bool complement = numEdges > pairs / 2;
+    int edges = complement ? pairs - numEdges : numEdges;
+
+    // Split the tree a few levels above the leaves
+    Task root;
+    root.graph.numVertices = 1;
+    int splitVertices = max(1, numVertices - 4);
+    vector<Task> tasks;
+    Enumerator(numVertices, edges, complement).collect(root, splitVertices, tasks);
+
+    vector<Enumerator> workers(workerCount(), Enumerator(numVertices, edges, complement));
+    vector<string> texts;
+    vector<long long> counts;
+    for (size_t first = 0; first < tasks.size(); first += tasksPerRound)
+    {
+        int roundSize = (int)min<size_t>(tasksPerRound, tasks.size() - first);
+        texts.assign(roundSize, string());
+        counts.assign(roundSize, 0);
+        parallelFor(roundSize, [&](int begin, int end, int worker)
+        {
+            for (int i = begin; i < end; i++)
+            {
+                const Task& task = tasks[first + i];
+                counts[i] = workers[worker].generate(task.graph, task.edges, task.generators, texts[i]);
+            }
+        }, 1);
+
+        for (int i = 0; i < roundSize; i++)
+        {
+            out.write(texts[i]);
+            count += counts[i];
+        }
+    }
+
+    if (!out.close())
+    {
+        error = "Could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool enumerationRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (string(argv[i]) == "--enumerate")
+            return true;
+    }
+    return false;
+}
+
+int runEnumeration(int argc, char* argv[])
+{
+    int numVertices = -1, numEdges = -1;
+    string path;
+    for (int i = 1; i < argc; i++)
+    {
+        string argument = argv[i];
+        if (argument == "--enumerate" && i + 2 < argc)
+        {
+            numVertices = atoi(argv[++i]);
+            numEdges = atoi(argv[++i]);
+        }
+        else if (argument == "--out" && i + 1 < argc)
+            path = argv[++i];
+    }
+    if (numVertices < 0 || numEdges < 0)
+    {
+        logError("Usage: main --enumerate <vertices> <edges> [--out PATH]");
+        return 1;
+    }
+    if (path.empty())
+        path = "graphs_" + to_string(numVertices) + "_" + to_string(numEdges) + ".g6";
+
+    auto started = chrono::steady_clock::now();
+    long long count = 0;
+    string error;
+    if (!enumerateGraphs(numVertices, numEdges, path, count, error))
+    {
+        logError(error);
+        return 1;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    logInfo("Wrote " + to_string(count) + " graphs with " + to_string(numVertices) + " vertices and " + to_string(numEdges) + " edges to " + path +
+            " in " + to_string(seconds) + " s");
+    return 0;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+// Largest vertex count for exhaustive enumeration. Neighbourhoods of a new
+// vertex are looked up in a table of 2^(n-1) subsets, and the graph counts
+// explode long before that matters (12 vertices already give 165 billion).
+const int maxEnumerationVertices = 20;
+
+// Write one graph of every isomorphism class with numVertices vertices and
+// numEdges edges to path as graph6 lines, by canonical augmentation: graphs
+// grow one vertex at a time and a child is kept only if its new vertex is
+// the one canonical deletion would remove. The search tree is split across
+// threads and written out in rounds, so the output order does not depend on
+// the thread count. Returns false if the file could not be written.
+bool enumerateGraphs(int numVertices, int numEdges, const std::string& path, long long& count, std::string& error);
+
+// Whether the command line asks for enumeration (--enumerate)
+bool enumerationRequested(int argc, char* argv[]);
+
+// Headless command line mode: --enumerate <n> <m> [--out PATH], writing
+// graphs_<n>_<m>.g6 by default. Returns the process exit code.
+int runEnumeration(int argc, char* argv[]);
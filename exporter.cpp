@@ -0,0 +1,456 @@
+#include "exporter.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+using namespace std;
+
+BufferedWriter::BufferedWriter(const string& path, size_t capacity)
+    : m_file(fopen(path.c_str(), "wb")), m_buffer(capacity), m_used(0), m_failed(false)
+{
+}
+
+BufferedWriter::~BufferedWriter()
+{
+    close();
+}
+
+void BufferedWriter::flush()
+{
+    if (m_file != nullptr && m_used > 0 && fwrite(m_buffer.data(), 1, m_used, m_file) != m_used)
+        m_failed = true;
+    m_used = 0;
+}
+
+void BufferedWriter::write(const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        if (m_used == m_buffer.size())
+            flush();
+        size_t chunk = min(size, m_buffer.size() - m_used);
+        memcpy(m_buffer.data() + m_used, data, chunk);
+        m_used += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+void BufferedWriter::fill(char c, size_t count)
+{
+    while (count > 0)
+    {
+        if (m_used == m_buffer.size())
+            flush();
+        size_t chunk = min(count, m_buffer.size() - m_used);
+        memset(m_buffer.data() + m_used, c, chunk);
+        m_used += chunk;
+        count -= chunk;
+    }
+}
+
+void BufferedWriter::writeInt(long long value)
+{
+    if (m_buffer.size() - m_used < 24)
+        flush();
+    m_used = to_chars(m_buffer.data() + m_used, m_buffer.data() + m_buffer.size(), value).ptr - m_buffer.data();
+}
+
+void BufferedWriter::writeUint32(unsigned value)
+{
+    for (int shift = 0; shift < 32; shift += 8)
+        put((char)((value >> shift) & 0xFF));
+}
+
+bool BufferedWriter::close()
+{
+    if (m_file == nullptr)
+        return false;
+    flush();
+    if (fclose(m_file) != 0)
+        m_failed = true;
+    m_file = nullptr;
+    return !m_failed;
+}
+
+namespace
+{
+    // Every edge stored from both ends (loops once), each row sorted, so rows
+    // can be streamed in column order with repeated entries counted
+    struct Rows
+    {
+        vector<int> offsets;
+        vector<int> columns;
+    };
+
+    Rows buildRows(int numVertices, const vector<pair<int, int>>& edgeList)
+    {
+        Rows rows;
+        rows.offsets.assign(numVertices + 1, 0);
+        for (const auto& edge : edgeList)
+        {
+            rows.offsets[edge.first + 1]++;
+            if (edge.first != edge.second)
+                rows.offsets[edge.second + 1]++;
+        }
+        for (int i = 0; i < numVertices; i++)
+            rows.offsets[i + 1] += rows.offsets[i];
+
+        vector<int> cursor(rows.offsets.begin(), rows.offsets.end() - 1);
+        rows.columns.resize(rows.offsets[numVertices]);
+        for (const auto& edge : edgeList)
+        {
+            rows.columns[cursor[edge.first]++] = edge.second;
+            if (edge.first != edge.second)
+                rows.columns[cursor[edge.second]++] = edge.first;
+        }
+        for (int i = 0; i < numVertices; i++)
+            sort(rows.columns.begin() + rows.offsets[i], rows.columns.begin() + rows.offsets[i + 1]);
+        return rows;
+    }
+
+    void writeMatrixCsv(BufferedWriter& out, int numVertices, const Rows& rows)
+    {
+        for (int i = 0; i < numVertices; i++)
+        {
+            int next = rows.offsets[i];
+            int column = 0;
+            while (column < numVertices)
+            {
+                int target = next < rows.offsets[i + 1] ? rows.columns[next] : numVertices;
+
+                // Runs of zeros go out as a repeated "0," pattern
+                for (; column < target; column++)
+                    out.write(column + 1 < numVertices ? "0," : "0", column + 1 < numVertices ? 2 : 1);
+                if (column == numVertices)
+                    break;
+
+                int count = 0;
+                while (next < rows.offsets[i + 1] && rows.columns[next] == column)
+                {
+                    count++;
+                    next++;
+                }
+                out.writeInt(count);
+                if (column + 1 < numVertices)
+                    out.put(',');
+                column++;
+            }
+            out.put('\n');
+        }
+    }
+
+    void writeMatrixBinary(BufferedWriter& out, int numVertices, const Rows& rows)
+    {
+        out.write("ISOM", 4);
+        out.writeUint32((unsigned)numVertices);
+        for (int i = 0; i < numVertices; i++)
+        {
+            int column = 0;
+            for (int next = rows.offsets[i]; next < rows.offsets[i + 1];)
+            {
+                int target = rows.columns[next];
+                out.fill(0, (size_t)(target - column) * 4);
+                int count = 0;
+                while (next < rows.offsets[i + 1] && rows.columns[next] == target)
+                {
+                    count++;
+                    next++;
+                }
+                out.writeUint32((unsigned)count);
+                column = target + 1;
+            }
+            out.fill(0, (size_t)(numVertices - column) * 4);
+        }
+    }
+
+    void writeEdgeList(BufferedWriter& out, int numVertices, const vector<pair<int, int>>& edgeList)
+    {
+        out.write("# ", 2);
+        out.writeInt(numVertices);
+        out.put(' ');
+        out.writeInt((long long)edgeList.size());
+        out.put('\n');
+        for (const auto& edge : edgeList)
+        {
+            out.writeInt(edge.first);
+            out.put(' ');
+            out.writeInt(edge.second);
+            out.put('\n');
+        }
+    }
+
+    // Appends to a string through the calls the graph6 encoder makes on a BufferedWriter
+    struct StringSink
+    {
+        string& text;
+
+        void put(char c) { text += c; }
+        void write(const char* data, size_t size) { text.append(data, size); }
+        void fill(char c, size_t count) { text.append(count, c); }
+    };
+
+    // Vertex count prefix shared by graph6 and sparse6
+    template <typename Sink>
+    void writeGraphSize(Sink& out, long long n)
+    {
+        if (n <= 62)
+            out.put((char)(n + 63));
+        else if (n <= 258047)
+        {
+            out.put('~');
+            for (int shift = 12; shift >= 0; shift -= 6)
+                out.put((char)(((n >> shift) & 63) + 63));
+        }
+        else
+        {
+            out.write("~~", 2);
+            for (int shift = 30; shift >= 0; shift -= 6)
+                out.put((char)(((n >> shift) & 63) + 63));
+        }
+    }
+
+    // Packs bits six to a character, most significant first, as graph6 wants
+    template <typename Sink>
+    class SixBitWriter
+    {
+    public:
+        explicit SixBitWriter(Sink& out) : m_out(out), m_bits(0), m_count(0) {}
+
+        void bit(int value)
+        {
+            m_bits = (m_bits << 1) | (value & 1);
+            if (++m_count == 6)
+            {
+                m_out.put((char)(m_bits + 63));
+                m_bits = 0;
+                m_count = 0;
+            }
+        }
+
+        void bits(long long value, int width)
+        {
+            for (int shift = width - 1; shift >= 0; shift--)
+                bit((int)((value >> shift) & 1));
+        }
+
+        // Long runs of zero bits become whole '?' characters
+        void zeros(long long count)
+        {
+            while (count > 0 && m_count != 0)
+            {
+                bit(0);
+                count--;
+            }
+            m_out.fill('?', (size_t)(count / 6));
+            for (long long i = 0; i < count % 6; i++)
+                bit(0);
+        }
+
+        int pending() const { return m_count; }
+
+        // Pad the last character with the given bit value
+        void finish(int padding)
+        {
+            while (m_count != 0)
+                bit(padding);
+        }
+
+    private:
+        Sink& m_out;
+        int m_bits;
+        int m_count;
+    };
+
+    // graph6 line for any sink and adjacency source. forEachBelow(j, mark)
+    // calls mark(i) for the neighbours i < j of j in increasing order.
+    template <typename Sink, typename ForEachBelow>
+    void encodeGraph6(Sink& out, int numVertices, ForEachBelow forEachBelow)
+    {
+        writeGraphSize(out, numVertices);
+
+        // Upper triangle column by column: bit (i, j) for i < j
+        SixBitWriter<Sink> bits(out);
+        for (int j = 1; j < numVertices; j++)
+        {
+            int row = 0;
+            forEachBelow(j, [&](int i)
+            {
+                if (i < row)
+                    return; // repeated edge
+                bits.zeros(i - row);
+                bits.bit(1);
+                row = i + 1;
+            });
+            bits.zeros(j - row);
+        }
+        bits.finish(0);
+        out.put('\n');
+    }
+
+    void writeGraph6(BufferedWriter& out, int numVertices, const Rows& rows)
+    {
+        encodeGraph6(out, numVertices, [&](int j, auto mark)
+        {
+            for (int next = rows.offsets[j]; next < rows.offsets[j + 1] && rows.columns[next] < j; next++)
+                mark(rows.columns[next]);
+        });
+    }
+
+    void writeSparse6(BufferedWriter& out, int numVertices, const Rows& rows)
+    {
+        out.put(':');
+        writeGraphSize(out, numVertices);
+
+        int k = 1;
+        while ((1LL << k) < numVertices)
+            k++;
+
+        // Edges ordered by larger endpoint v, then smaller endpoint u
+        SixBitWriter<BufferedWriter> bits(out);
+        int current = 0;
+        for (int v = 0; v < numVertices; v++)
+        {
+            for (int next = rows.offsets[v]; next < rows.offsets[v + 1] && rows.columns[next] <= v; next++)
+            {
+                int u = rows.columns[next];
+                if (v == current)
+                {
+                    bits.bit(0);
+                    bits.bits(u, k);
+                }
+                else if (v == current + 1)
+                {
+                    current = v;
+                    bits.bit(1);
+                    bits.bits(u, k);
+                }
+                else
+                {
+                    current = v;
+                    bits.bit(1);
+                    bits.bits(v, k);
+                    bits.bit(0);
+                    bits.bits(u, k);
+                }
+            }
+        }
+
+        // Padding with ones could read as another edge when n is a small power
+        // of two and the last edge ends at n - 2; nauty then adds one 0 bit
+        int padding = bits.pending() == 0 ? 0 : 6 - bits.pending();
+        if (k < 6 && numVertices == (1 << k) && padding >= k + 1 && current == numVertices - 2)
+            bits.bit(0);
+        bits.finish(1);
+        out.put('\n');
+    }
+
+    void writeDot(BufferedWriter& out, int numVertices, const vector<pair<int, int>>& edgeList)
+    {
+        out.write("graph G {\n");
+        for (int v = 0; v < numVertices; v++)
+        {
+            out.write("  ", 2);
+            out.writeInt(v + 1);
+            out.write(";\n", 2);
+        }
+        for (const auto& edge : edgeList)
+        {
+            out.write("  ", 2);
+            out.writeInt(edge.first + 1);
+            out.write(" -- ", 4);
+            out.writeInt(edge.second + 1);
+            out.write(";\n", 2);
+        }
+        out.write("}\n");
+    }
+}
+
+bool exportFormatFromPath(const string& path, ExportFormat& format)
+{
+    size_t dot = path.find_last_of('.');
+    if (dot == string::npos)
+        return false;
+    string extension = path.substr(dot);
+
+    if (extension == ".csv")
+        format = ExportFormat::MatrixCsv;
+    else if (extension == ".bin")
+        format = ExportFormat::MatrixBinary;
+    else if (extension == ".edges" || extension == ".txt")
+        format = ExportFormat::EdgeList;
+    else if (extension == ".g6")
+        format = ExportFormat::Graph6;
+    else if (extension == ".s6")
+        format = ExportFormat::Sparse6;
+    else if (extension == ".dot")
+        format = ExportFormat::Dot;
+    else
+        return false;
+    return true;
+}
+
+const char* exportExtension(ExportFormat format)
+{
+    switch (format)
+    {
+    case ExportFormat::MatrixCsv:
+        return ".csv";
+    case ExportFormat::MatrixBinary:
+        return ".bin";
+    case ExportFormat::EdgeList:
+        return ".edges";
+    case ExportFormat::Graph6:
+        return ".g6";
+    case ExportFormat::Sparse6:
+        return ".s6";
+    case ExportFormat::Dot:
+        return ".dot";
+    }
+    return "";
+}
+
+bool exportGraph(const string& path, ExportFormat format, int numVertices, const vector<pair<int, int>>& edgeList)
+{
+    BufferedWriter out(path);
+    if (!out.isOpen())
+        return false;
+
+    switch (format)
+    {
+    case ExportFormat::MatrixCsv:
+        writeMatrixCsv(out, numVertices, buildRows(numVertices, edgeList));
+        break;
+    case ExportFormat::MatrixBinary:
+        writeMatrixBinary(out, numVertices, buildRows(numVertices, edgeList));
+        break;
+    case ExportFormat::EdgeList:
+        writeEdgeList(out, numVertices, edgeList);
+        break;
+    case ExportFormat::Graph6:
+        writeGraph6(out, numVertices, buildRows(numVertices, edgeList));
+        break;
+    case ExportFormat::Sparse6:
+        writeSparse6(out, numVertices, buildRows(numVertices, edgeList));
+        break;
+    case ExportFormat::Dot:
+        writeDot(out, numVertices, edgeList);
+        break;
+    }
+
+    return out.close();
+}
+
+void appendGraph6(string& text, int numVertices, const uint64_t* rows)
+{
+    StringSink out{text};
+    encodeGraph6(out, numVertices, [&](int j, auto mark)
+    {
+        for (int i = 0; i < j; i++)
+        {
+            if ((rows[j] >> i) & 1)
+                mark(i);
+        }
+    });
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+// File formats the drawn graph can be exported to
+enum class ExportFormat
+{
+    MatrixCsv,    // dense adjacency matrix, one comma separated row per line
+    MatrixBinary, // "ISOM" magic, little-endian uint32 n, then n * n uint32 counts
+    EdgeList,     // "# n m" header, then one 0-based "u v" pair per line
+    Graph6,       // nauty graph6, simple graphs only (loops and repeats dropped)
+    Sparse6,      // nauty sparse6, keeps loops and repeated edges
+    Dot           // Graphviz undirected graph
+};
+
+// Pick a format from a file extension (.csv .bin .edges/.txt .g6 .s6 .dot).
+// Returns false if the extension is not recognised.
+bool exportFormatFromPath(const std::string& path, ExportFormat& format);
+
+// File extension used for each format, including the dot
+const char* exportExtension(ExportFormat format);
+
+// Write a graph given as a list of (start, end) vertex pairs. Loops count
+// once on the diagonal, the way the completion step fills adjacencyMatrix.
+// Returns false if the file could not be written.
+bool exportGraph(const std::string& path, ExportFormat format, int numVertices, const std::vector<std::pair<int, int>>& edgeList);
+
+// Append the graph6 line of a graph given as neighbour bitmasks (bit i of
+// rows[j] set when i and j are adjacent), with the encoder Graph6 export uses
+void appendGraph6(std::string& text, int numVertices, const std::uint64_t* rows);
+
+// Output file with a large buffer that is only handed to the C library once
+// it fills, so per-element writes cost a few stores rather than a stream call
+class BufferedWriter
+{
+public:
+    explicit BufferedWriter(const std::string& path, size_t capacity = 1 << 20);
+    ~BufferedWriter();
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    bool isOpen() const { return m_file != nullptr; }
+
+    void put(char c)
+    {
+        if (m_used == m_buffer.size())
+            flush();
+        m_buffer[m_used++] = c;
+    }
+    void write(const char* data, size_t size);
+    void write(const std::string& text) { write(text.data(), text.size()); }
+    void fill(char c, size_t count);
+    void writeInt(long long value);
+    void writeUint32(unsigned value); // little-endian
+
+    // Flush and close; false if any write failed
+    bool close();
+
+private:
+    void flush();
+
+    std::FILE* m_file;
+    std::vector<char> m_buffer;
+    size_t m_used;
+    bool m_failed;
+};
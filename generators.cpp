@@ -0,0 +1,277 @@
+#include "generators.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "importer.hpp"
+
+using namespace std;
+
+namespace
+{
+    // Pair (i, j) with i < j from its index in column order: column j holds
+    // indexes j(j-1)/2 .. j(j+1)/2 - 1, the order graph6 uses
+    pair<int, int> pairFromIndex(long long index)
+    {
+        long long j = (long long)((1.0 + sqrt(1.0 + 8.0 * (double)index)) / 2.0);
+        while (j * (j - 1) / 2 > index)
+            j--;
+        while (j * (j + 1) / 2 <= index)
+            j++;
+        return make_pair((int)(index - j * (j - 1) / 2), (int)j);
+    }
+
+    // count distinct pair indexes in [0, total), sorted. Draws with
+    // replacement, then tops up the duplicates; each top-up is sorted on its
+    // own and merged in rather than sorting everything again.
+    vector<long long> samplePairIndexes(long long total, long long count, Random& rng)
+    {
+        vector<long long> chosen;
+        chosen.reserve(count);
+        while ((long long)chosen.size() < count)
+        {
+            size_t sorted = chosen.size();
+            long long missing = count - (long long)sorted;
+            for (long long i = 0; i < missing; i++)
+                chosen.push_back((long long)rng.below64((uint64_t)total));
+            sort(chosen.begin() + sorted, chosen.end());
+            inplace_merge(chosen.begin(), chosen.begin() + sorted, chosen.end());
+            chosen.erase(unique(chosen.begin(), chosen.end()), chosen.end());
+        }
+        return chosen;
+    }
+}
+
+vector<pair<int, int>> randomGnp(int n, double p, Random& rng)
+{
+    vector<pair<int, int>> edgeList;
+    if (n < 2 || p <= 0.0)
+        return edgeList;
+
+    double expected = p * n * (n - 1) / 2.0;
+    edgeList.reserve((size_t)(expected + 4.0 * sqrt(expected) + 16.0));
+
+    if (p >= 1.0)
+    {
+        for (int j = 1; j < n; j++)
+        {
+            for (int i = 0; i < j; i++)
+                edgeList.push_back(make_pair(i, j));
+        }
+        return edgeList;
+    }
+
+    // Walk the lower triangle row by row, skipping a geometric number of
+    // pairs. A p too small to tell from 0 gives no edges, like p <= 0.
+    double logMiss = log1p(-p);
+    if (logMiss == 0.0)
+        return edgeList;
+    double total = (double)n * (n - 1) / 2.0;
+    long long v = 1, w = -1;
+    while (v < n)
+    {
+        // The skip is checked as a double, since a long one would overflow
+        // the conversion; one past the last pair ends the walk
+        double r = rng.uniform(0.0, 1.0);
+        double skip = floor(log1p(-r) / logMiss);
+        double remaining = total - ((double)v * (v - 1) / 2.0 + (double)w + 1.0);
+        if (skip >= remaining)
+            break;
+        w += 1 + (long long)skip;
+        while (w >= v && v < n)
+        {
+            w -= v;
+            v++;
+        }
+        if (v < n)
+            edgeList.push_back(make_pair((int)w, (int)v));
+    }
+    return edgeList;
+}
+
+vector<pair<int, int>> randomGnm(int n, long long m, Random& rng)
+{
+    vector<pair<int, int>> edgeList;
+    long long total = (long long)n * (n - 1) / 2;
+    m = max(0LL, min(m, total));
+    edgeList.reserve((size_t)m);
+
+    if (m <= total / 2)
+    {
+        for (long long index : samplePairIndexes(total, m, rng))
+            edgeList.push_back(pairFromIndex(index));
+    }
+    else
+    {
+        // Dense: choose the pairs to leave out instead
+        vector<long long> skipped = samplePairIndexes(total, total - m, rng);
+        size_t next = 0;
+        for (long long index = 0; index < total; index++)
+        {
+            if (next < skipped.size() && skipped[next] == index)
+                next++;
+            else
+                edgeList.push_back(pairFromIndex(index));
+        }
+    }
+
+    // The sample comes out sorted; shuffle so edges are not drawn in order
+    permute(edgeList, rng);
+    return edgeList;
+}
+
+vector<pair<int, int>> randomPreferentialAttachment(int n, int d, Random& rng)
+{
+    vector<pair<int, int>> edgeList;
+    if (n < 2 || d < 1)
+        return edgeList;
+    edgeList.reserve((size_t)(n - 1) * d);
+
+    // Every edge adds both endpoints here, so a uniform pick from the list is
+    // a pick in proportion to degree. The targets of v are drawn from the
+    // endpoints as they stood before v, which lists every earlier vertex, and
+    // a vertex drawn twice is drawn again.
+    vector<int> endpoints;
+    endpoints.reserve((size_t)(n - 1) * d * 2);
+    vector<int> targets;
+    vector<int> pickedBy(n, -1);
+    for (int v = 1; v < n; v++)
+    {
+        targets.clear();
+        if (endpoints.empty())
+            targets.push_back(0);
+        uint32_t before = (uint32_t)endpoints.size();
+        int wanted = min(d, v);
+        while ((int)targets.size() < wanted)
+        {
+            int target = endpoints[rng.below(before)];
+            if (pickedBy[target] == v)
+                continue;
+            pickedBy[target] = v;
+            targets.push_back(target);
+        }
+        for (int target : targets)
+        {
+            edgeList.push_back(make_pair(v, target));
+            endpoints.push_back(v);
+            endpoints.push_back(target);
+        }
+    }
+    return edgeList;
+}
+
+bool randomRegular(int n, int d, Random& rng, vector<pair<int, int>>& edgeList)
+{
+    if (d < 0 || d >= n || ((long long)n * d) % 2 != 0)
+        return false;
+
+    long long points = (long long)n * d;
+    vector<int> unpaired(points);
+    vector<int> neighbours((size_t)n * d);
+    vector<int> degree(n);
+
+    auto adjacent = [&](int u, int v)
+    {
+        const int* begin = neighbours.data() + (size_t)u * d;
+        return find(begin, begin + degree[u], v) != begin + degree[u];
+    };
+
+    for (int attempt = 0; attempt < 100; attempt++)
+    {
+        edgeList.clear();
+        edgeList.reserve(points / 2);
+        fill(degree.begin(), degree.end(), 0);
+        for (long long i = 0; i < points; i++)
+            unpaired[i] = (int)(i / d);
+
+        // Pick two random free points; keep the pair if it makes a new,
+        // non-loop edge. Too many misses in a row means the pairing is stuck.
+        long long remaining = points;
+        long long misses = 0;
+        while (remaining > 0 && misses < 100 + remaining * 10)
+        {
+            uint32_t a = rng.below((uint32_t)remaining);
+            uint32_t b = rng.below((uint32_t)remaining);
+            int u = unpaired[a], v = unpaired[b];
+            if (a == b || u == v || adjacent(u, v))
+            {
+                misses++;
+                continue;
+            }
+            misses = 0;
+
+            neighbours[(size_t)u * d + degree[u]++] = v;
+            neighbours[(size_t)v * d + degree[v]++] = u;
+            edgeList.push_back(make_pair(u, v));
+
+            // Remove both points by moving the last ones into their slots
+            if (a < b)
+                swap(a, b);
+            unpaired[a] = unpaired[--remaining];
+            unpaired[b] = unpaired[--remaining];
+        }
+        if (remaining == 0)
+            return true;
+    }
+    return false;
+}
+
+bool generatorRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (string(argv[i]) == "--generate")
+            return true;
+    }
+    return false;
+}
+
+bool generateFromArguments(int argc, char* argv[], unsigned seed, int& numVertices, vector<pair<int, int>>& edgeList, string& error)
+{
+    int at = 1;
+    while (at < argc && string(argv[at]) != "--generate")
+        at++;
+    if (at + 3 >= argc)
+    {
+        error = "Usage: --generate gnp <n> <p> | gnm <n> <m> | ba <n> <d> | regular <n> <d>";
+        return false;
+    }
+
+    string model = argv[at + 1];
+    long long n = atoll(argv[at + 2]);
+    const char* parameter = argv[at + 3];
+    if (n < 1)
+    {
+        error = "The vertex count must be at least 1";
+        return false;
+    }
+    if (n > importVertexLimit)
+    {
+        error = to_string(n) + " vertices is more than the " + to_string(importVertexLimit) + " a graph may have";
+        return false;
+    }
+    numVertices = (int)n;
+
+    Random rng(seed);
+    if (model == "gnp")
+        edgeList = randomGnp(numVertices, atof(parameter), rng);
+    else if (model == "gnm")
+        edgeList = randomGnm(numVertices, atoll(parameter), rng);
+    else if (model == "ba")
+        edgeList = randomPreferentialAttachment(numVertices, atoi(parameter), rng);
+    else if (model == "regular")
+    {
+        if (!randomRegular(numVertices, atoi(parameter), rng, edgeList))
+        {
+            error = "No random regular graph: the degree must be below n and n * d must be even";
+            return false;
+        }
+    }
+    else
+    {
+        error = "Unknown graph model " + model + "; use gnp, gnm, ba or regular";
+        return false;
+    }
+    return true;
+}
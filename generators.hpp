@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "random.hpp"
+
+// Random graphs for load testing, as (start, end) vertex pairs like the
+// importer produces. All are reproducible from the generator's seed.
+
+// Erdos-Renyi G(n, p): every pair is an edge with probability p. Geometric
+// skipping (Batagelj and Brandes) jumps straight to the next edge, so the
+// time is linear in the number of edges rather than in n^2.
+std::vector<std::pair<int, int>> randomGnp(int n, double p, Random& rng);
+
+// Erdos-Renyi G(n, m): m distinct edges chosen uniformly from all pairs
+std::vector<std::pair<int, int>> randomGnm(int n, long long m, Random& rng);
+
+// Barabasi-Albert preferential attachment: every new vertex sends d edges to
+// d distinct earlier vertices (all of them while there are fewer) picked in
+// proportion to their degree, by sampling from the list of all edge endpoints
+// so far. The graph is simple.
+std::vector<std::pair<int, int>> randomPreferentialAttachment(int n, int d, Random& rng);
+
+// Simple random d-regular graph by pairing d points per vertex (Steger and
+// Wormald), skipping pairs that would make a loop or repeat an edge and
+// starting over if the pairing gets stuck. n * d must be even and d < n.
+bool randomRegular(int n, int d, Random& rng, std::vector<std::pair<int, int>>& edgeList);
+
+// Whether the command line asks for a generated graph (--generate ...)
+bool generatorRequested(int argc, char* argv[]);
+
+// Build the graph named on the command line:
+//   --generate gnp <n> <p> | gnm <n> <m> | ba <n> <d> | regular <n> <d>
+// On failure returns false and sets error.
+bool generateFromArguments(int argc, char* argv[], unsigned seed, int& numVertices, std::vector<std::pair<int, int>>& edgeList, std::string& error);
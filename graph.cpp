@@ -0,0 +1,72 @@
+#include "graph.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+Graph buildGraph(int numVertices, const vector<pair<int, int>>& edgeList)
+{
+    Graph graph;
+    graph.numVertices = numVertices;
+    graph.offsets.assign(numVertices + 1, 0);
+
+    // Count both directions of every non-loop edge
+    for (const auto& edge : edgeList)
+    {
+        if (edge.first == edge.second)
+            continue;
+        graph.offsets[edge.first + 1]++;
+        graph.offsets[edge.second + 1]++;
+    }
+    for (int i = 0; i < numVertices; i++)
+        graph.offsets[i + 1] += graph.offsets[i];
+
+    vector<int> fill(graph.offsets.begin(), graph.offsets.end() - 1);
+    graph.neighbours.resize(graph.offsets[numVertices]);
+    for (const auto& edge : edgeList)
+    {
+        if (edge.first == edge.second)
+            continue;
+        graph.neighbours[fill[edge.first]++] = edge.second;
+        graph.neighbours[fill[edge.second]++] = edge.first;
+    }
+
+    // Sort each row and drop repeated edges, compacting in place
+    int write = 0;
+    for (int v = 0; v < numVertices; v++)
+    {
+        int begin = graph.offsets[v];
+        int end = graph.offsets[v + 1];
+        sort(graph.neighbours.begin() + begin, graph.neighbours.begin() + end);
+        graph.offsets[v] = write;
+        for (int i = begin; i < end; i++)
+        {
+            if (i > begin && graph.neighbours[i] == graph.neighbours[i - 1])
+                continue;
+            graph.neighbours[write++] = graph.neighbours[i];
+        }
+    }
+    graph.offsets[numVertices] = write;
+    graph.neighbours.resize(write);
+
+    return graph;
+}
+
+Graph buildGraph(const vector<vector<int>>& adjacencyMatrix)
+{
+    Graph graph;
+    graph.numVertices = (int)adjacencyMatrix.size();
+    graph.offsets.assign(graph.numVertices + 1, 0);
+
+    for (int i = 0; i < graph.numVertices; i++)
+    {
+        for (int j = 0; j < graph.numVertices; j++)
+        {
+            if (i != j && adjacencyMatrix[i][j] > 0)
+                graph.neighbours.push_back(j);
+        }
+        graph.offsets[i + 1] = (int)graph.neighbours.size();
+    }
+
+    return graph;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// Simple undirected graph stored in compressed sparse row form.
+// Loops and repeated edges are folded away, the same way the generated
+// panels only look at whether adjacencyMatrix[i][j] > 0.
+struct Graph
+{
+    int numVertices = 0;
+    std::vector<int> offsets;    // size numVertices + 1
+    std::vector<int> neighbours; // sorted neighbour lists, back to back
+
+    int degree(int v) const { return offsets[v + 1] - offsets[v]; }
+    const int* neighboursBegin(int v) const { return neighbours.data() + offsets[v]; }
+    const int* neighboursEnd(int v) const { return neighbours.data() + offsets[v + 1]; }
+    int numEdges() const { return (int)neighbours.size() / 2; }
+
+    // Interface shared with SmallGraph so the isomorphism code works on both;
+    // capacity 0 means storage is sized at run time
+    static constexpr int capacity = 0;
+    int size() const { return numVertices; }
+    bool adjacent(int u, int v) const { return std::binary_search(neighboursBegin(u), neighboursEnd(u), v); }
+    template <typename Function>
+    void forEachNeighbour(int v, Function fn) const
+    {
+        for (const int* it = neighboursBegin(v); it != neighboursEnd(v); ++it)
+            fn(*it);
+    }
+};
+
+// Build a graph from a list of (start, end) vertex index pairs
+Graph buildGraph(int numVertices, const std::vector<std::pair<int, int>>& edgeList);
+
+// Build a graph from the adjacency matrix filled in when the drawing is complete
+Graph buildGraph(const std::vector<std::vector<int>>& adjacencyMatrix);
@@ -0,0 +1,449 @@
+#include "importer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "mappedfile.hpp"
+#include "scanner.hpp"
+
+using namespace std;
+
+namespace
+{
+    string lineError(const Scanner& scanner, const char* message)
+    {
+        return "Line " + to_string(scanner.line) + ": " + message;
+    }
+
+    // Edges cannot outnumber lines, so one pass over the line breaks sizes
+    // the edge list before parsing
+    size_t countLines(const char* data, size_t size)
+    {
+        return (size_t)count(data, data + size, '\n') + 1;
+    }
+
+    bool parseEdgeList(Scanner scanner, int& numVertices, vector<pair<int, int>>& edgeList, string& error)
+    {
+        edgeList.reserve(countLines(scanner.pos, scanner.end - scanner.pos));
+
+        long long declaredVertices = -1;
+        long long largest = -1;
+        for (; !scanner.atEnd(); scanner.nextLine())
+        {
+            if (scanner.atLineEnd())
+                continue;
+
+            if (*scanner.pos == '#' || *scanner.pos == '%')
+            {
+                // "# n m" header as written by the exporter
+                scanner.pos++;
+                long long n, m;
+                if (declaredVertices < 0 && scanner.line == 1 && scanner.readNumber(n) && scanner.readNumber(m) && scanner.atLineEnd())
+                    declaredVertices = n;
+                continue;
+            }
+
+            long long start, end;
+            if (!scanner.readNumber(start) || !scanner.readNumber(end))
+            {
+                error = lineError(scanner, "expected two vertex numbers");
+                return false;
+            }
+            largest = max(largest, max(start, end));
+            edgeList.push_back(make_pair((int)start, (int)end));
+        }
+
+        if (declaredVertices >= 0 && largest >= declaredVertices)
+        {
+            error = "Vertex " + to_string(largest) + " is out of range for " + to_string(declaredVertices) + " vertices";
+            return false;
+        }
+
+        // Without a header the vertices are only those the edges name, at most
+        // two per edge, so a larger number is a mistake rather than a count
+        if (declaredVertices < 0 && largest >= 2 * (long long)edgeList.size())
+        {
+            error = "Vertex " + to_string(largest) + " is out of range for " + to_string(edgeList.size()) +
+                    " edges; add a \"# n m\" header for isolated vertices";
+            return false;
+        }
+        numVertices = (int)(declaredVertices >= 0 ? declaredVertices : largest + 1);
+        return true;
+    }
+
+    bool parseDimacs(Scanner scanner, int& numVertices, vector<pair<int, int>>& edgeList, string& error)
+    {
+        numVertices = -1;
+        for (; !scanner.atEnd(); scanner.nextLine())
+        {
+            if (scanner.atLineEnd())
+                continue;
+
+            char kind = *scanner.pos++;
+            if (kind == 'c')
+                continue;
+
+            if (kind == 'p')
+            {
+                // "p edge n m" (also "p col n m")
+                scanner.skipBlanks();
+                while (!scanner.atEnd() && *scanner.pos >= 'a' && *scanner.pos <= 'z')
+                    scanner.pos++;
+                long long n, m;
+                if (numVertices >= 0 || !scanner.readNumber(n) || !scanner.readNumber(m))
+                {
+                    error = lineError(scanner, "expected a single \"p edge <vertices> <edges>\" line");
+                    return false;
+                }
+                numVertices = (int)n;
+                edgeList.reserve(min((size_t)m, countLines(scanner.pos, scanner.end - scanner.pos)));
+            }
+            else if (kind == 'e')
+            {
+                long long start, end;
+                if (numVertices < 0 || !scanner.readNumber(start) || !scanner.readNumber(end))
+                {
+                    error = lineError(scanner, "expected \"e <vertex> <vertex>\" after the problem line");
+                    return false;
+                }
+                if (start < 1 || end < 1 || start > numVertices || end > numVertices)
+                {
+                    error = lineError(scanner, "vertex out of range");
+                    return false;
+                }
+                edgeList.push_back(make_pair((int)start - 1, (int)end - 1));
+            }
+            else
+            {
+                error = lineError(scanner, "unknown line type");
+                return false;
+            }
+        }
+
+        if (numVertices < 0)
+        {
+            error = "Missing \"p edge\" line";
+            return false;
+        }
+        return true;
+    }
+
+    // Six data bits per character, most significant first
+    class SixBitReader
+    {
+    public:
+        SixBitReader(const char* begin, const char* end) : m_pos(begin), m_end(end), m_bits(0), m_count(0) {}
+
+        bool bit(int& value)
+        {
+            if (m_count == 0)
+            {
+                if (m_pos == m_end || *m_pos < 63 || *m_pos > 126)
+                    return false;
+                m_bits = *m_pos++ - 63;
+                m_count = 6;
+            }
+            value = (m_bits >> --m_count) & 1;
+            return true;
+        }
+
+        bool bits(int width, long long& value)
+        {
+            value = 0;
+            for (int i = 0; i < width; i++)
+            {
+                int b;
+                if (!bit(b))
+                    return false;
+                value = (value << 1) | b;
+            }
+            return true;
+        }
+
+        // Position of the next unread character, for reading the size prefix
+        const char*& pos() { return m_pos; }
+
+    private:
+        const char* m_pos;
+        const char* m_end;
+        int m_bits;
+        int m_count;
+    };
+
+    // Vertex count prefix shared by graph6 and sparse6
+    bool readGraphSize(const char*& pos, const char* end, long long& n)
+    {
+        auto digit = [&](long long& value)
+        {
+            if (pos == end || *pos < 63 || *pos > 126)
+                return false;
+            value = (value << 6) | (*pos++ - 63);
+            return true;
+        };
+
+        n = 0;
+        if (pos == end)
+            return false;
+        if (*pos != '~')
+            return digit(n);
+        pos++;
+        int digits = 3;
+        if (pos != end && *pos == '~')
+        {
+            pos++;
+            digits = 6;
+        }
+        for (int i = 0; i < digits; i++)
+        {
+            if (!digit(n))
+                return false;
+        }
+        return n <= 2147483647LL;
+    }
+
+    void skipHeader(Scanner& scanner, const char* header)
+    {
+        size_t length = strlen(header);
+        if ((size_t)(scanner.end - scanner.pos) >= length && memcmp(scanner.pos, header, length) == 0)
+            scanner.pos += length;
+    }
+
+    bool parseGraph6(Scanner scanner, int& numVertices, vector<pair<int, int>>& edgeList, string& error)
+    {
+        skipHeader(scanner, ">>graph6<<");
+        const char* end = scanner.lineEnd();
+        while (end != scanner.pos && end[-1] == '\r')
+            end--;
+
+        long long n;
+        const char* pos = scanner.pos;
+        if (!readGraphSize(pos, end, n))
+        {
+            error = "Bad graph6 vertex count";
+            return false;
+        }
+        if ((end - pos) * 6 < n * (n - 1) / 2)
+        {
+            error = "graph6 data is shorter than the vertex count needs";
+            return false;
+        }
+
+        // Bit (i, j) of the upper triangle, column by column
+        long long i = 0, j = 1;
+        auto advance = [&](long long count)
+        {
+            i += count;
+            while (j < n && i >= j)
+            {
+                i -= j;
+                j++;
+            }
+        };
+
+        for (const char* c = pos; c != end && j < n; c++)
+        {
+            int value = *c - 63;
+            if (value < 0 || value > 63)
+            {
+                error = "Bad graph6 character";
+                return false;
+            }
+
+            // Characters with no edges are skipped whole
+            if (value == 0)
+            {
+                advance(6);
+                continue;
+            }
+            for (int b = 5; b >= 0 && j < n; b--)
+            {
+                if ((value >> b) & 1)
+                    edgeList.push_back(make_pair((int)i, (int)j));
+                advance(1);
+            }
+        }
+
+        numVertices = (int)n;
+        return true;
+    }
+
+    bool parseSparse6(Scanner scanner, int& numVertices, vector<pair<int, int>>& edgeList, string& error)
+    {
+        skipHeader(scanner, ">>sparse6<<");
+        const char* end = scanner.lineEnd();
+        while (end != scanner.pos && end[-1] == '\r')
+            end--;
+
+        long long n;
+        const char* pos = scanner.pos;
+        if (pos == end || *pos++ != ':' || !readGraphSize(pos, end, n))
+        {
+            error = "Bad sparse6 vertex count";
+            return false;
+        }
+
+        int k = 1;
+        while ((1LL << k) < n)
+            k++;
+
+        // Each record is a flag bit (move to the next vertex) and a k bit
+        // vertex number; the last partial record is padding
+        SixBitReader reader(pos, end);
+        long long current = 0;
+        while (true)
+        {
+            int flag;
+            long long x;
+            if (!reader.bit(flag) || !reader.bits(k, x))
+                break;
+            if (flag)
+                current++;
+            if (current >= n)
+                break;
+            if (x > current)
+                current = x;
+            else
+                edgeList.push_back(make_pair((int)x, (int)current));
+        }
+
+        numVertices = (int)n;
+        return true;
+    }
+}
+
+bool importFormatFromPath(const string& path, ImportFormat& format)
+{
+    size_t dot = path.find_last_of('.');
+    if (dot == string::npos)
+        return false;
+    string extension = path.substr(dot);
+
+    if (extension == ".edges" || extension == ".txt" || extension == ".el")
+        format = ImportFormat::EdgeList;
+    else if (extension == ".g6")
+        format = ImportFormat::Graph6;
+    else if (extension == ".s6")
+        format = ImportFormat::Sparse6;
+    else if (extension == ".col" || extension == ".dimacs")
+        format = ImportFormat::Dimacs;
+    else
+        return false;
+    return true;
+}
+
+namespace
+{
+    // Format from the extension, or from the first character of the file
+    ImportFormat detectFormat(const string& path, const MappedFile& file)
+    {
+        ImportFormat format;
+        if (importFormatFromPath(path, format))
+            return format;
+
+        char first = file.size() > 0 ? file.data()[0] : '\0';
+        if (first == ':' || (file.size() > 2 && memcmp(file.data(), ">>s", 3) == 0))
+            return ImportFormat::Sparse6;
+        if (first == 'c' || first == 'p')
+            return ImportFormat::Dimacs;
+        if ((first >= '0' && first <= '9') || first == '#' || first == '%')
+            return ImportFormat::EdgeList;
+        return ImportFormat::Graph6;
+    }
+
+    bool parseGraph(ImportFormat format, const Scanner& scanner, int& numVertices, vector<pair<int, int>>& edgeList, string& error)
+    {
+        bool parsed = false;
+        switch (format)
+        {
+        case ImportFormat::EdgeList:
+            parsed = parseEdgeList(scanner, numVertices, edgeList, error);
+            break;
+        case ImportFormat::Graph6:
+            parsed = parseGraph6(scanner, numVertices, edgeList, error);
+            break;
+        case ImportFormat::Sparse6:
+            parsed = parseSparse6(scanner, numVertices, edgeList, error);
+            break;
+        case ImportFormat::Dimacs:
+            parsed = parseDimacs(scanner, numVertices, edgeList, error);
+            break;
+        }
+        if (parsed && numVertices > importVertexLimit)
+        {
+            error = to_string(numVertices) + " vertices is more than the " + to_string(importVertexLimit) + " a graph may have";
+            return false;
+        }
+        return parsed;
+    }
+}
+
+bool importGraph(const string& path, int& numVertices, vector<pair<int, int>>& edgeList, string& error)
+{
+    MappedFile file(path);
+    if (!file.isOpen())
+    {
+        error = "Could not open " + path;
+        return false;
+    }
+    if (file.size() == 0)
+    {
+        error = path + " is empty";
+        return false;
+    }
+
+    Scanner scanner = {file.data(), file.data() + file.size(), 1};
+    edgeList.clear();
+    bool loaded = parseGraph(detectFormat(path, file), scanner, numVertices, edgeList, error);
+    if (loaded && numVertices <= 0)
+    {
+        error = "The graph has no vertices";
+        loaded = false;
+    }
+    if (!loaded)
+        error = path + ": " + error;
+    return loaded;
+}
+
+bool importGraphs(const string& path, vector<ImportedGraph>& graphs, string& error)
+{
+    MappedFile file(path);
+    if (!file.isOpen())
+    {
+        error = "Could not open " + path;
+        return false;
+    }
+    if (file.size() == 0)
+    {
+        error = path + " is empty";
+        return false;
+    }
+
+    Scanner scanner = {file.data(), file.data() + file.size(), 1};
+    ImportFormat format = detectFormat(path, file);
+    if (format == ImportFormat::EdgeList || format == ImportFormat::Dimacs)
+    {
+        graphs.emplace_back();
+        if (!parseGraph(format, scanner, graphs.back().numVertices, graphs.back().edgeList, error))
+        {
+            graphs.pop_back();
+            error = path + ": " + error;
+            return false;
+        }
+        return true;
+    }
+
+    // graph6 and sparse6 files hold one graph per line
+    for (; !scanner.atEnd(); scanner.nextLine())
+    {
+        if (scanner.atLineEnd())
+            continue;
+        graphs.emplace_back();
+        if (!parseGraph(format, scanner, graphs.back().numVertices, graphs.back().edgeList, error))
+        {
+            graphs.pop_back();
+            error = path + ": " + lineError(scanner, error.c_str());
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// File formats a puzzle graph can be loaded from
+enum class ImportFormat
+{
+    EdgeList, // 0-based "u v" per line, '#' or '%' comments, optional "# n m" header
+    Graph6,   // nauty graph6, first graph in the file
+    Sparse6,  // nauty sparse6, first graph in the file
+    Dimacs    // "p edge n m" then 1-based "e u v" lines, 'c' comments
+};
+
+// Most vertices a loaded graph may have. The counts come from the file, so
+// this keeps a stray number from asking for gigabytes.
+const int importVertexLimit = 1 << 24;
+
+// Pick a format from a file extension (.edges/.txt/.el .g6 .s6 .col/.dimacs)
+bool importFormatFromPath(const std::string& path, ImportFormat& format);
+
+// Load a graph as a vertex count and a list of (start, end) vertex pairs. The
+// format comes from the extension, or from the first character of the file
+// when the extension is unknown. On failure returns false and sets error.
+bool importGraph(const std::string& path, int& numVertices, std::vector<std::pair<int, int>>& edgeList, std::string& error);
+
+// One graph read from a file
+struct ImportedGraph
+{
+    int numVertices = 0;
+    std::vector<std::pair<int, int>> edgeList;
+};
+
+// Load every graph in a file and append them to graphs. graph6 and sparse6
+// files hold one graph per line; the other formats hold a single graph.
+bool importGraphs(const std::string& path, std::vector<ImportedGraph>& graphs, std::string& error);
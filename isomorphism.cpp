@@ -0,0 +1,88 @@
+#include "isomorphism.hpp"
+
+using namespace std;
+
+SmallGraph makeSmallGraph(int numVertices, const vector<pair<int, int>>& edgeList)
+{
+    SmallGraph graph;
+    graph.numVertices = numVertices;
+    for (const auto& edge : edgeList)
+    {
+        if (edge.first == edge.second)
+            continue;
+        graph.rows[edge.first] |= bitOf(edge.second);
+        graph.rows[edge.second] |= bitOf(edge.first);
+    }
+    return graph;
+}
+
+SmallGraph relabel(const SmallGraph& graph, const int* permutation)
+{
+    SmallGraph result;
+    result.numVertices = graph.numVertices;
+    for (int v = 0; v < graph.numVertices; v++)
+    {
+        uint64_t row = 0;
+        for (uint64_t bits = graph.rows[v]; bits != 0; bits &= bits - 1)
+            row |= bitOf(permutation[lowestBit(bits)]);
+        result.rows[permutation[v]] = row;
+    }
+    return result;
+}
+
+bool isIsomorphism(const SmallGraph& a, const SmallGraph& b, const int* mapping)
+{
+    for (int v = 0; v < a.numVertices; v++)
+    {
+        uint64_t row = 0;
+        for (uint64_t bits = a.rows[v]; bits != 0; bits &= bits - 1)
+            row |= bitOf(mapping[lowestBit(bits)]);
+        if (row != b.rows[mapping[v]])
+            return false;
+    }
+    return true;
+}
+
+bool isIsomorphism(const Graph& a, const Graph& b, const int* mapping)
+{
+    // Equal edge counts and every edge mapped onto an edge is enough
+    for (int v = 0; v < a.numVertices; v++)
+    {
+        if (a.degree(v) != b.degree(mapping[v]))
+            return false;
+        for (const int* it = a.neighboursBegin(v); it != a.neighboursEnd(v); ++it)
+        {
+            if (*it > v && !b.adjacent(mapping[v], mapping[*it]))
+                return false;
+        }
+    }
+    return true;
+}
+
+vector<uint64_t> vertexInvariants(const SmallGraph& graph)
+{
+    vector<uint64_t> keys(graph.numVertices);
+    for (int v = 0; v < graph.numVertices; v++)
+    {
+        // Each triangle through v is seen from both of its other corners
+        uint64_t triangles = 0;
+        graph.forEachNeighbour(v, [&](int u) { triangles += popcount64(graph.rows[v] & graph.rows[u]); });
+        keys[v] = ((uint64_t)graph.degree(v) << 32) | (triangles / 2);
+    }
+    return keys;
+}
+
+vector<uint64_t> vertexInvariants(const Graph& graph)
+{
+    vector<uint64_t> keys(graph.numVertices);
+    for (int v = 0; v < graph.numVertices; v++)
+        keys[v] = (uint64_t)graph.degree(v);
+    return keys;
+}
+
+bool areIsomorphic(int numVertices, const vector<pair<int, int>>& edgesA, const vector<pair<int, int>>& edgesB, vector<int>* mapping)
+{
+    if (numVertices <= SmallGraph::capacity)
+        return findIsomorphism(makeSmallGraph(numVertices, edgesA), makeSmallGraph(numVertices, edgesB), mapping);
+    return findIsomorphism(buildGraph(numVertices, edgesA), buildGraph(numVertices, edgesB), mapping);
+}
@@ -0,0 +1,441 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "bits.hpp"
+#include "graph.hpp"
+
+// Graph with at most 64 vertices, one adjacency bit row per vertex. Degrees
+// are popcounts and adjacency tests single ANDs, so puzzles of the sizes
+// entered at the prompts are handled in registers and L1 cache.
+struct SmallGraph
+{
+    static constexpr int capacity = 64;
+    int numVertices = 0;
+    std::uint64_t rows[64] = {};
+
+    int size() const { return numVertices; }
+    int degree(int v) const { return popcount64(rows[v]); }
+    bool adjacent(int u, int v) const { return (rows[u] >> v) & 1; }
+    int numEdges() const
+    {
+        int total = 0;
+        for (int v = 0; v < numVertices; v++)
+            total += popcount64(rows[v]);
+        return total / 2;
+    }
+    template <typename Function>
+    void forEachNeighbour(int v, Function fn) const
+    {
+        for (std::uint64_t bits = rows[v]; bits != 0; bits &= bits - 1)
+            fn(lowestBit(bits));
+    }
+};
+
+// Build a small graph from (start, end) pairs; loops and repeats are folded
+// away as in buildGraph. numVertices must be at most 64.
+SmallGraph makeSmallGraph(int numVertices, const std::vector<std::pair<int, int>>& edgeList);
+
+// The same graph with vertex v renamed permutation[v], row by row bit permute
+SmallGraph relabel(const SmallGraph& graph, const int* permutation);
+
+// Whether mapping (vertex of a -> vertex of b) takes edges onto edges
+bool isIsomorphism(const SmallGraph& a, const SmallGraph& b, const int* mapping);
+bool isIsomorphism(const Graph& a, const Graph& b, const int* mapping);
+
+// Label independent starting colours: degree and triangles through each
+// vertex for small graphs, degree alone for large ones where counting
+// triangles could cost more than the search it saves
+std::vector<std::uint64_t> vertexInvariants(const SmallGraph& graph);
+std::vector<std::uint64_t> vertexInvariants(const Graph& graph);
+
+// Fixed size array for small graphs, vector for the general engine
+template <typename T, int Capacity>
+struct VertexArrayStorage
+{
+    std::array<T, Capacity> items;
+    void resize(int) {}
+    T& operator[](int i) { return items[i]; }
+    const T& operator[](int i) const { return items[i]; }
+    T* begin() { return items.data(); }
+};
+
+template <typename T>
+struct VertexArrayStorage<T, 0>
+{
+    std::vector<T> items;
+    void resize(int n) { items.resize(n); }
+    T& operator[](int i) { return items[i]; }
+    const T& operator[](int i) const { return items[i]; }
+    T* begin() { return items.data(); }
+};
+
+// Ordered partition of the vertices into cells, as used by colour
+// refinement. Cells are runs of positions in order; each is named by the
+// position it starts at.
+template <int Capacity>
+class Partition
+{
+public:
+    void reset(int n)
+    {
+        m_size = n;
+        m_cells = n > 0 ? 1 : 0;
+        order.resize(n);
+        position.resize(n);
+        cellStart.resize(n);
+        cellLength.resize(n);
+        for (int v = 0; v < n; v++)
+        {
+            order[v] = v;
+            position[v] = v;
+            cellStart[v] = 0;
+        }
+        if (n > 0)
+            cellLength[0] = n;
+    }
+
+    int size() const { return m_size; }
+    int cellCount() const { return m_cells; }
+    bool discrete() const { return m_cells == m_size; }
+    int at(int p) const { return order[p]; }
+    int cellOf(int v) const { return cellStart[v]; }
+    int lengthOf(int start) const { return cellLength[start]; }
+
+    // First of the smallest cells with more than one vertex, or -1
+    int targetCell() const
+    {
+        int best = -1;
+        for (int start = 0; start < m_size; start += cellLength[start])
+        {
+            if (cellLength[start] > 1 && (best == -1 || cellLength[start] < cellLength[best]))
+                best = start;
+        }
+        return best;
+    }
+
+    // Give v a cell of its own at the front of its old cell; returns its start
+    int individualise(int v)
+    {
+        int start = cellStart[v];
+        int length = cellLength[start];
+        int other = order[start];
+        std::swap(order[start], order[position[v]]);
+        position[other] = position[v];
+        position[v] = start;
+        if (length > 1)
+        {
+            cellLength[start] = 1;
+            cellLength[start + 1] = length - 1;
+            for (int p = start + 1; p < start + length; p++)
+                cellStart[order[p]] = start + 1;
+            m_cells++;
+        }
+        return start;
+    }
+
+    // Split the range [start, start + length) of a cell, already sorted by
+    // key, into one cell per run of equal keys. Returns the number of cells.
+    template <typename Key>
+    int splitSorted(int start, int length, const Key& key)
+    {
+        int pieces = 1;
+        int pieceStart = start;
+        for (int p = start + 1; p <= start + length; p++)
+        {
+            if (p == start + length || key(order[p]) != key(order[p - 1]))
+            {
+                cellLength[pieceStart] = p - pieceStart;
+                for (int q = pieceStart; q < p; q++)
+                    cellStart[order[q]] = pieceStart;
+                if (p < start + length)
+                {
+                    pieceStart = p;
+                    pieces++;
+                }
+            }
+        }
+        m_cells += pieces - 1;
+        return pieces;
+    }
+
+    VertexArrayStorage<int, Capacity> order;      // vertex at each position
+    VertexArrayStorage<int, Capacity> position;   // position of each vertex
+    VertexArrayStorage<int, Capacity> cellStart;  // cell of each vertex
+    VertexArrayStorage<int, Capacity> cellLength; // length, valid at cell starts
+
+private:
+    int m_size = 0;
+    int m_cells = 0;
+};
+
+// Running hash of the choices made during refinement. Two graphs refined the
+// same way give the same trace; a different trace rules out a match.
+inline std::uint64_t traceMix(std::uint64_t trace, std::uint64_t value)
+{
+    std::uint64_t x = trace ^ (value + 0x9E3779B97F4A7C15ULL + (trace << 6) + (trace >> 2));
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    return x ^ (x >> 27);
+}
+
+// Number of neighbours in cell W for every vertex next to it. Touched
+// vertices are listed so the counts can be cleared afterwards.
+template <typename G, typename Counts, typename Touched>
+void countNeighboursIn(const G& graph, const Partition<G::capacity>& partition, int cell, Counts& counts, Touched& touched, int& touchedCount)
+{
+    for (int p = cell; p < cell + partition.lengthOf(cell); p++)
+    {
+        graph.forEachNeighbour(partition.at(p), [&](int u)
+        {
+            if (counts[u]++ == 0)
+                touched[touchedCount++] = u;
+        });
+    }
+}
+
+// Bitboard version: one mask for the cell, then a popcount per touched vertex
+template <typename Counts, typename Touched>
+void countNeighboursIn(const SmallGraph& graph, const Partition<64>& partition, int cell, Counts& counts, Touched& touched, int& touchedCount)
+{
+    std::uint64_t members = 0, reached = 0;
+    for (int p = cell; p < cell + partition.lengthOf(cell); p++)
+    {
+        members |= bitOf(partition.at(p));
+        reached |= graph.rows[partition.at(p)];
+    }
+    for (; reached != 0; reached &= reached - 1)
+    {
+        int u = lowestBit(reached);
+        counts[u] = popcount64(graph.rows[u] & members);
+        touched[touchedCount++] = u;
+    }
+}
+
+// Refine to the coarsest equitable partition: every vertex of a cell has the
+// same number of neighbours in every other cell. Splitting uses cells in the
+// order they are queued, so the result only depends on the graph's structure
+// and the current cells, not on vertex numbers. splitter is the one cell to
+// start from after individualising, or -1 to start from every cell.
+template <typename G>
+std::uint64_t refinePartition(const G& graph, Partition<G::capacity>& partition, int splitter)
+{
+    constexpr int Capacity = G::capacity;
+    int n = partition.size();
+    VertexArrayStorage<int, Capacity> counts, touched, touchedCells, queue;
+    VertexArrayStorage<char, Capacity> queued, cellTouched;
+    counts.resize(n);
+    touched.resize(n);
+    touchedCells.resize(n);
+    queue.resize(n);
+    queued.resize(n);
+    cellTouched.resize(n);
+    std::fill(counts.begin(), counts.begin() + n, 0);
+    std::fill(queued.begin(), queued.begin() + n, 0);
+    std::fill(cellTouched.begin(), cellTouched.begin() + n, 0);
+
+    // Circular queue of cell starts; a cell is never queued twice at once
+    int head = 0, queueLength = 0;
+    auto enqueue = [&](int cell)
+    {
+        queue[(head + queueLength++) % n] = cell;
+        queued[cell] = 1;
+    };
+    if (splitter >= 0)
+        enqueue(splitter);
+    else
+    {
+        for (int start = 0; start < n; start += partition.lengthOf(start))
+            enqueue(start);
+    }
+
+    std::uint64_t trace = 0;
+    while (queueLength > 0 && !partition.discrete())
+    {
+        int cell = queue[head];
+        head = (head + 1) % n;
+        queueLength--;
+        queued[cell] = 0;
+
+        int touchedCount = 0;
+        countNeighboursIn(graph, partition, cell, counts, touched, touchedCount);
+
+        int touchedCellCount = 0;
+        for (int i = 0; i < touchedCount; i++)
+        {
+            int start = partition.cellOf(touched[i]);
+            if (!cellTouched[start])
+            {
+                cellTouched[start] = 1;
+                touchedCells[touchedCellCount++] = start;
+            }
+        }
+        std::sort(touchedCells.begin(), touchedCells.begin() + touchedCellCount);
+
+        for (int i = 0; i < touchedCellCount; i++)
+        {
+            int start = touchedCells[i];
+            int length = partition.lengthOf(start);
+            cellTouched[start] = 0;
+
+            auto count = [&](int v) { return counts[v]; };
+            int* begin = partition.order.begin() + start;
+            std::sort(begin, begin + length, [&](int a, int b) { return counts[a] < counts[b]; });
+            for (int p = start; p < start + length; p++)
+                partition.position[partition.at(p)] = p;
+
+            bool wasQueued = queued[start];
+            int pieces = partition.splitSorted(start, length, count);
+            trace = traceMix(trace, ((std::uint64_t)start << 32) | (std::uint64_t)pieces);
+
+            // Queue the new cells; a cell that was not queued already can
+            // leave out its largest piece (Hopcroft's trick)
+            int largest = start;
+            for (int piece = start; piece < start + length; piece += partition.lengthOf(piece))
+            {
+                trace = traceMix(trace, ((std::uint64_t)counts[partition.at(piece)] << 32) | (std::uint64_t)partition.lengthOf(piece));
+                if (partition.lengthOf(piece) > partition.lengthOf(largest))
+                    largest = piece;
+            }
+            if (pieces > 1)
+            {
+                for (int piece = start; piece < start + length; piece += partition.lengthOf(piece))
+                {
+                    if (!queued[piece] && (wasQueued || piece != largest))
+                        enqueue(piece);
+                }
+            }
+        }
+
+        for (int i = 0; i < touchedCount; i++)
+            counts[touched[i]] = 0;
+    }
+    return trace;
+}
+
+// Split the single starting cell by vertex invariants, smallest key first
+template <int Capacity>
+std::uint64_t splitByKeys(Partition<Capacity>& partition, const std::vector<std::uint64_t>& keys)
+{
+    int n = partition.size();
+    int* begin = partition.order.begin();
+    std::sort(begin, begin + n, [&](int a, int b) { return keys[a] < keys[b]; });
+    for (int p = 0; p < n; p++)
+        partition.position[partition.at(p)] = p;
+    if (n == 0)
+        return 0;
+    partition.splitSorted(0, n, [&](int v) { return keys[v]; });
+
+    std::uint64_t trace = 0;
+    for (int start = 0; start < n; start += partition.lengthOf(start))
+        trace = traceMix(trace, keys[partition.at(start)] ^ ((std::uint64_t)partition.lengthOf(start) << 48));
+    return trace;
+}
+
+// Individualisation-refinement search for an isomorphism from a to b. The
+// partition of a is refined along one fixed path; for b every vertex of the
+// matching cell is tried in turn and kept while the traces agree.
+template <typename G>
+class IsomorphismSearch
+{
+public:
+    IsomorphismSearch(const G& a, const G& b) : m_a(a), m_b(b) {}
+
+    bool run(std::vector<int>* mapping)
+    {
+        int n = m_a.size();
+        if (n != m_b.size() || m_a.numEdges() != m_b.numEdges())
+            return false;
+
+        std::vector<std::uint64_t> keysA = vertexInvariants(m_a);
+        std::vector<std::uint64_t> keysB = vertexInvariants(m_b);
+        std::vector<std::uint64_t> sortedA = keysA, sortedB = keysB;
+        std::sort(sortedA.begin(), sortedA.end());
+        std::sort(sortedB.begin(), sortedB.end());
+        if (sortedA != sortedB)
+            return false;
+
+        Partition<G::capacity> partitionA, partitionB;
+        partitionA.reset(n);
+        partitionB.reset(n);
+        std::uint64_t traceA = splitByKeys(partitionA, keysA);
+        std::uint64_t traceB = splitByKeys(partitionB, keysB);
+        traceA = traceMix(traceA, refinePartition(m_a, partitionA, -1));
+        traceB = traceMix(traceB, refinePartition(m_b, partitionB, -1));
+        if (traceA != traceB || partitionA.cellCount() != partitionB.cellCount())
+            return false;
+
+        if (!match(partitionA, partitionB))
+            return false;
+        if (mapping != nullptr)
+            *mapping = m_mapping;
+        return true;
+    }
+
+    // Continue from partitions that were individualised and refined the same
+    // way, as the automorphism search does with both graphs the same
+    bool match(const Partition<G::capacity>& partitionA, const Partition<G::capacity>& partitionB)
+    {
+        m_mapping.resize(m_a.size());
+        return search(partitionA, partitionB);
+    }
+
+    // Isomorphism found by the last successful run or match
+    const std::vector<int>& mapping() const { return m_mapping; }
+
+private:
+    // Map position by position and check whether that is already an isomorphism
+    bool tryPositions(const Partition<G::capacity>& partitionA, const Partition<G::capacity>& partitionB)
+    {
+        for (int p = 0; p < partitionA.size(); p++)
+            m_mapping[partitionA.at(p)] = partitionB.at(p);
+        return isIsomorphism(m_a, m_b, m_mapping.data());
+    }
+
+    bool search(const Partition<G::capacity>& partitionA, const Partition<G::capacity>& partitionB)
+    {
+        // Discrete partitions leave a single candidate. Finer partitions often
+        // line up already (empty, complete or very symmetric graphs), which
+        // saves individualising all the way down.
+        if (tryPositions(partitionA, partitionB))
+            return true;
+        if (partitionA.discrete())
+            return false;
+
+        int cell = partitionA.targetCell();
+        Partition<G::capacity> nextA = partitionA;
+        nextA.individualise(partitionA.at(cell));
+        std::uint64_t traceA = refinePartition(m_a, nextA, cell);
+
+        for (int p = cell; p < cell + partitionB.lengthOf(cell); p++)
+        {
+            Partition<G::capacity> nextB = partitionB;
+            nextB.individualise(partitionB.at(p));
+            std::uint64_t traceB = refinePartition(m_b, nextB, cell);
+            if (traceA == traceB && nextA.cellCount() == nextB.cellCount() && search(nextA, nextB))
+                return true;
+        }
+        return false;
+    }
+
+    const G& m_a;
+    const G& m_b;
+    std::vector<int> m_mapping;
+};
+
+// Find an isomorphism from a to b; mapping[v] is the vertex of b matched
+// with vertex v of a
+template <typename G>
+bool findIsomorphism(const G& a, const G& b, std::vector<int>* mapping = nullptr)
+{
+    return IsomorphismSearch<G>(a, b).run(mapping);
+}
+
+// Isomorphism test on two edge lists over the same vertex count, ignoring
+// loops and repeated edges. Up to 64 vertices runs on SmallGraph bitboards,
+// larger graphs on the general CSR engine.
+bool areIsomorphic(int numVertices, const std::vector<std::pair<int, int>>& edgesA, const std::vector<std::pair<int, int>>& edgesB,
+                   std::vector<int>* mapping = nullptr);
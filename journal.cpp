@@ -0,0 +1,442 @@
+#include "journal.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+#include "logger.hpp"
+#include "mappedfile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    // Both files start with a magic, the format version and the puzzle, all
+    // little-endian. The journal header then holds the number of records
+    // before its first one; the snapshot holds the records it covers, the
+    // vertex and edge counts, the positions and edges, and a checksum of it all.
+    const char journalMagic[4] = {'I', 'S', 'J', 'L'};
+    const char snapshotMagic[4] = {'I', 'S', 'S', 'N'};
+    const uint32_t formatVersion = 1;
+    const size_t headerSize = 4 + 4 + 3 * 4 + 8;
+
+    // A record is its type byte, the payload and a checksum of both
+    enum RecordType
+    {
+        VertexPlaced = 1, // float x, float y
+        EdgeAdded = 2,    // uint32 start, uint32 end
+        EdgeUndone = 3,
+        VertexMoved = 4   // uint32 vertex, float x, float y
+    };
+
+    uint32_t checksum(const char* data, size_t size)
+    {
+        // FNV-1a
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= (unsigned char)data[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    void putUint32(vector<char>& out, uint32_t value)
+    {
+        for (int shift = 0; shift < 32; shift += 8)
+            out.push_back((char)((value >> shift) & 0xFF));
+    }
+
+    void putUint64(vector<char>& out, uint64_t value)
+    {
+        putUint32(out, (uint32_t)value);
+        putUint32(out, (uint32_t)(value >> 32));
+    }
+
+    void putFloat(vector<char>& out, float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, 4);
+        putUint32(out, bits);
+    }
+
+    uint32_t getUint32(const char* data)
+    {
+        const unsigned char* bytes = (const unsigned char*)data;
+        return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    }
+
+    uint64_t getUint64(const char* data)
+    {
+        return getUint32(data) | ((uint64_t)getUint32(data + 4) << 32);
+    }
+
+    float getFloat(const char* data)
+    {
+        uint32_t bits = getUint32(data);
+        float value;
+        memcpy(&value, &bits, 4);
+        return value;
+    }
+
+    void putHeader(vector<char>& out, const char* magic, const DrawingState& state)
+    {
+        out.insert(out.end(), magic, magic + 4);
+        putUint32(out, formatVersion);
+        putUint32(out, state.seed);
+        putUint32(out, (uint32_t)state.numVertices);
+        putUint32(out, (uint32_t)state.numEdges);
+        putUint64(out, state.records);
+    }
+
+    bool getHeader(const char* data, size_t size, const char* magic, DrawingState& state)
+    {
+        if (size < headerSize || memcmp(data, magic, 4) != 0 || getUint32(data + 4) != formatVersion)
+            return false;
+        state.seed = getUint32(data + 8);
+        state.numVertices = (int)getUint32(data + 12);
+        state.numEdges = (int)getUint32(data + 16);
+        state.records = getUint64(data + 20);
+        return state.numVertices >= 0 && state.numEdges >= 0;
+    }
+
+    // Apply one record to the drawing. False if it cannot follow the state,
+    // which can only mean the journal is damaged from here on.
+    bool applyRecord(DrawingState& state, int type, sf::Vector2f position, int startVertex, int endVertex)
+    {
+        int placed = (int)state.vertices.size();
+        switch (type)
+        {
+        case VertexPlaced:
+            if (placed >= state.numVertices)
+                return false;
+            state.vertices.push_back(position);
+            break;
+        case EdgeAdded:
+            if ((int)state.edges.size() >= state.numEdges || startVertex < 0 || startVertex >= placed || endVertex < 0 || endVertex >= placed)
+                return false;
+            state.edges.push_back(make_pair(startVertex, endVertex));
+            break;
+        case EdgeUndone:
+            if (state.edges.empty())
+                return false;
+            state.edges.pop_back();
+            break;
+        case VertexMoved:
+            if (startVertex < 0 || startVertex >= placed)
+                return false;
+            state.vertices[startVertex] = position;
+            break;
+        default:
+            return false;
+        }
+        state.records++;
+        return true;
+    }
+
+    // Decode the record at data; 0 if it is cut short or fails its checksum
+    size_t decodeRecord(const char* data, size_t size, int& type, sf::Vector2f& position, int& startVertex, int& endVertex)
+    {
+        if (size < 1)
+            return 0;
+        type = (unsigned char)data[0];
+        size_t payload = type == EdgeUndone ? 0 : type == VertexMoved ? 12 : 8;
+        if (size < 1 + payload + 4 || checksum(data, 1 + payload) != getUint32(data + 1 + payload))
+            return 0;
+        if (type == VertexPlaced)
+            position = sf::Vector2f(getFloat(data + 1), getFloat(data + 5));
+        else if (type == EdgeAdded)
+        {
+            startVertex = (int)getUint32(data + 1);
+            endVertex = (int)getUint32(data + 5);
+        }
+        else if (type == VertexMoved)
+        {
+            startVertex = (int)getUint32(data + 1);
+            position = sf::Vector2f(getFloat(data + 5), getFloat(data + 9));
+        }
+        return 1 + payload + 4;
+    }
+
+    bool syncFile(FILE* file)
+    {
+        if (fflush(file) != 0)
+            return false;
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    // Write bytes to a temporary file, sync it and rename it over path, so
+    // path holds either the old contents or all of the new
+    bool replaceFile(const string& path, const vector<char>& bytes)
+    {
+        string temporary = path + ".tmp";
+        FILE* file = fopen(temporary.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+        bool written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() && syncFile(file);
+        if (fclose(file) != 0 || !written)
+            return false;
+#ifdef _WIN32
+        return MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        if (rename(temporary.c_str(), path.c_str()) != 0)
+            return false;
+
+        // The rename itself only lasts once the directory is synced
+        size_t slash = path.find_last_of('/');
+        string directory = slash == string::npos ? "." : path.substr(0, slash + 1);
+        int descriptor = open(directory.c_str(), O_RDONLY);
+        if (descriptor >= 0)
+        {
+            fsync(descriptor);
+            close(descriptor);
+        }
+        return true;
+#endif
+    }
+
+    string snapshotPath(const string& path)
+    {
+        return path + ".snapshot";
+    }
+
+    bool readSnapshot(const string& path, DrawingState& state)
+    {
+        MappedFile file(path);
+        if (!file.isOpen() || !getHeader(file.data(), file.size(), snapshotMagic, state) || file.size() < headerSize + 12)
+            return false;
+        const char* data = file.data();
+        size_t vertexCount = getUint32(data + headerSize);
+        size_t edgeCount = getUint32(data + headerSize + 4);
+        size_t size = headerSize + 8 + 8 * vertexCount + 8 * edgeCount;
+        if ((int)vertexCount > state.numVertices || (int)edgeCount > state.numEdges || file.size() != size + 4 ||
+            checksum(data, size) != getUint32(data + size))
+            return false;
+
+        const char* next = data + headerSize + 8;
+        for (size_t i = 0; i < vertexCount; i++, next += 8)
+            state.vertices.push_back(sf::Vector2f(getFloat(next), getFloat(next + 4)));
+        for (size_t i = 0; i < edgeCount; i++, next += 8)
+        {
+            int startVertex = (int)getUint32(next);
+            int endVertex = (int)getUint32(next + 4);
+            if (startVertex < 0 || startVertex >= (int)vertexCount || endVertex < 0 || endVertex >= (int)vertexCount)
+                return false;
+            state.edges.push_back(make_pair(startVertex, endVertex));
+        }
+        return true;
+    }
+}
+
+bool recoverDrawing(const string& path, DrawingState& state)
+{
+    state = DrawingState();
+    bool haveSnapshot = readSnapshot(snapshotPath(path), state);
+    if (!haveSnapshot)
+        state = DrawingState();
+
+    MappedFile file(path);
+    DrawingState journal;
+    if (file.isOpen() && getHeader(file.data(), file.size(), journalMagic, journal))
+    {
+        // Without a snapshot the journal must go back to the start, and it
+        // must not begin after the records the snapshot covers
+        bool samePuzzle = journal.seed == state.seed && journal.numVertices == state.numVertices && journal.numEdges == state.numEdges;
+        if (!haveSnapshot && journal.records == 0)
+        {
+            state = journal;
+            samePuzzle = true;
+        }
+        if (samePuzzle && journal.records <= state.records)
+        {
+            unsigned long long sequence = journal.records;
+            size_t offset = headerSize;
+            int type = 0, startVertex = 0, endVertex = 0;
+            sf::Vector2f position;
+            while (size_t used = decodeRecord(file.data() + offset, file.size() - offset, type, position, startVertex, endVertex))
+            {
+                offset += used;
+                if (sequence++ < state.records)
+                    continue;
+                if (!applyRecord(state, type, position, startVertex, endVertex))
+                    break;
+            }
+        }
+    }
+    return !state.vertices.empty();
+}
+
+void discardJournal(const string& path)
+{
+    remove(path.c_str());
+    remove(snapshotPath(path).c_str());
+}
+
+SessionJournal::SessionJournal(const string& path, const DrawingState& state)
+    : m_path(path), m_state(state)
+{
+    // A recovered drawing becomes the snapshot the new journal starts from
+    if (m_state.vertices.empty())
+        remove(snapshotPath(m_path).c_str());
+    else if (!writeSnapshot())
+        m_failed = true;
+    if (!m_failed && !restartJournal())
+        m_failed = true;
+    if (m_failed)
+        logError("Could not start the session journal " + m_path + "; the drawing will not be recoverable.");
+    m_writer = thread(&SessionJournal::writerLoop, this);
+}
+
+SessionJournal::~SessionJournal()
+{
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_stopping = true;
+    }
+    m_hasRecords.notify_all();
+    m_writer.join();
+    if (m_file != nullptr)
+        fclose(m_file);
+}
+
+void SessionJournal::vertexPlaced(sf::Vector2f position)
+{
+    queue(Record{VertexPlaced, position, 0, 0});
+}
+
+void SessionJournal::edgeAdded(int startVertex, int endVertex)
+{
+    queue(Record{EdgeAdded, sf::Vector2f(), startVertex, endVertex});
+}
+
+void SessionJournal::edgeUndone()
+{
+    queue(Record{EdgeUndone, sf::Vector2f(), 0, 0});
+}
+
+void SessionJournal::vertexMoved(int vertex, sf::Vector2f position)
+{
+    queue(Record{VertexMoved, position, vertex, 0});
+}
+
+void SessionJournal::queue(const Record& record)
+{
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_pending.push_back(record);
+    }
+    m_hasRecords.notify_one();
+}
+
+// Wait for a record, give the rest of the burst the commit interval to
+// arrive, then take the lot in one go and commit it without holding the lock
+void SessionJournal::writerLoop()
+{
+    vector<Record> batch;
+    while (true)
+    {
+        {
+            unique_lock<mutex> lock(m_lock);
+            m_hasRecords.wait(lock, [&]() { return !m_pending.empty() || m_stopping; });
+            m_hasRecords.wait_for(lock, chrono::milliseconds(journalCommitMilliseconds), [&]() { return m_stopping; });
+            if (m_pending.empty() && m_stopping)
+                return;
+            batch.swap(m_pending);
+        }
+        commit(batch);
+        batch.clear();
+    }
+}
+
+void SessionJournal::commit(const vector<Record>& batch)
+{
+    vector<char> bytes;
+    for (const Record& record : batch)
+    {
+        if (!applyRecord(m_state, record.type, record.position, record.startVertex, record.endVertex))
+            continue;
+        size_t start = bytes.size();
+        bytes.push_back((char)record.type);
+        if (record.type == VertexPlaced)
+        {
+            putFloat(bytes, record.position.x);
+            putFloat(bytes, record.position.y);
+        }
+        else if (record.type == EdgeAdded)
+        {
+            putUint32(bytes, (uint32_t)record.startVertex);
+            putUint32(bytes, (uint32_t)record.endVertex);
+        }
+        else if (record.type == VertexMoved)
+        {
+            putUint32(bytes, (uint32_t)record.startVertex);
+            putFloat(bytes, record.position.x);
+            putFloat(bytes, record.position.y);
+        }
+        putUint32(bytes, checksum(bytes.data() + start, bytes.size() - start));
+        m_sinceSnapshot++;
+    }
+    if (m_failed || bytes.empty())
+        return;
+
+    if (fwrite(bytes.data(), 1, bytes.size(), m_file) != bytes.size() || !syncFile(m_file))
+    {
+        m_failed = true;
+        logError("Could not write the session journal " + m_path + "; the drawing will not be recoverable.");
+        return;
+    }
+    if (m_sinceSnapshot >= journalSnapshotInterval && writeSnapshot() && !restartJournal())
+        m_failed = true;
+}
+
+bool SessionJournal::writeSnapshot()
+{
+    vector<char> bytes;
+    bytes.reserve(headerSize + 12 + 8 * (m_state.vertices.size() + m_state.edges.size()));
+    putHeader(bytes, snapshotMagic, m_state);
+    putUint32(bytes, (uint32_t)m_state.vertices.size());
+    putUint32(bytes, (uint32_t)m_state.edges.size());
+    for (sf::Vector2f position : m_state.vertices)
+    {
+        putFloat(bytes, position.x);
+        putFloat(bytes, position.y);
+    }
+    for (const auto& edge : m_state.edges)
+    {
+        putUint32(bytes, (uint32_t)edge.first);
+        putUint32(bytes, (uint32_t)edge.second);
+    }
+    putUint32(bytes, checksum(bytes.data(), bytes.size()));
+    return replaceFile(snapshotPath(m_path), bytes);
+}
+
+// Swap in an empty journal that starts where the state stands
+bool SessionJournal::restartJournal()
+{
+    if (m_file != nullptr)
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    vector<char> header;
+    putHeader(header, journalMagic, m_state);
+    if (!replaceFile(m_path, header))
+        return false;
+    m_file = fopen(m_path.c_str(), "ab");
+    m_sinceSnapshot = 0;
+    return m_file != nullptr;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Journal kept next to the game unless --journal names another
+const char* const defaultJournalPath = "session.journal";
+
+// Records written between snapshots. Each snapshot replaces the journal, so
+// recovery replays at most this many records on top of it.
+const int journalSnapshotInterval = 4096;
+
+// Longest a record waits before it is written and synced. Records arriving in
+// the meantime go out with it, so a burst of clicks costs a single fsync.
+const int journalCommitMilliseconds = 50;
+
+// An unfinished drawing: the puzzle it belongs to, the vertex positions in
+// placement order and the edges still standing, newest last
+struct DrawingState
+{
+    unsigned seed = 0;
+    int numVertices = 0;
+    int numEdges = 0;
+    std::vector<sf::Vector2f> vertices;
+    std::vector<std::pair<int, int>> edges;
+    unsigned long long records = 0; // journal records behind this state
+};
+
+// Load the snapshot kept beside path and replay the journal records after it.
+// A torn or corrupt tail is dropped from the first bad record on. False when
+// there is no drawing to recover.
+bool recoverDrawing(const std::string& path, DrawingState& state);
+
+// Delete the journal and its snapshot
+void discardJournal(const std::string& path);
+
+// Append-only binary log of vertex placements and moves, edge adds and
+// undos. The render thread only queues a record; a writer thread appends
+// whatever has gathered, flushes and fsyncs once per batch, and every
+// journalSnapshotInterval records writes a snapshot of the drawing and starts
+// the journal over. Snapshot and fresh journal are each written to a
+// temporary file and renamed into place, so a crash at any point leaves a
+// pair recoverDrawing can read.
+class SessionJournal
+{
+public:
+    // Start a journal at path whose history begins at state: empty for a new
+    // drawing, or as recovered
+    SessionJournal(const std::string& path, const DrawingState& state);
+
+    // Writes and syncs everything still queued
+    ~SessionJournal();
+
+    SessionJournal(const SessionJournal&) = delete;
+    SessionJournal& operator=(const SessionJournal&) = delete;
+
+    void vertexPlaced(sf::Vector2f position);
+    void edgeAdded(int startVertex, int endVertex);
+    void edgeUndone();
+    void vertexMoved(int vertex, sf::Vector2f position); // corner, as placed
+
+private:
+    struct Record
+    {
+        int type;
+        sf::Vector2f position;
+        int startVertex;
+        int endVertex;
+    };
+
+    void queue(const Record& record);
+    void writerLoop();
+    void commit(const std::vector<Record>& batch);
+    bool writeSnapshot();
+    bool restartJournal();
+
+    std::string m_path;
+    DrawingState m_state; // the drawing as of the last committed record, for snapshots
+    int m_sinceSnapshot = 0;
+    std::FILE* m_file = nullptr;
+    bool m_failed = false;
+
+    std::mutex m_lock;
+    std::condition_variable m_hasRecords;
+    std::vector<Record> m_pending;
+    bool m_stopping = false;
+    std::thread m_writer;
+};
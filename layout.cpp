@@ -0,0 +1,767 @@
+#include "layout.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <numeric>
+
+#include "distances.hpp"
+#include "parallel.hpp"
+#include "planarity.hpp"
+#include "random.hpp"
+
+using namespace std;
+using namespace sf;
+
+namespace
+{
+    // One level of the coarsening hierarchy
+    struct Level
+    {
+        Graph graph;
+        vector<int> weights; // number of original vertices merged into each vertex
+        vector<int> parent;  // vertex on the next coarser level
+    };
+
+    // Match every vertex with its lightest unmatched neighbour and contract the pairs
+    Level coarsen(Level& fine, Random& rng)
+    {
+        const Graph& graph = fine.graph;
+        int n = graph.numVertices;
+
+        vector<int> order = randomPermutation(n, rng);
+
+        fine.parent.assign(n, -1);
+        Level coarse;
+        int coarseCount = 0;
+        for (int v : order)
+        {
+            if (fine.parent[v] != -1)
+                continue;
+
+            int match = -1;
+            for (const int* it = graph.neighboursBegin(v); it != graph.neighboursEnd(v); ++it)
+            {
+                if (fine.parent[*it] == -1 && *it != v && (match == -1 || fine.weights[*it] < fine.weights[match]))
+                    match = *it;
+            }
+
+            fine.parent[v] = coarseCount;
+            int weight = fine.weights[v];
+            if (match != -1)
+            {
+                fine.parent[match] = coarseCount;
+                weight += fine.weights[match];
+            }
+            coarse.weights.push_back(weight);
+            coarseCount++;
+        }
+
+        vector<pair<int, int>> edgeList;
+        edgeList.reserve(graph.neighbours.size() / 2);
+        for (int v = 0; v < n; v++)
+        {
+            for (const int* it = graph.neighboursBegin(v); it != graph.neighboursEnd(v); ++it)
+            {
+                if (v < *it && fine.parent[v] != fine.parent[*it])
+                    edgeList.push_back(make_pair(fine.parent[v], fine.parent[*it]));
+            }
+        }
+        coarse.graph = buildGraph(coarseCount, edgeList);
+
+        return coarse;
+    }
+
+    // Barnes-Hut quadtree used to approximate repulsion from far away vertices
+    class QuadTree
+    {
+    public:
+        void build(const vector<Vector2f>& positions, const vector<int>& weights)
+        {
+            m_positions = &positions;
+            m_weights = &weights;
+            m_order.resize(positions.size());
+            iota(m_order.begin(), m_order.end(), 0);
+
+            float minX = positions[0].x, maxX = positions[0].x;
+            float minY = positions[0].y, maxY = positions[0].y;
+            for (const Vector2f& position : positions)
+            {
+                minX = min(minX, position.x);
+                maxX = max(maxX, position.x);
+                minY = min(minY, position.y);
+                maxY = max(maxY, position.y);
+            }
+
+            Node root;
+            root.middle = Vector2f((minX + maxX) / 2.f, (minY + maxY) / 2.f);
+            root.half = max(max(maxX - minX, maxY - minY) / 2.f, 1e-3f);
+            root.begin = 0;
+            root.end = (int)m_order.size();
+            m_nodes.assign(1, root);
+            split(0, 0);
+        }
+
+        // Sum of the k^2 / d repulsion on vertex v, opening cells using theta
+        Vector2f repulsion(int v, float k, float theta) const
+        {
+            const Vector2f& position = (*m_positions)[v];
+            Vector2f force(0.f, 0.f);
+            int stack[256];
+            int top = 0;
+            stack[top++] = 0;
+
+            while (top > 0)
+            {
+                const Node& node = m_nodes[stack[--top]];
+                Vector2f delta = position - node.centre;
+                float distanceSquared = delta.x * delta.x + delta.y * delta.y;
+                float side = 2.f * node.half;
+
+                if (node.firstChild == -1)
+                {
+                    // Leaves hold a single vertex, or several that coincide
+                    for (int i = node.begin; i < node.end; i++)
+                    {
+                        int u = m_order[i];
+                        if (u != v)
+                            force += repel(position - (*m_positions)[u], (float)(*m_weights)[u], v, u, k);
+                    }
+                }
+                else if (side * side < theta * theta * distanceSquared)
+                    force += delta * (node.mass * k * k / distanceSquared);
+                else
+                {
+                    for (int child = node.firstChild; child < node.firstChild + 4; child++)
+                    {
+                        if (m_nodes[child].begin < m_nodes[child].end)
+                            stack[top++] = child;
+                    }
+                }
+            }
+
+            return force;
+        }
+
+        // Repulsion of a vertex at delta from v, with a fixed push for coincident points
+        static Vector2f repel(Vector2f delta, float weight, int v, int u, float k)
+        {
+            float distanceSquared = delta.x * delta.x + delta.y * delta.y;
+            if (distanceSquared < 1e-6f)
+            {
+                float angle = (float)(v * 7919 + u) * 0.61803f;
+                return Vector2f(cos(angle), sin(angle)) * (0.1f * k);
+            }
+            return delta * (weight * k * k / distanceSquared);
+        }
+
+    private:
+        struct Node
+        {
+            Vector2f middle; // centre of the square
+            float half;      // half the side of the square
+            Vector2f centre; // centre of mass
+            float mass = 0.f;
+            int firstChild = -1; // four consecutive children, or -1 for a leaf
+            int begin, end;      // range of m_order covered by this node
+        };
+
+        void split(int index, int depth)
+        {
+            const vector<Vector2f>& positions = *m_positions;
+            int begin = m_nodes[index].begin;
+            int end = m_nodes[index].end;
+
+            float mass = 0.f;
+            Vector2f centre(0.f, 0.f);
+            for (int i = begin; i < end; i++)
+            {
+                float weight = (float)(*m_weights)[m_order[i]];
+                mass += weight;
+                centre += positions[m_order[i]] * weight;
+            }
+            m_nodes[index].mass = mass;
+            m_nodes[index].centre = mass > 0.f ? centre / mass : m_nodes[index].middle;
+
+            // Stop at single vertices, and at a fixed depth so coincident points share a leaf
+            if (end - begin <= 1 || depth >= 40)
+                return;
+
+            Vector2f middle = m_nodes[index].middle;
+            float quarter = m_nodes[index].half / 2.f;
+            auto first = m_order.begin() + begin;
+            auto last = m_order.begin() + end;
+            auto top = partition(first, last, [&](int v) { return positions[v].y < middle.y; });
+            auto topLeft = partition(first, top, [&](int v) { return positions[v].x < middle.x; });
+            auto bottomLeft = partition(top, last, [&](int v) { return positions[v].x < middle.x; });
+            int bounds[5] = {begin, (int)(topLeft - m_order.begin()), (int)(top - m_order.begin()), (int)(bottomLeft - m_order.begin()), end};
+
+            int firstChild = (int)m_nodes.size();
+            m_nodes[index].firstChild = firstChild;
+            m_nodes.resize(m_nodes.size() + 4);
+            for (int q = 0; q < 4; q++)
+            {
+                Node& child = m_nodes[firstChild + q];
+                child.middle = Vector2f(middle.x + (q % 2 == 0 ? -quarter : quarter), middle.y + (q < 2 ? -quarter : quarter));
+                child.half = quarter;
+                child.begin = bounds[q];
+                child.end = bounds[q + 1];
+            }
+            for (int q = 0; q < 4; q++)
+            {
+                if (bounds[q] < bounds[q + 1])
+                    split(firstChild + q, depth + 1);
+            }
+        }
+
+        const vector<Vector2f>* m_positions = nullptr;
+        const vector<int>* m_weights = nullptr;
+        vector<Node> m_nodes;
+        vector<int> m_order;
+    };
+
+    // Fruchterman-Reingold refinement of one level. Repulsion is exact on small
+    // graphs and Barnes-Hut approximated otherwise. Attraction scatters into
+    // both endpoints, so every worker gets its own accumulator which is summed
+    // before the vertices move.
+    void refine(const Level& level, vector<Vector2f>& positions, float k, int iterations, float temperature, const CancelToken* cancel)
+    {
+        const Graph& graph = level.graph;
+        int n = graph.numVertices;
+        int workers = workerCount();
+        bool exact = n <= 256;
+
+        vector<Vector2f> displacement(n);
+        vector<vector<Vector2f>> accumulators(workers, vector<Vector2f>(n));
+        QuadTree tree;
+
+        for (int iteration = 0; iteration < iterations; iteration++)
+        {
+            if (cancel != nullptr && cancel->cancelled())
+                return;
+            if (!exact)
+                tree.build(positions, level.weights);
+
+            // Repulsion only writes to the vertex itself, so it needs no accumulator
+            parallelFor(n, [&](int begin, int end, int)
+            {
+                for (int v = begin; v < end; v++)
+                {
+                    if (!exact)
+                    {
+                        displacement[v] = tree.repulsion(v, k, 0.9f);
+                        continue;
+                    }
+
+                    Vector2f force(0.f, 0.f);
+                    for (int u = 0; u < n; u++)
+                    {
+                        if (u != v)
+                            force += QuadTree::repel(positions[v] - positions[u], (float)level.weights[u], v, u, k);
+                    }
+                    displacement[v] = force;
+                }
+            }, 256);
+
+            // Attraction along every edge, visited once from its lower endpoint
+            for (auto& accumulator : accumulators)
+                fill(accumulator.begin(), accumulator.end(), Vector2f(0.f, 0.f));
+            parallelFor(n, [&](int begin, int end, int worker)
+            {
+                vector<Vector2f>& accumulator = accumulators[worker];
+                for (int v = begin; v < end; v++)
+                {
+                    for (const int* it = graph.neighboursBegin(v); it != graph.neighboursEnd(v); ++it)
+                    {
+                        int u = *it;
+                        if (u < v)
+                            continue;
+                        Vector2f delta = positions[v] - positions[u];
+                        float distance = sqrt(delta.x * delta.x + delta.y * delta.y);
+                        Vector2f force = delta * (distance / k);
+                        accumulator[v] -= force;
+                        accumulator[u] += force;
+                    }
+                }
+            });
+
+            // Sum the accumulators and move each vertex by at most the temperature
+            parallelFor(n, [&](int begin, int end, int)
+            {
+                for (int v = begin; v < end; v++)
+                {
+                    Vector2f total = displacement[v];
+                    for (const auto& accumulator : accumulators)
+                        total += accumulator[v];
+
+                    float length = sqrt(total.x * total.x + total.y * total.y);
+                    if (length > 1e-9f)
+                        positions[v] += total * (min(length, temperature) / length);
+                }
+            });
+
+            temperature *= 0.92f;
+        }
+    }
+
+    // Scale a layout in arbitrary units into the panel, keeping its aspect ratio
+    void fitToArea(const vector<Vector2f>& layout, const FloatRect& area, vector<Vector2f>& positions)
+    {
+        float margin = 20.f;
+        float minX = layout[0].x, maxX = layout[0].x;
+        float minY = layout[0].y, maxY = layout[0].y;
+        for (const Vector2f& position : layout)
+        {
+            minX = min(minX, position.x);
+            maxX = max(maxX, position.x);
+            minY = min(minY, position.y);
+            maxY = max(maxY, position.y);
+        }
+        float width = max(maxX - minX, 1e-6f);
+        float height = max(maxY - minY, 1e-6f);
+        float scale = min((area.width - 2.f * margin) / width, (area.height - 2.f * margin) / height);
+        Vector2f offset(area.left + (area.width - width * scale) / 2.f, area.top + (area.height - height * scale) / 2.f);
+
+        positions.resize(layout.size());
+        for (size_t v = 0; v < layout.size(); v++)
+            positions[v] = Vector2f((layout[v].x - minX) * scale, (layout[v].y - minY) * scale) + offset;
+    }
+
+    // Hop distances from source to every vertex, or -1 when unreachable
+    void bfsDistances(const Graph& graph, int source, vector<int>& distances, vector<int>& queue)
+    {
+        distances.assign(graph.numVertices, -1);
+        queue.resize(graph.numVertices);
+        int head = 0, tail = 0;
+        distances[source] = 0;
+        queue[tail++] = source;
+        while (head < tail)
+        {
+            int v = queue[head++];
+            for (const int* it = graph.neighboursBegin(v); it != graph.neighboursEnd(v); ++it)
+            {
+                if (distances[*it] == -1)
+                {
+                    distances[*it] = distances[v] + 1;
+                    queue[tail++] = *it;
+                }
+            }
+        }
+    }
+
+    // Distance table with one row per pivot. Vertices in other components are
+    // treated as one hop further away than anything reachable.
+    struct PivotDistances
+    {
+        vector<int> pivots;
+        vector<float> rows; // rows[p * n + v]
+    };
+
+    PivotDistances choosePivots(const Graph& graph, int count, Random& rng)
+    {
+        int n = graph.numVertices;
+        PivotDistances table;
+        vector<int> distances, queue;
+        vector<int> nearest(n, INT_MAX);
+
+        // Max-min selection: each new pivot is the vertex furthest from all previous ones
+        int pivot = (int)rng.below((uint32_t)n);
+        for (int p = 0; p < count; p++)
+        {
+            table.pivots.push_back(pivot);
+            bfsDistances(graph, pivot, distances, queue);
+
+            int furthest = 0;
+            for (int v = 0; v < n; v++)
+                furthest = max(furthest, distances[v]);
+            for (int v = 0; v < n; v++)
+                table.rows.push_back(distances[v] == -1 ? (float)(furthest + 1) : (float)distances[v]);
+
+            int next = pivot;
+            for (int v = 0; v < n; v++)
+            {
+                if (distances[v] != -1)
+                    nearest[v] = min(nearest[v], distances[v]);
+                if (nearest[v] > nearest[next] || (nearest[next] == 0 && nearest[v] != 0))
+                    next = v;
+            }
+            if (nearest[next] == 0)
+                break;
+            pivot = next;
+        }
+
+        return table;
+    }
+
+    // PivotMDS (Brandes and Pich): classical scaling restricted to the pivot
+    // columns, giving a good starting point for stress majorization
+    vector<Vector2f> pivotMds(const PivotDistances& table, int n, Random& rng)
+    {
+        int k = (int)table.pivots.size();
+
+        // Double centre the squared distances
+        vector<double> centred(table.rows.size());
+        vector<double> rowMean(n, 0.0), columnMean(k, 0.0);
+        double totalMean = 0.0;
+        for (int p = 0; p < k; p++)
+        {
+            for (int v = 0; v < n; v++)
+            {
+                double squared = (double)table.rows[p * n + v] * table.rows[p * n + v];
+                centred[p * n + v] = squared;
+                rowMean[v] += squared / k;
+                columnMean[p] += squared / n;
+                totalMean += squared / ((double)n * k);
+            }
+        }
+        for (int p = 0; p < k; p++)
+        {
+            for (int v = 0; v < n; v++)
+                centred[p * n + v] = -0.5 * (centred[p * n + v] - rowMean[v] - columnMean[p] + totalMean);
+        }
+
+        // Top two eigenvectors of the small k x k matrix C^T C by power iteration
+        vector<double> product(k * k, 0.0);
+        for (int p = 0; p < k; p++)
+        {
+            for (int q = p; q < k; q++)
+            {
+                double sum = 0.0;
+                for (int v = 0; v < n; v++)
+                    sum += centred[p * n + v] * centred[q * n + v];
+                product[p * k + q] = product[q * k + p] = sum;
+            }
+        }
+
+        vector<vector<double>> eigenvectors;
+        for (int axis = 0; axis < 2; axis++)
+        {
+            vector<double> vec(k), next(k);
+            for (double& value : vec)
+                value = rng.uniform(-1.0, 1.0);
+            for (int iteration = 0; iteration < 100; iteration++)
+            {
+                for (const auto& previous : eigenvectors)
+                {
+                    double dot = 0.0;
+                    for (int p = 0; p < k; p++)
+                        dot += vec[p] * previous[p];
+                    for (int p = 0; p < k; p++)
+                        vec[p] -= dot * previous[p];
+                }
+                double norm = 0.0;
+                for (int p = 0; p < k; p++)
+                {
+                    next[p] = 0.0;
+                    for (int q = 0; q < k; q++)
+                        next[p] += product[p * k + q] * vec[q];
+                    norm += next[p] * next[p];
+                }
+                norm = sqrt(norm);
+                if (norm < 1e-12)
+                    break;
+                for (int p = 0; p < k; p++)
+                    vec[p] = next[p] / norm;
+            }
+            eigenvectors.push_back(vec);
+        }
+
+        vector<Vector2f> layout(n, Vector2f(0.f, 0.f));
+        for (int v = 0; v < n; v++)
+        {
+            double x = 0.0, y = 0.0;
+            for (int p = 0; p < k; p++)
+            {
+                x += centred[p * n + v] * eigenvectors[0][p];
+                y += centred[p * n + v] * eigenvectors[1][p];
+            }
+            // Tiny index based offset so vertices at the same point can separate
+            layout[v] = Vector2f((float)x + 1e-3f * (v % 7), (float)y + 1e-3f * (v % 5));
+        }
+        return layout;
+    }
+
+    // Rescale a starting layout so its distances best match the target distances
+    void matchScale(vector<Vector2f>& layout, const PivotDistances& table)
+    {
+        int n = (int)layout.size();
+        double numerator = 0.0, denominator = 0.0;
+        for (size_t p = 0; p < table.pivots.size(); p++)
+        {
+            Vector2f pivot = layout[table.pivots[p]];
+            for (int v = 0; v < n; v++)
+            {
+                float target = table.rows[p * n + v];
+                if (target <= 0.f)
+                    continue;
+                Vector2f delta = layout[v] - pivot;
+                double distance = sqrt(delta.x * delta.x + delta.y * delta.y);
+                numerator += distance / target;
+                denominator += distance * distance / ((double)target * target);
+            }
+        }
+        if (denominator > 0.0)
+        {
+            float scale = (float)(numerator / denominator);
+            for (Vector2f& position : layout)
+                position *= scale;
+        }
+    }
+
+    // Full SMACOF on the all-pairs distance matrix with weights 1 / d^2. Each
+    // sweep is a Jacobi step over tiles of rows and columns so the column block
+    // of coordinates stays in cache; the inner loop is branch free over
+    // separate x and y arrays so the compiler can vectorise it.
+    void fullStress(const vector<float>& distances, vector<Vector2f>& layout, int iterations, const CancelToken* cancel)
+    {
+        const int rowTile = 64;
+        const int columnTile = 512;
+        int n = (int)layout.size();
+        vector<float> xs(n), ys(n), nextX(n), nextY(n);
+        for (int v = 0; v < n; v++)
+        {
+            xs[v] = layout[v].x;
+            ys[v] = layout[v].y;
+        }
+
+        int tiles = (n + rowTile - 1) / rowTile;
+        for (int iteration = 0; iteration < iterations; iteration++)
+        {
+            if (cancel != nullptr && cancel->cancelled())
+                break;
+            vector<float> movement(tiles, 0.f);
+            parallelFor(tiles, [&](int begin, int end, int)
+            {
+                for (int tile = begin; tile < end; tile++)
+                {
+                    int rowBegin = tile * rowTile;
+                    int rowEnd = min(rowBegin + rowTile, n);
+                    float sumW[rowTile] = {}, sumX[rowTile] = {}, sumY[rowTile] = {};
+
+                    for (int columnBegin = 0; columnBegin < n; columnBegin += columnTile)
+                    {
+                        int columnEnd = min(columnBegin + columnTile, n);
+                        for (int i = rowBegin; i < rowEnd; i++)
+                        {
+                            const float* row = distances.data() + (size_t)i * n;
+                            float xi = xs[i], yi = ys[i];
+                            float w = 0.f, x = 0.f, y = 0.f;
+                            for (int j = columnBegin; j < columnEnd; j++)
+                            {
+                                float dx = xi - xs[j];
+                                float dy = yi - ys[j];
+                                float length = sqrt(dx * dx + dy * dy) + 1e-6f;
+                                float target = row[j];
+                                float weight = target > 0.f ? 1.f / (target * target) : 0.f;
+                                float pull = weight * target / length;
+                                w += weight;
+                                x += weight * xs[j] + pull * dx;
+                                y += weight * ys[j] + pull * dy;
+                            }
+                            sumW[i - rowBegin] += w;
+                            sumX[i - rowBegin] += x;
+                            sumY[i - rowBegin] += y;
+                        }
+                    }
+
+                    for (int i = rowBegin; i < rowEnd; i++)
+                    {
+                        float w = sumW[i - rowBegin];
+                        nextX[i] = w > 0.f ? sumX[i - rowBegin] / w : xs[i];
+                        nextY[i] = w > 0.f ? sumY[i - rowBegin] / w : ys[i];
+                        movement[tile] = max(movement[tile], fabs(nextX[i] - xs[i]) + fabs(nextY[i] - ys[i]));
+                    }
+                }
+            }, 1);
+
+            xs.swap(nextX);
+            ys.swap(nextY);
+            if (*max_element(movement.begin(), movement.end()) < 1e-3f)
+                break;
+        }
+
+        for (int v = 0; v < n; v++)
+            layout[v] = Vector2f(xs[v], ys[v]);
+    }
+
+    // Sparse stress (Ortmann, Klimenta and Brandes) for graphs too large for the
+    // full matrix: every vertex keeps exact terms to its neighbours and weighted
+    // terms to each pivot, standing in for the vertices closest to that pivot.
+    void pivotStress(const Graph& graph, const PivotDistances& table, vector<Vector2f>& layout, int iterations, const CancelToken* cancel)
+    {
+        int n = graph.numVertices;
+        int k = (int)table.pivots.size();
+
+        // Each pivot represents the vertices nearest to it
+        vector<float> regionSize(k, 0.f);
+        for (int v = 0; v < n; v++)
+        {
+            int closest = 0;
+            for (int p = 1; p < k; p++)
+            {
+                if (table.rows[p * n + v] < table.rows[closest * n + v])
+                    closest = p;
+            }
+            regionSize[closest] += 1.f;
+        }
+
+        vector<Vector2f> next(n);
+        for (int iteration = 0; iteration < iterations; iteration++)
+        {
+            if (cancel != nullptr && cancel->cancelled())
+                break;
+            parallelFor(n, [&](int begin, int end, int)
+            {
+                for (int v = begin; v < end; v++)
+                {
+                    float w = 0.f;
+                    Vector2f sum(0.f, 0.f);
+                    auto term = [&](const Vector2f& other, float target, float weight)
+                    {
+                        Vector2f delta = layout[v] - other;
+                        float length = sqrt(delta.x * delta.x + delta.y * delta.y) + 1e-6f;
+                        w += weight;
+                        sum += other * weight + delta * (weight * target / length);
+                    };
+
+                    for (const int* it = graph.neighboursBegin(v); it != graph.neighboursEnd(v); ++it)
+                        term(layout[*it], 1.f, 1.f);
+                    for (int p = 0; p < k; p++)
+                    {
+                        float target = table.rows[p * n + v];
+                        if (target > 1.f)
+                            term(layout[table.pivots[p]], target, regionSize[p] / (target * target));
+                    }
+                    next[v] = w > 0.f ? sum / w : layout[v];
+                }
+            });
+            layout.swap(next);
+        }
+    }
+}
+
+void multilevelLayout(const Graph& graph, const FloatRect& area, vector<Vector2f>& positions, unsigned seed, const CancelToken* cancel)
+{
+    int n = graph.numVertices;
+    positions.assign(n, Vector2f(area.left + area.width / 2.f, area.top + area.height / 2.f));
+    if (n <= 1)
+        return;
+
+    Random rng(seed);
+
+    // Build the hierarchy until the graph stops shrinking
+    vector<Level> levels(1);
+    levels[0].graph = graph;
+    levels[0].weights.assign(n, 1);
+    while (levels.back().graph.numVertices > 32)
+    {
+        Level coarse = coarsen(levels.back(), rng);
+        if (coarse.graph.numVertices > levels.back().graph.numVertices * 3 / 4)
+            break;
+        levels.push_back(move(coarse));
+    }
+
+    // Natural edge length grows by sqrt(7/4) per level, as in Walshaw's scheme
+    int coarsest = (int)levels.size() - 1;
+    float k = pow(sqrt(7.f / 4.f), (float)coarsest);
+
+    // Lay out the coarsest graph from random positions
+    const Level& top = levels[coarsest];
+    float side = k * sqrt((float)top.graph.numVertices);
+    vector<Vector2f> current(top.graph.numVertices);
+    for (Vector2f& position : current)
+        position = Vector2f(rng.uniform(0.f, side), rng.uniform(0.f, side));
+    refine(top, current, k, 300, side / 4.f, cancel);
+
+    // Interpolate each finer level from its parent and refine it
+    for (int l = coarsest - 1; l >= 0; l--)
+    {
+        k /= sqrt(7.f / 4.f);
+        const Level& level = levels[l];
+        vector<Vector2f> finer(level.graph.numVertices);
+        for (int v = 0; v < level.graph.numVertices; v++)
+            finer[v] = current[level.parent[v]] + Vector2f(rng.uniform(-0.1f, 0.1f), rng.uniform(-0.1f, 0.1f)) * k;
+        current.swap(finer);
+        refine(level, current, k, 30, 2.f * k, cancel);
+    }
+
+    fitToArea(current, area, positions);
+}
+
+void stressLayout(const Graph& graph, const FloatRect& area, vector<Vector2f>& positions, unsigned seed, const CancelToken* cancel)
+{
+    int n = graph.numVertices;
+    positions.assign(n, Vector2f(area.left + area.width / 2.f, area.top + area.height / 2.f));
+    if (n <= 1)
+        return;
+
+    Random rng(seed);
+    PivotDistances table = choosePivots(graph, min(n, 50), rng);
+    vector<Vector2f> layout = pivotMds(table, n, rng);
+    matchScale(layout, table);
+
+    if (n <= fullStressLimit)
+    {
+        // All-pairs hop distances from the bit-parallel search
+        vector<int> hops;
+        allPairsDistances(graph, hops);
+        vector<float> distances((size_t)n * n);
+        parallelFor(n, [&](int begin, int end, int)
+        {
+            for (int source = begin; source < end; source++)
+            {
+                const int* row = hops.data() + (size_t)source * n;
+                int furthest = *max_element(row, row + n);
+                for (int v = 0; v < n; v++)
+                    distances[(size_t)source * n + v] = row[v] == -1 ? (float)(furthest + 1) : (float)row[v];
+            }
+        }, 16);
+
+        // Unreachable pairs must look the same from both ends
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = i + 1; j < n; j++)
+            {
+                float distance = max(distances[(size_t)i * n + j], distances[(size_t)j * n + i]);
+                distances[(size_t)i * n + j] = distances[(size_t)j * n + i] = distance;
+            }
+        }
+        fullStress(distances, layout, 200, cancel);
+    }
+    else
+    {
+        // Beyond the full matrix limit, fall back to sparse stress on more pivots
+        table = choosePivots(graph, min(n, 200), rng);
+        pivotStress(graph, table, layout, 100, cancel);
+    }
+
+    fitToArea(layout, area, positions);
+}
+
+bool planarLayout(const Graph& graph, const FloatRect& area, vector<Vector2f>& positions)
+{
+    PlanarEmbedding embedding;
+    if (!planarEmbedding(graph, embedding))
+        return false;
+
+    vector<pair<int, int>> grid = straightLineDrawing(move(embedding));
+    positions.clear();
+    if (grid.empty())
+        return true;
+
+    // Grid y runs upwards, window y downwards
+    vector<Vector2f> layout(grid.size());
+    for (size_t v = 0; v < grid.size(); v++)
+        layout[v] = Vector2f((float)grid[v].first, -(float)grid[v].second);
+    fitToArea(layout, area, positions);
+    return true;
+}
+
+void applyLayout(vector<CircleShape>& panel, const vector<Vector2f>& positions)
+{
+    for (size_t i = 0; i < panel.size() && i < positions.size(); i++)
+    {
+        float radius = panel[i].getRadius();
+        panel[i].setPosition(positions[i] - Vector2f(radius, radius));
+    }
+}
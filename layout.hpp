@@ -0,0 +1,40 @@
+#pragma once
+
+#include <SFML/Graphics/CircleShape.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <vector>
+
+#include "cancel.hpp"
+#include "graph.hpp"
+
+// Placement used for a generated panel once the drawing is complete
+enum class LayoutMode
+{
+    Circle,
+    Force,
+    Stress
+};
+
+// Multilevel force-directed layout. The graph is coarsened by matching
+// neighbouring vertices, the coarsest graph is laid out directly and each
+// finer level is then refined starting from the level above it.
+// Positions are vertex centres scaled to fit inside area. A cancelled token
+// stops the refinement early; the positions are then only roughly placed.
+void multilevelLayout(const Graph& graph, const sf::FloatRect& area, std::vector<sf::Vector2f>& positions, unsigned seed, const CancelToken* cancel = nullptr);
+
+// Largest graph laid out by full stress majorization; bigger graphs use pivots
+const int fullStressLimit = 3000;
+
+// Stress majorization (SMACOF) on hop distances, started from PivotMDS.
+// Full all-pairs distances up to fullStressLimit vertices, pivot based sparse
+// stress beyond that. Used to make generated graph 2 look unlike graph 1.
+void stressLayout(const Graph& graph, const sf::FloatRect& area, std::vector<sf::Vector2f>& positions, unsigned seed, const CancelToken* cancel = nullptr);
+
+// Crossing-free straight-line layout of a planar graph: left-right planarity
+// test, then de Fraysseix-Pach-Pollack on the integer grid, both linear.
+// Returns false and leaves positions alone when the graph is not planar.
+bool planarLayout(const Graph& graph, const sf::FloatRect& area, std::vector<sf::Vector2f>& positions);
+
+// Move the vertex shapes of a generated panel so their centres sit at positions
+void applyLayout(std::vector<sf::CircleShape>& panel, const std::vector<sf::Vector2f>& positions);
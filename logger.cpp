@@ -0,0 +1,145 @@
+#include "logger.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // Fixed ring of pending messages shared with the writer thread
+    const size_t ringCapacity = 1024;
+
+    struct Entry
+    {
+        LogLevel level;
+        string text;
+    };
+
+    struct LogState
+    {
+        mutex lock;
+        condition_variable hasMessages;
+        condition_variable hasRoom;
+        vector<Entry> ring = vector<Entry>(ringCapacity);
+        size_t head = 0;  // oldest pending message
+        size_t count = 0; // number of pending messages
+        bool running = false;
+        bool stopping = false;
+        thread writer;
+        atomic<int> level{(int)LogLevel::Info};
+    };
+
+    LogState& state()
+    {
+        static LogState logState;
+        return logState;
+    }
+
+    void writeEntry(const Entry& entry)
+    {
+        FILE* stream = entry.level == LogLevel::Error ? stderr : stdout;
+        fwrite(entry.text.data(), 1, entry.text.size(), stream);
+    }
+
+    // Take every pending message in one go, write them without holding the
+    // lock and flush once per batch rather than once per line
+    void writerLoop()
+    {
+        LogState& log = state();
+        vector<Entry> batch;
+        while (true)
+        {
+            {
+                unique_lock<mutex> lock(log.lock);
+                log.hasMessages.wait(lock, [&]() { return log.count > 0 || log.stopping; });
+                if (log.count == 0 && log.stopping)
+                    return;
+
+                batch.clear();
+                while (log.count > 0)
+                {
+                    batch.push_back(move(log.ring[log.head]));
+                    log.head = (log.head + 1) % ringCapacity;
+                    log.count--;
+                }
+            }
+            log.hasRoom.notify_all();
+
+            for (const Entry& entry : batch)
+                writeEntry(entry);
+            fflush(stdout);
+            fflush(stderr);
+        }
+    }
+}
+
+LogWriter::LogWriter(LogLevel level)
+{
+    LogState& log = state();
+    log.level = (int)level;
+    lock_guard<mutex> lock(log.lock);
+    log.stopping = false;
+    log.running = true;
+    log.writer = thread(writerLoop);
+}
+
+LogWriter::~LogWriter()
+{
+    LogState& log = state();
+    {
+        lock_guard<mutex> lock(log.lock);
+        log.stopping = true;
+    }
+    log.hasMessages.notify_all();
+    log.writer.join();
+
+    lock_guard<mutex> lock(log.lock);
+    log.running = false;
+}
+
+bool logEnabled(LogLevel level)
+{
+    return (int)level <= state().level.load(memory_order_relaxed);
+}
+
+void logMessage(LogLevel level, string message)
+{
+    if (!logEnabled(level))
+        return;
+    if (message.empty() || message.back() != '\n')
+        message += '\n';
+
+    LogState& log = state();
+    unique_lock<mutex> lock(log.lock);
+    if (!log.running)
+    {
+        writeEntry(Entry{level, message});
+        return;
+    }
+
+    // Only waits if the writer has fallen a whole ring behind
+    log.hasRoom.wait(lock, [&]() { return log.count < ringCapacity; });
+    log.ring[(log.head + log.count) % ringCapacity] = Entry{level, move(message)};
+    log.count++;
+    lock.unlock();
+    log.hasMessages.notify_one();
+}
+
+LogLevel logLevelFromArguments(int argc, char* argv[])
+{
+    LogLevel level = LogLevel::Info;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quiet") == 0 || strcmp(argv[i], "-q") == 0)
+            level = LogLevel::Error;
+        else if (strcmp(argv[i], "--verbose") == 0 || strcmp(argv[i], "-v") == 0)
+            level = LogLevel::Verbose;
+    }
+    return level;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+
+// Message levels. Quiet mode keeps errors only, verbose mode adds the
+// per-click chatter of the drawing tools.
+enum class LogLevel
+{
+    Error,
+    Info,
+    Verbose
+};
+
+// Starts the background writer thread on construction and flushes every
+// queued message before joining it on destruction. Without a running writer,
+// messages are written straight away on the calling thread.
+class LogWriter
+{
+public:
+    explicit LogWriter(LogLevel level);
+    ~LogWriter();
+
+    LogWriter(const LogWriter&) = delete;
+    LogWriter& operator=(const LogWriter&) = delete;
+};
+
+// Whether messages of this level are currently written; check it before
+// formatting anything large
+bool logEnabled(LogLevel level);
+
+// Queue a message for the writer thread. A newline is added unless the
+// message already ends with one, so a multi-line report goes out as one block.
+void logMessage(LogLevel level, std::string message);
+
+inline void logError(std::string message) { logMessage(LogLevel::Error, std::move(message)); }
+inline void logInfo(std::string message) { logMessage(LogLevel::Info, std::move(message)); }
+inline void logVerbose(std::string message) { logMessage(LogLevel::Verbose, std::move(message)); }
+
+// Parse --quiet / -q and --verbose / -v from the command line
+LogLevel logLevelFromArguments(int argc, char* argv[]);
@@ -4,10 +4,41 @@
 #include <cmath>
 #include <vector>
 #include <stack>
+#include <charconv>
+#include <chrono>
+#include <memory>
+#include <unordered_set>
+
+#include "automorphism.hpp"
+#include "batch.hpp"
+#include "cliques.hpp"
+#include "colouring.hpp"
+#include "connectivity.hpp"
+#include "graph.hpp"
+#include "crossings.hpp"
+#include "distances.hpp"
+#include "enumeration.hpp"
+#include "generators.hpp"
+#include "exporter.hpp"
+#include "importer.hpp"
+#include "journal.hpp"
+#include "layout.hpp"
+#include "logger.hpp"
+#include "paths.hpp"
+#include "random.hpp"
+#include "scheduler.hpp"
+#include "session.hpp"
+#include "spectrum.hpp"
+#include "subgraph.hpp"
+#include "verify.hpp"
 
 using namespace std;
 using namespace sf;
 
+// Largest graph given the puzzle panels. They are driven by a dense adjacency
+// matrix, so bigger imported graphs are only shown in the drawing area.
+const int denseMatrixLimit = 2000;
+
 float calculateDistance(const Vector2f& point1, const Vector2f& point2)
 {
     float distanceX = point2.x - point1.x;
@@ -22,6 +53,50 @@ Vector2f getCenter(const CircleShape& shape)
     return Vector2f(position.x + radius, position.y + radius);
 }
 
+// Fill colour of a colour class. The first few are picked to stand apart (and
+// away from the yellow hover highlight); after them the hue steps round by the
+// golden angle so consecutive classes stay apart.
+Color vertexColour(int colour)
+{
+    static const Color palette[] = { Color::White, Color(230, 25, 75), Color(60, 180, 75), Color(67, 99, 216), Color(245, 130, 49),
+                                     Color(145, 30, 180), Color(66, 212, 244), Color(240, 50, 230), Color(170, 110, 40), Color(128, 128, 128) };
+    const int paletteSize = sizeof(palette) / sizeof(palette[0]);
+    if (colour < paletteSize)
+        return palette[colour];
+
+    float hue = fmod(colour * 137.508f, 360.f) / 60.f;
+    float x = 1.f - fabs(fmod(hue, 2.f) - 1.f);
+    float r = 0.f, g = 0.f, b = 0.f;
+    switch ((int)hue)
+    {
+    case 0:
+        r = 1.f;
+        g = x;
+        break;
+    case 1:
+        r = x;
+        g = 1.f;
+        break;
+    case 2:
+        g = 1.f;
+        b = x;
+        break;
+    case 3:
+        g = x;
+        b = 1.f;
+        break;
+    case 4:
+        r = x;
+        b = 1.f;
+        break;
+    default:
+        r = 1.f;
+        b = x;
+        break;
+    }
+    return Color((Uint8)(55 + 200 * r), (Uint8)(55 + 200 * g), (Uint8)(55 + 200 * b));
+}
+
 bool isInteger(string input)
 {
     for (int i = 0; i < input.size(); i++)
@@ -32,6 +107,84 @@ bool isInteger(string input)
     return true;
 }
 
+// Graph file named by --load <file> or -l <file>, or nullptr to ask for the sizes
+const char* loadPathFromArguments(int argc, char* argv[])
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        string argument = argv[i];
+        if (argument == "--load" || argument == "-l")
+            return argv[i + 1];
+    }
+    return nullptr;
+}
+
+// Pattern graph named by --pattern <file> for the subgraph puzzle, or nullptr
+const char* patternPathFromArguments(int argc, char* argv[])
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (string(argv[i]) == "--pattern")
+            return argv[i + 1];
+    }
+    return nullptr;
+}
+
+// Whether --induced asks for the pattern's non-edges to be matched too
+bool inducedPatternRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (string(argv[i]) == "--induced")
+            return true;
+    }
+    return false;
+}
+
+// Journal file named by --journal <file>, where an unfinished drawing is kept
+string journalPathFromArguments(int argc, char* argv[])
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (string(argv[i]) == "--journal")
+            return argv[i + 1];
+    }
+    return defaultJournalPath;
+}
+
+// Whether --fresh asks to throw away an unfinished drawing rather than recover it
+bool freshStartRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (string(argv[i]) == "--fresh")
+            return true;
+    }
+    return false;
+}
+
+// Session file named by --session <file>, restored in place of the size prompts
+const char* sessionPathFromArguments(int argc, char* argv[])
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (string(argv[i]) == "--session")
+            return argv[i + 1];
+    }
+    return nullptr;
+}
+
+// Session file code of an isLoopOrLine entry and back
+EdgeKind edgeKindOf(const string& name)
+{
+    return name == "Line" ? EdgeKind::Line : name == "Loop" ? EdgeKind::Loop : EdgeKind::None;
+}
+
+const char* edgeKindName(EdgeKind kind)
+{
+    return kind == EdgeKind::Line ? "Line" : kind == EdgeKind::Loop ? "Loop" : "";
+}
+
 Vector2f calculateBezierPoint(Vector2f p0, Vector2f p1, Vector2f p2, float t)
 {
     float u = 1.0f - t;
@@ -45,8 +198,235 @@ Vector2f calculateBezierPoint(Vector2f p0, Vector2f p1, Vector2f p2, float t)
     return point;
 }
 
-int main()
+// Append one adjacency matrix and the degree of each vertex to a report.
+// Generated graphs only see whether vertices are adjacent, so simple shows
+// every entry as 0 or 1.
+void appendMatrixReport(string& report, const char* matrixTitle, const char* degreeTitle, const vector<vector<int>>& adjacencyMatrix, bool simple)
+{
+    int numVertices = (int)adjacencyMatrix.size();
+    char number[16];
+
+    report += "\n";
+    report += matrixTitle;
+    report += "\n";
+    for (int i = 0; i < numVertices; i++)
+    {
+        for (int j = 0; j < numVertices; j++)
+        {
+            int value = simple ? (adjacencyMatrix[i][j] > 0 ? 1 : 0) : adjacencyMatrix[i][j];
+            report.append(number, to_chars(number, number + sizeof(number), value).ptr);
+            report += ' ';
+        }
+        report += '\n';
+    }
+
+    report += "\n";
+    report += degreeTitle;
+    report += "\n";
+    for (int i = 0; i < numVertices; i++)
+    {
+        int degree = 0;
+        for (int j = 0; j < numVertices; j++)
+            degree += simple ? (adjacencyMatrix[i][j] > 0 ? 1 : 0) : adjacencyMatrix[i][j];
+
+        report += "Vertex ";
+        report.append(number, to_chars(number, number + sizeof(number), i + 1).ptr);
+        report += ": ";
+        report.append(number, to_chars(number, number + sizeof(number), degree).ptr);
+        report += '\n';
+    }
+}
+
+// Log the adjacency matrices and degrees of the drawn graph and both generated
+// graphs as a single block
+void reportDrawnGraph(const vector<vector<int>>& adjacencyMatrix)
+{
+    if (!logEnabled(LogLevel::Info))
+        return;
+
+    size_t numVertices = adjacencyMatrix.size();
+    string report;
+    report.reserve(3 * (numVertices * numVertices * 2 + numVertices * 16 + 64));
+    appendMatrixReport(report, "Adjacency Matrix of Drawn Graph:", "Degree of the Graph of Drawn Graph:", adjacencyMatrix, false);
+    appendMatrixReport(report, "Adjacency Matrix for Generated Graph 1:", "Degree of the Generated Graph 1:", adjacencyMatrix, true);
+    appendMatrixReport(report, "Adjacency Matrix for Generated Graph 2:", "Degree of the Generated Graph 2:", adjacencyMatrix, true);
+    logInfo(move(report));
+}
+
+// Log the distance invariants, with the pairs at each distance in verbose mode
+void reportDistances(const Graph& graph, const CancelToken& cancel)
+{
+    DistanceInvariants invariants;
+    if (!distanceInvariants(graph, invariants, &cancel))
+        return;
+    logInfo(distanceSummary(invariants));
+    if (logEnabled(LogLevel::Verbose))
+    {
+        string histogram = "Pairs at each distance:";
+        for (size_t distance = 1; distance < invariants.distanceHistogram.size(); distance++)
+            histogram += " " + to_string(distance) + ":" + to_string(invariants.distanceHistogram[distance]);
+        logVerbose(histogram);
+    }
+}
+
+// Log where the --pattern graph occurs in the analysed graph, if anywhere
+void reportPattern(const Graph& pattern, const Graph& graph, bool induced, const CancelToken& cancel)
+{
+    string summary = patternMatchSummary(pattern, graph, induced, &cancel);
+    if (!summary.empty())
+        logInfo(summary);
+}
+
+// Log whether the drawing has an Euler trail and a Hamiltonian path, the
+// walks the challenge puzzles ask for. Ends are 1-based, as on screen; the
+// whole walks go to the verbose log.
+void reportTraversals(int n, const vector<pair<int, int>>& edgeList, const Graph& graph, const CancelToken& cancel)
+{
+    auto walkText = [](const char* title, const vector<int>& walk)
+    {
+        string text = title;
+        for (int v : walk)
+            text += " " + to_string(v + 1);
+        return text;
+    };
+
+    EulerTrail trail;
+    if (!eulerTrail(n, edgeList, trail))
+        logInfo("No Euler trail");
+    else if (!trail.edges.empty())
+    {
+        if (trail.closed)
+            logInfo("Euler circuit through all " + to_string(trail.edges.size()) + " edges from " + to_string(trail.vertices.front() + 1));
+        else
+            logInfo("Euler trail from " + to_string(trail.vertices.front() + 1) + " to " + to_string(trail.vertices.back() + 1));
+        if (logEnabled(LogLevel::Verbose))
+            logVerbose(walkText("Euler trail:", trail.vertices));
+    }
+
+    if (n > hamiltonianVertexLimit)
+        return;
+    vector<int> path;
+    Solvability solvability = hamiltonianPath(graph, path, &cancel);
+    if (cancel.cancelled())
+        return;
+    if (solvability == Solvability::Unsolvable)
+        logInfo("No Hamiltonian path");
+    else if (solvability == Solvability::Unknown)
+        logInfo("Hamiltonian path search gave up after " + to_string(hamiltonianWorkLimit) + " steps");
+    else if (!path.empty())
+    {
+        logInfo("Hamiltonian path from " + to_string(path.front() + 1) + " to " + to_string(path.back() + 1));
+        if (logEnabled(LogLevel::Verbose))
+            logVerbose(walkText("Hamiltonian path:", path));
+    }
+}
+
+// Log the triangles, and when the graph is small enough for bit rows the
+// 4-cliques, the maximal cliques and a maximum clique (1-based, as on screen).
+// Returns the maximum clique, or nothing if it was not found.
+vector<int> reportCliques(const Graph& graph, const CancelToken& cancel)
+{
+    string report = "Triangles " + to_string(countTriangles(graph));
+    vector<long long> counts;
+    long long maximal = 0;
+    vector<int> clique;
+    if (!countCliques(graph, 4, counts, &cancel) || !countMaximalCliques(graph, maximalCliqueLimit, maximal, &cancel) ||
+        !maximumClique(graph, clique, &cancel))
+    {
+        if (!cancel.cancelled())
+            logInfo(report);
+        return {};
+    }
+
+    report += ", 4-cliques " + to_string(counts[4]) + ", maximal cliques " + (maximal >= maximalCliqueLimit ? "at least " : "") +
+              to_string(maximal) + ", clique number " + to_string(clique.size()) + ":";
+    for (int v : clique)
+        report += " " + to_string(v + 1);
+    logInfo(report);
+    return clique;
+}
+
+// Colour the graph as well as the exact search manages, seeded with the
+// maximum clique if one was found, and log the chromatic number or its bounds.
+// Returns nothing if cancelled.
+vector<int> reportColouring(const Graph& graph, const vector<int>& clique, const CancelToken& cancel)
+{
+    vector<int> colours;
+    bool proved = chromaticColouring(graph, clique, colours, &cancel);
+    if (cancel.cancelled())
+        return {};
+    int count = colourCount(colours);
+    if (proved)
+        logInfo("Chromatic number " + to_string(count));
+    else
+        logInfo("Chromatic number between " + to_string(max((int)clique.size(), min(count, graph.numEdges() > 0 ? 2 : 1))) + " and " + to_string(count));
+    return colours;
+}
+
+// Lay out generated graph 2 in the given mode. Several candidates are tried and
+// the one whose crossing count differs most from graph 1 is returned. Each
+// candidate has its own seed derived from the puzzle seed.
+vector<CircleShape> chooseGraph2Layout(const vector<vector<int>>& adjacencyMatrix, const vector<CircleShape>& circleVertices2, LayoutMode mode,
+                                       const FloatRect& area, unsigned seed, long long crossings1, long long& crossings2, const CancelToken& cancel)
+{
+    Graph graph = buildGraph(adjacencyMatrix);
+    vector<CircleShape> best = circleVertices2;
+    long long bestDifference = -1;
+
+    for (int candidate = 0; candidate < 4 && !cancel.cancelled(); candidate++)
+    {
+        vector<CircleShape> placement = circleVertices2;
+        unsigned candidateSeed = (unsigned)mixSeed(seed, candidate);
+        if (mode == LayoutMode::Circle)
+        {
+            if (candidate > 0)
+            {
+                Random rng(candidateSeed);
+                permute(placement, rng);
+            }
+        }
+        else
+        {
+            vector<Vector2f> layoutPositions;
+            if (mode == LayoutMode::Stress)
+                stressLayout(graph, area, layoutPositions, candidateSeed, &cancel);
+            else
+                multilevelLayout(graph, area, layoutPositions, candidateSeed, &cancel);
+            applyLayout(placement, layoutPositions);
+        }
+
+        long long crossings = countCrossings(panelSegments(placement, adjacencyMatrix));
+        long long difference = crossings > crossings1 ? crossings - crossings1 : crossings1 - crossings;
+        if (difference > bestDifference)
+        {
+            bestDifference = difference;
+            crossings2 = crossings;
+            best = placement;
+        }
+    }
+
+    return best;
+}
+
+int main(int argc, char* argv[])
 {
+    // Messages from the event loop go through the background log writer
+    LogWriter logWriter(logLevelFromArguments(argc, argv));
+
+    // Puzzle generation, validation, shape enumeration and subgraph search
+    // for the content pipeline, no window
+    if (batchModeRequested(argc, argv))
+        return runBatch(argc, argv);
+    if (enumerationRequested(argc, argv))
+        return runEnumeration(argc, argv);
+    if (subgraphModeRequested(argc, argv))
+        return runSubgraphMode(argc, argv);
+
+    // Every random choice of the panels follows from this seed, so a puzzle
+    // can be replayed with --seed
+    unsigned puzzleSeed = seedFromArguments(argc, argv);
+    logInfo("Puzzle seed: " + to_string(puzzleSeed));
+
     // Define the designated area for drawing
     FloatRect drawingArea(0.f, 0.f, 400.f, 600.f);
     FloatRect isomorphicArea(400.f, 0.f, 800.f, 600.f);
@@ -73,7 +453,7 @@ int main()
     sf::Font font;
     if (!font.loadFromFile("src/font/Roboto-Bold.ttf"))
     {
-        std::cerr << "Failed to load font.\n";
+        logError("Failed to load font.");
         return 1;
     }
 
@@ -92,7 +472,87 @@ int main()
 
     int selectedOption = 1;
 
-    while (true)
+    // A loaded graph file, or a generated one in stress mode, replaces the
+    // size prompts and the drawing
+    const char* loadPath = loadPathFromArguments(argc, argv);
+    bool stressMode = generatorRequested(argc, argv);
+    bool graphProvided = loadPath != nullptr || stressMode;
+    vector<pair<int, int>> importedEdges;
+    if (graphProvided)
+    {
+        string error;
+        bool provided = stressMode ? generateFromArguments(argc, argv, puzzleSeed, numVertices, importedEdges, error)
+                                   : importGraph(loadPath, numVertices, importedEdges, error);
+        if (!provided)
+        {
+            logError(error);
+            return 1;
+        }
+        numEdges = (int)importedEdges.size();
+        logInfo(string(stressMode ? "Generated " : "Loaded ") + to_string(numVertices) + " vertices and " + to_string(numEdges) + " edges" +
+                (stressMode ? "" : string(" from ") + loadPath));
+    }
+
+    // Subgraph puzzle: a pattern graph to find inside the drawn or loaded one
+    const char* patternPath = patternPathFromArguments(argc, argv);
+    bool patternInduced = inducedPatternRequested(argc, argv);
+    Graph pattern;
+    if (patternPath != nullptr)
+    {
+        int patternVertices = 0;
+        vector<pair<int, int>> patternEdges;
+        string error;
+        if (!importGraph(patternPath, patternVertices, patternEdges, error))
+        {
+            logError(error);
+            return 1;
+        }
+        pattern = buildGraph(patternVertices, patternEdges);
+        logInfo(string("Pattern ") + patternPath + ": " + to_string(pattern.numVertices) + " vertices and " + to_string(pattern.numEdges()) + " edges" +
+                (patternInduced ? ", matched induced" : ""));
+    }
+
+    // A saved session brings its puzzle with it. The file stays mapped and
+    // its arrays are used in place once the game state exists.
+    const char* sessionPath = sessionPathFromArguments(argc, argv);
+    SessionFile sessionFile;
+    bool sessionLoaded = false;
+    auto sessionStart = chrono::steady_clock::now();
+    if (!graphProvided && sessionPath != nullptr)
+    {
+        string error;
+        if (!sessionFile.open(sessionPath, error))
+        {
+            logError(error);
+            return 1;
+        }
+        sessionLoaded = true;
+        numVertices = sessionFile.session().numVertices;
+        numEdges = sessionFile.session().numEdges;
+        puzzleSeed = sessionFile.session().seed;
+    }
+
+    // A drawing left unfinished by a crash or a closed window is picked up
+    // where it stopped, puzzle and all, unless --fresh says otherwise
+    string journalPath = journalPathFromArguments(argc, argv);
+    DrawingState startingDrawing;
+    bool drawingRecovered = false;
+    bool canRecover = !graphProvided && !sessionLoaded;
+    if (canRecover && freshStartRequested(argc, argv))
+        discardJournal(journalPath);
+    else if (canRecover && recoverDrawing(journalPath, startingDrawing))
+    {
+        drawingRecovered = true;
+        numVertices = startingDrawing.numVertices;
+        numEdges = startingDrawing.numEdges;
+        puzzleSeed = startingDrawing.seed;
+        logInfo("Recovered an unfinished drawing from " + journalPath + ": " + to_string(startingDrawing.vertices.size()) + " of " +
+                to_string(numVertices) + " vertices and " + to_string(startingDrawing.edges.size()) + " of " + to_string(numEdges) +
+                " edges, puzzle seed " + to_string(puzzleSeed) + ". Run with --fresh to start over.");
+    }
+
+    bool sizesKnown = graphProvided || sessionLoaded || drawingRecovered;
+    while (!sizesKnown)
     {
         cout << "Enter the number of vertices: ";
         cin >> numVert;
@@ -108,7 +568,7 @@ int main()
         }
     }
 
-    while (true)
+    while (!sizesKnown)
     {
         cout << "Enter the number of edges: ";
         cin >> numEdg;
@@ -124,14 +584,70 @@ int main()
         }
     }
 
+    // A new drawing starts its journal empty
+    if (!drawingRecovered)
+    {
+        startingDrawing.seed = puzzleSeed;
+        startingDrawing.numVertices = numVertices;
+        startingDrawing.numEdges = numEdges;
+    }
+
     // Create a vector to store the vertices and edges
     vector<CircleShape> vertices(numVertices);
     vector<Vertex> edges(numEdges * 2);
-    stack<vector<Vertex>> prevEdgesStack;
     stack<int> prevEdgeCountStack;
     int vertexCount = 0;
     int edgeCount = 0;
 
+    // Component count and odd cycle check, kept up to date edge by edge and
+    // rolled back with Ctrl+Z
+    IncrementalConnectivity connectivity(numVertices);
+
+    // Colour class of each vertex, shared by the drawing and both panels as
+    // they number the vertices alike. The drawn edges are kept per vertex so
+    // each new one can be fixed up on the spot; the panels are repainted only
+    // when the colours or their placements change.
+    vector<int> vertexColours(numVertices, 0);
+    vector<vector<int>> drawnNeighbours(numVertices);
+    vector<pair<int, int>> drawnEdgeEnds;
+    bool panelColoursStale = true;
+
+    // A new edge between two vertices of one colour moves its end vertex to
+    // the smallest colour none of its neighbours has
+    auto colourNewEdge = [&](int startVertex, int endVertex)
+    {
+        drawnEdgeEnds.push_back(make_pair(startVertex, endVertex));
+        if (startVertex == endVertex)
+            return;
+        drawnNeighbours[startVertex].push_back(endVertex);
+        drawnNeighbours[endVertex].push_back(startVertex);
+        if (vertexColours[startVertex] != vertexColours[endVertex])
+            return;
+
+        vector<char> taken(drawnNeighbours[endVertex].size() + 1, 0);
+        for (int neighbour : drawnNeighbours[endVertex])
+        {
+            if (vertexColours[neighbour] < (int)taken.size())
+                taken[vertexColours[neighbour]] = 1;
+        }
+        int colour = 0;
+        while (taken[colour])
+            colour++;
+        vertexColours[endVertex] = colour;
+        panelColoursStale = true;
+    };
+
+    // Taking an edge away cannot spoil a colouring, so only the lists change
+    auto uncolourUndoneEdge = [&]()
+    {
+        pair<int, int> ends = drawnEdgeEnds.back();
+        drawnEdgeEnds.pop_back();
+        if (ends.first == ends.second)
+            return;
+        drawnNeighbours[ends.first].pop_back();
+        drawnNeighbours[ends.second].pop_back();
+    };
+
     //Duplicate edges and looped edges
     VertexArray curveLine(LineStrip);
 
@@ -139,11 +655,17 @@ int main()
     bool edgeToolActive = false;
     int startVertexIndex = -1;
 
+    // Move tool: the picked vertex follows the mouse while the button is held,
+    // keeping the offset it was grabbed at
+    bool moveToolActive = false;
+    int draggedVertex = -1;
+    Vector2f dragOffset, dragStart;
+
     vector<CircleShape> loops;
     vector<vector<CircleShape>> vertexLoops(numVertices);
 
-    vector<vector<int>> adjacencyMatrix(numVertices, vector<int>(numVertices, 0));
-    vector<int> degrees(numVertices, 0);
+    int panelVertices = numVertices <= denseMatrixLimit ? numVertices : 0;
+    vector<vector<int>> adjacencyMatrix(panelVertices, vector<int>(panelVertices, 0));
 
     // Create a vector to store updated degrees of vertices and type of edge
     vector<int> updatingDegree(numEdges, 0);
@@ -153,8 +675,8 @@ int main()
     stack<vector<string>> prevIsLoopOrLineStack;
 
     // Generate and display the 2-isomorphism graphs
-    vector<CircleShape> isomorphicVertices1(numVertices);
-    vector<CircleShape> isomorphicVertices2(numVertices);
+    vector<CircleShape> isomorphicVertices1(panelVertices);
+    vector<CircleShape> isomorphicVertices2(panelVertices);
     float angleIncrement1 = 6.28318f / numVertices;
     float angleIncrement2 = 6.28318f / numVertices;
     float radius1 = 100.f;
@@ -164,19 +686,21 @@ int main()
     Vector2f center1(isomorphicArea.left + isomorphicArea.width / 4.f, isomorphicArea.top + isomorphicArea.height / 2.f);
     Vector2f center2(isomorphicArea.left + isomorphicArea.width * 3.f / 4.f, isomorphicArea.top + isomorphicArea.height / 2.f);
 
-    srand(time(0));
+    // Each generated graph gets one half of the isomorphic area
+    FloatRect panelArea1(isomorphicArea.left, isomorphicArea.top, isomorphicArea.width / 2.f, isomorphicArea.height);
+    FloatRect panelArea2(isomorphicArea.left + isomorphicArea.width / 2.f, isomorphicArea.top, isomorphicArea.width / 2.f, isomorphicArea.height);
 
-    for (int i = 0; i < numVertices; i++)
+    Random panelRandom(puzzleSeed);
+
+    for (int i = 0; i < panelVertices; i++)
     {
         CircleShape vertex1(5);
-        vertex1.setFillColor(Color::Green);
         CircleShape vertex2(5);
-        vertex2.setFillColor(Color::Red);
 
         float angle1 = i * angleIncrement1;
         float angle2 = i * angleIncrement2;
         Vector2f position1(center1.x + radius1 * cos(angle1), center1.y + radius1 * sin(angle1));
-        Vector2f position2(center2.x + (radius2 - (-40 + (rand() % 101))) * cos(angle2), center2.y + (radius2 - (-40 + (rand() % 101))) * sin(angle2));
+        Vector2f position2(center2.x + (radius2 - panelRandom.between(-40, 60)) * cos(angle2), center2.y + (radius2 - panelRandom.between(-40, 60)) * sin(angle2));
 
         vertex1.setPosition(position1);
         isomorphicVertices1[i] = vertex1;
@@ -185,8 +709,925 @@ int main()
         isomorphicVertices2[i] = vertex2;
     }
 
-    random_shuffle(isomorphicVertices1.begin(), isomorphicVertices1.end());
-    random_shuffle(isomorphicVertices2.begin(), isomorphicVertices2.end());
+    permute(isomorphicVertices1, panelRandom);
+    permute(isomorphicVertices2, panelRandom);
+
+    // Keep the circle placement so graph 2 can switch back to it
+    vector<CircleShape> circleVertices2 = isomorphicVertices2;
+    LayoutMode layoutMode2 = LayoutMode::Force;
+    bool graphComplete = false;
+
+    // Vertex pairs of the finished drawing, kept for exporting
+    vector<pair<int, int>> drawnEdges;
+
+    // Edge crossing counts shown under each panel
+    long long drawingCrossings = 0, crossings1 = 0, crossings2 = 0;
+    Text drawingCrossingsText("", font, 16);
+    drawingCrossingsText.setPosition(drawingArea.left + 10.f, drawingArea.top + drawingArea.height - 30.f);
+    Text crossingsText1("", font, 16);
+    crossingsText1.setPosition(panelArea1.left + 10.f, panelArea1.top + panelArea1.height - 30.f);
+    Text crossingsText2("", font, 16);
+    crossingsText2.setPosition(panelArea2.left + 10.f, panelArea2.top + panelArea2.height - 30.f);
+    Text connectivityText("", font, 16);
+    connectivityText.setPosition(drawingArea.left + 200.f, drawingArea.top + drawingArea.height - 30.f);
+
+    // Verify mode: the player maps drawing vertices onto generated graph 2 one
+    // click at a time and is told after each pair whether the mapping still fits
+    bool verifyModeActive = false;
+    vector<vector<int>> verifyMatrix;
+    unique_ptr<PartialMapping> verifyMapping;
+    int verifySource = -1;
+    Text verifyText("", font, 16);
+    verifyText.setPosition(drawingArea.left + 450.f, drawingArea.top + drawingArea.height - 30.f);
+
+    // Pattern mode: the player clicks the drawn vertices that pattern vertices
+    // 1, 2, ... land on, and the choice is checked once each has a place
+    bool patternModeActive = false;
+    Graph patternHost;
+    vector<int> patternChoice; // drawn vertex picked for each pattern vertex so far
+    bool patternFound = false;
+    Text patternText("", font, 16);
+    patternText.setPosition(drawingArea.left + 450.f, drawingArea.top + drawingArea.height - 30.f);
+
+    // Spectral fingerprint of the finished graph, shown above the crossing count.
+    // The cache is shared with the analysis threads, so it outlives the scheduler.
+    string spectrumFingerprint;
+    Text spectrumText("", font, 14);
+    spectrumText.setPosition(drawingArea.left + 10.f, drawingArea.top + drawingArea.height - 50.f);
+    SpectrumCache spectrumCache;
+
+    // Straight drawing edges in one vertex array, rebuilt only after edges are
+    // added, undone or loaded, so large graphs are not walked every frame.
+    // Where vertex buffers are supported the batch is also kept on the GPU.
+    vector<Vertex> lineBatch;
+    VertexBuffer lineBuffer(Lines, VertexBuffer::Dynamic);
+    bool lineBufferReady = false;
+    bool lineBatchStale = true;
+
+    // Edges of the two generated panels, a batch each, rebuilt only when the
+    // matrix or a panel placement changes rather than scanned every frame
+    vector<Vertex> panelLines1, panelLines2;
+    VertexBuffer panelBuffer1(Lines, VertexBuffer::Static), panelBuffer2(Lines, VertexBuffer::Static);
+    bool panelBuffersReady = false;
+    bool panelLinesStale = true;
+
+    // Where each edge is drawn, so a moved vertex can fix up just its own
+    // edges: the first of its two points in lineBatch, its circle in loops and
+    // the first point of its curve in curveLine, or -1 for none
+    vector<int> lineSlot(numEdges, -1);
+    vector<int> loopSlot(numEdges, -1);
+    vector<int> curveStart(numEdges, -1);
+
+    // Batch slots moved since the last upload. Up to lineUploadRuns runs of
+    // neighbouring slots are sent one call each, more as one span.
+    vector<int> movedLineSlots;
+    const int lineUploadRuns = 64;
+
+    // Lay out the curve of a repeated edge between its current end points,
+    // over its own points in the strip or, for a new curve, at the end
+    const int curvePointCount = 20;
+    auto placeCurve = [&](int edge)
+    {
+        Vector2f startPoint = edges[edge * 2].position;
+        Vector2f endPoint = edges[edge * 2 + 1].position;
+        Vector2f controlPoint(startPoint.x, endPoint.y);
+        if (curveStart[edge] == -1)
+        {
+            curveStart[edge] = (int)curveLine.getVertexCount();
+            curveLine.resize(curveLine.getVertexCount() + curvePointCount);
+        }
+        for (int k = 0; k < curvePointCount; k++)
+        {
+            Vector2f point = calculateBezierPoint(startPoint, controlPoint, endPoint, k * 0.05f);
+            curveLine[curveStart[edge] + k] = Vertex(point, Color::White);
+        }
+    };
+
+    // Segments of one edge as drawn: a straight edge is one segment, a curved
+    // repeat the pieces of its curve, so it is neither counted as a copy of
+    // the edge it repeats nor left out
+    auto appendEdgeSegments = [&](int edge, vector<Vector2f>& segmentEnds)
+    {
+        if (curveStart[edge] == -1)
+        {
+            segmentEnds.push_back(edges[edge * 2].position);
+            segmentEnds.push_back(edges[edge * 2 + 1].position);
+            return;
+        }
+        Vector2f previous = edges[edge * 2].position;
+        for (int k = 1; k <= curvePointCount; k++)
+        {
+            Vector2f next = k < curvePointCount ? curveLine[curveStart[edge] + k].position : edges[edge * 2 + 1].position;
+            segmentEnds.push_back(previous);
+            segmentEnds.push_back(next);
+            previous = next;
+        }
+    };
+
+    // Segments of the edges drawn so far, for the crossing count
+    auto drawingSegments = [&]()
+    {
+        vector<Vector2f> segmentEnds;
+        segmentEnds.reserve(edgeCount * 2);
+        for (int i = 0; i < edgeCount; i++)
+            appendEdgeSegments(i, segmentEnds);
+        return segmentEnds;
+    };
+
+    // Crossings between an edge not yet counted and the edges drawn so far,
+    // for keeping the count up to date as edges are added and undone
+    auto crossingsOfEdge = [&](int edge)
+    {
+        vector<Vector2f> existing = drawingSegments();
+        vector<Vector2f> own;
+        appendEdgeSegments(edge, own);
+        long long crossings = 0;
+        for (size_t i = 0; i + 1 < own.size(); i += 2)
+            crossings += countCrossingsWith(existing, own[i], own[i + 1]);
+        return crossings;
+    };
+
+    // Analysis jobs run on background threads and queue their results, which
+    // the render thread applies at the start of each frame. The scheduler is
+    // declared after the queue so its threads are joined before the queue goes.
+    ResultQueue<function<void()>> analysisResults;
+    TaskScheduler analysis;
+    CancelToken analysisToken;
+
+    // Cancel jobs still working on an out of date graph
+    auto restartAnalysis = [&]()
+    {
+        analysisToken.cancel();
+        analysisToken = CancelToken();
+    };
+
+    // A moved vertex changes crossings all over, so the count is taken again
+    // in the background. Only the newest count is kept, and an edge added or
+    // undone before it is back asks for another, having no count to adjust.
+    int crossingsVersion = 0;
+    bool crossingsPending = false;
+    auto recountDrawingCrossings = [&]()
+    {
+        int version = ++crossingsVersion;
+        crossingsPending = true;
+        drawingCrossings = -1;
+        vector<Vector2f> segmentEnds = drawingSegments();
+        analysis.submit([=, &analysisResults, &drawingCrossings, &crossingsVersion, &crossingsPending]()
+        {
+            long long crossings = countCrossings(segmentEnds);
+            analysisResults.push([=, &drawingCrossings, &crossingsVersion, &crossingsPending]()
+            {
+                if (version != crossingsVersion)
+                    return;
+                drawingCrossings = crossings;
+                crossingsPending = false;
+            });
+        });
+    };
+
+    // Render thread side of the graph 2 layout job
+    auto applyGraph2Layout = [&](const vector<CircleShape>& placement, long long newCrossings1, long long newCrossings2)
+    {
+        isomorphicVertices2 = placement;
+        crossings1 = newCrossings1;
+        crossings2 = newCrossings2;
+        panelColoursStale = true;
+        panelLinesStale = true;
+    };
+
+    // Runs on an analysis thread: lay out graph 2 and queue the result
+    auto layoutGraph2Job = [&analysisResults, applyGraph2Layout, panelArea2, puzzleSeed](const vector<vector<int>>& matrix, const vector<CircleShape>& panel1,
+                                                                                        const vector<CircleShape>& circle2, LayoutMode mode, CancelToken token)
+    {
+        long long newCrossings1 = countCrossings(panelSegments(panel1, matrix));
+        long long newCrossings2 = 0;
+        vector<CircleShape> placement = chooseGraph2Layout(matrix, circle2, mode, panelArea2, puzzleSeed, newCrossings1, newCrossings2, token);
+        analysisResults.push([=]()
+        {
+            if (!token.cancelled())
+                applyGraph2Layout(placement, newCrossings1, newCrossings2);
+        });
+    };
+
+    // Lay out graph 2 again from the current adjacency matrix
+    auto submitGraph2Layout = [&]()
+    {
+        restartAnalysis();
+        CancelToken token = analysisToken;
+        vector<vector<int>> matrix = adjacencyMatrix;
+        vector<CircleShape> panel1 = isomorphicVertices1;
+        LayoutMode mode = layoutMode2;
+        analysis.submit([=]() { layoutGraph2Job(matrix, panel1, circleVertices2, mode, token); });
+    };
+
+    // Render thread side of the completion analysis
+    auto applyMatrix = [&](const vector<vector<int>>& matrix, const vector<pair<int, int>>& edgeList, const vector<CircleShape>& panel1)
+    {
+        adjacencyMatrix = matrix;
+        isomorphicVertices1 = panel1;
+        drawnEdges = edgeList;
+        graphComplete = true;
+        panelColoursStale = true;
+        panelLinesStale = true;
+    };
+
+    // Render thread side of a colouring worked out by the analysis
+    auto applyColouring = [&](const vector<int>& colours)
+    {
+        vertexColours = colours;
+        panelColoursStale = true;
+    };
+
+    // Runs on an analysis thread: fill the adjacency matrix from the edge
+    // list, print the report with the symmetry of the graph, colour it, look
+    // for the pattern, draw graph 1 without crossings when it is planar, lay
+    // out graph 2 and work out the spectra, the Euler and Hamiltonian walks,
+    // the cliques and, for small graphs, the chromatic number
+    auto analyseGraphJob = [&analysisResults, &spectrumCache, &spectrumFingerprint, &pattern, applyMatrix, applyColouring, layoutGraph2Job, panelArea1, patternPath, patternInduced](int n, const vector<pair<int, int>>& edgeList, const vector<CircleShape>& panel1,
+                                                                           const vector<CircleShape>& circle2, LayoutMode mode, CancelToken token)
+    {
+        vector<vector<int>> matrix(n, vector<int>(n, 0));
+        for (const auto& edge : edgeList)
+        {
+            matrix[edge.first][edge.second] += 1;
+            if (edge.first != edge.second)
+                matrix[edge.second][edge.first] += 1;
+        }
+
+        reportDrawnGraph(matrix);
+        AutomorphismGroup group = automorphismGroup(n, edgeList);
+        double difficulty = puzzleDifficulty(group);
+        string order = group.log10Order() < 15.0 ? group.order() : "about 10^" + to_string((int)group.log10Order());
+        logInfo("Automorphism group order " + order + " with " + to_string(group.orbitCount()) + " vertex orbits, puzzle difficulty " +
+                to_string(difficulty) + " of 10 (" + difficultyName(difficulty) + ")");
+        Graph graph = buildGraph(matrix);
+        vector<int> colours = dsaturColouring(graph);
+        logInfo("DSATUR colouring with " + to_string(colourCount(colours)) + " colours");
+        analysisResults.push([=]()
+        {
+            if (!token.cancelled())
+                applyColouring(colours);
+        });
+        reportDistances(graph, token);
+        if (patternPath != nullptr)
+            reportPattern(pattern, graph, patternInduced, token);
+
+        vector<CircleShape> placement1 = panel1;
+        vector<Vector2f> planarPositions;
+        if (planarLayout(graph, panelArea1, planarPositions))
+        {
+            applyLayout(placement1, planarPositions);
+            logInfo("The graph is planar; graph 1 is drawn without crossings.");
+        }
+        else
+            logInfo("The graph is not planar.");
+        analysisResults.push([=]()
+        {
+            if (!token.cancelled())
+                applyMatrix(matrix, edgeList, placement1);
+        });
+
+        layoutGraph2Job(matrix, placement1, circle2, mode, token);
+
+        // Spectra come last, as the dense solver is the slowest step for big drawings
+        if (token.cancelled())
+            return;
+        string fingerprint = spectralFingerprint(spectrumCache.get(matrix));
+        logInfo(fingerprint);
+        analysisResults.push([=, &spectrumFingerprint]()
+        {
+            if (!token.cancelled())
+                spectrumFingerprint = fingerprint;
+        });
+
+        // Then the walks, the cliques and the exact colouring, whose searches
+        // can run long
+        reportTraversals(n, edgeList, graph, token);
+        if (token.cancelled())
+            return;
+        vector<int> clique = reportCliques(graph, token);
+        if (n > chromaticVertexLimit || token.cancelled())
+            return;
+        vector<int> exactColours = reportColouring(graph, clique, token);
+        if (colourCount(exactColours) < colourCount(colours))
+        {
+            analysisResults.push([=]()
+            {
+                if (!token.cancelled())
+                    applyColouring(exactColours);
+            });
+        }
+    };
+
+    // Build the adjacency matrix of the finished drawing, print the report and
+    // lay out graph 2, all off the render thread. The edges come as the vertex
+    // pairs they were drawn between, not found again from their positions.
+    auto submitCompletionAnalysis = [&](int n, const vector<pair<int, int>>& edgeList)
+    {
+        restartAnalysis();
+        CancelToken token = analysisToken;
+        vector<CircleShape> panel1 = isomorphicVertices1;
+        LayoutMode mode = layoutMode2;
+
+        analysis.submit([=]()
+        {
+            analyseGraphJob(n, edgeList, panel1, circleVertices2, mode, token);
+        });
+    };
+
+    // Place a loaded graph in the drawing area as if it had been drawn. Graphs
+    // small enough for the panels then go through the completion analysis.
+    auto applyImportedLayout = [&](const vector<Vector2f>& positions)
+    {
+        float vertexRadius = numVertices <= 100 ? 10.f : 2.f;
+        for (int i = 0; i < numVertices; i++)
+        {
+            CircleShape vertex(vertexRadius);
+            vertex.setFillColor(vertexColour(vertexColours[i]));
+            vertex.setPosition(positions[i] - Vector2f(vertexRadius, vertexRadius));
+            vertices[i] = vertex;
+        }
+        vertexCount = numVertices;
+
+        connectivity.reset(numVertices);
+        for (int i = 0; i < numVertices; i++)
+            connectivity.addVertex();
+        for (int i = 0; i < numEdges; i++)
+        {
+            // Edge ends sit on the vertex centres exactly as drawn edges do,
+            // which a corner of position - radius does not round back to
+            connectivity.addEdge(importedEdges[i].first, importedEdges[i].second);
+            edges[i * 2] = getCenter(vertices[importedEdges[i].first]);
+            edges[i * 2 + 1] = getCenter(vertices[importedEdges[i].second]);
+            isLoopOrLine[i] = importedEdges[i].first == importedEdges[i].second ? "Loop" : "Line";
+            updatingDegree[i] = 1;
+            degreeIndex[i] = i;
+        }
+        edgeCount = numEdges;
+        lineBatchStale = true;
+
+        if (panelVertices == 0)
+        {
+            // Too big for the panels and for counting crossings; still exportable
+            drawingCrossings = -1;
+            drawnEdges = importedEdges;
+            graphComplete = true;
+            logInfo("Graph is larger than " + to_string(denseMatrixLimit) + " vertices; generated panels are skipped.");
+
+            // The dense spectra are out of reach, but Lanczos still finds the
+            // largest eigenvalue, DSATUR still colours it, and the distances,
+            // walks and cliques are worked out up to a limit
+            CancelToken token = analysisToken;
+            int n = numVertices;
+            const vector<pair<int, int>>* edgeList = &importedEdges;
+            analysis.submit([=, &analysisResults, &spectrumFingerprint, &pattern]()
+            {
+                Graph graph = buildGraph(n, *edgeList);
+                vector<int> colours = dsaturColouring(graph);
+                logInfo("DSATUR colouring with " + to_string(colourCount(colours)) + " colours");
+                analysisResults.push([=]()
+                {
+                    if (!token.cancelled())
+                        applyColouring(colours);
+                });
+                if (n <= distanceVertexLimit)
+                    reportDistances(graph, token);
+                if (patternPath != nullptr)
+                    reportPattern(pattern, graph, patternInduced, token);
+                vector<double> top;
+                bool converged = topEigenvalues(graph, SpectrumMatrix::Adjacency, 1, top);
+                string fingerprint = "Spectral radius " + to_string(top[0]) + (converged ? "" : "  (approximate)");
+                logInfo(fingerprint);
+                analysisResults.push([=, &spectrumFingerprint]()
+                {
+                    if (!token.cancelled())
+                        spectrumFingerprint = fingerprint;
+                });
+                reportTraversals(n, *edgeList, graph, token);
+                reportCliques(graph, token);
+            });
+            return;
+        }
+
+        restartAnalysis();
+        CancelToken token = analysisToken;
+        vector<CircleShape> panel1 = isomorphicVertices1;
+        LayoutMode mode = layoutMode2;
+        int n = numVertices;
+        vector<pair<int, int>> edgeList = importedEdges;
+        vector<Vector2f> segmentEnds = drawingSegments();
+        analysis.submit([=, &analysisResults, &drawingCrossings]()
+        {
+            long long crossings = countCrossings(segmentEnds);
+            analysisResults.push([=, &drawingCrossings]()
+            {
+                if (!token.cancelled())
+                    drawingCrossings = crossings;
+            });
+            analyseGraphJob(n, edgeList, panel1, circleVertices2, mode, token);
+        });
+    };
+
+    // Journal of the drawing, so a crash or a closed window loses nothing.
+    // Null for a loaded graph and while a recovered drawing is redrawn.
+    unique_ptr<SessionJournal> journal;
+
+    // Vertex pairs of the edges standing: drawn edges are listed as they go; a
+    // loaded graph keeps its list, and a finished session restored from a file
+    // only has the export list
+    auto standingEdgeEnds = [&]() -> const vector<pair<int, int>>&
+    {
+        return !drawnEdgeEnds.empty() ? drawnEdgeEnds : graphProvided ? importedEdges : drawnEdges;
+    };
+
+    // Edge ends at each vertex, as indices into edges (edge * 2 + side), so a
+    // dragged vertex only visits its own edges. Built on the first drag and
+    // kept up to date from then on; the newest edge's ends are always last.
+    vector<vector<int>> incidentEnds;
+    bool incidenceBuilt = false;
+    auto buildIncidence = [&]()
+    {
+        const vector<pair<int, int>>& edgeEnds = standingEdgeEnds();
+        incidentEnds.assign(numVertices, vector<int>());
+        for (int i = 0; i < edgeCount; i++)
+        {
+            incidentEnds[edgeEnds[i].first].push_back(i * 2);
+            incidentEnds[edgeEnds[i].second].push_back(i * 2 + 1);
+        }
+        incidenceBuilt = true;
+    };
+    auto noteIncidence = [&](int edge, int startVertex, int endVertex)
+    {
+        if (!incidenceBuilt)
+            return;
+        incidentEnds[startVertex].push_back(edge * 2);
+        incidentEnds[endVertex].push_back(edge * 2 + 1);
+    };
+    auto dropIncidence = [&](int startVertex, int endVertex)
+    {
+        if (!incidenceBuilt)
+            return;
+        incidentEnds[endVertex].pop_back();
+        incidentEnds[startVertex].pop_back();
+    };
+
+    // Put a placed vertex's corner at position and carry its edge ends along.
+    // Straight edges are patched in the line batch and queued for upload,
+    // loops moved and curves laid out again; nothing else is walked.
+    auto moveDrawnVertex = [&](int vertex, Vector2f position)
+    {
+        vertices[vertex].setPosition(position);
+        Vector2f centre = getCenter(vertices[vertex]);
+        for (int end : incidentEnds[vertex])
+        {
+            int edge = end / 2;
+            edges[end].position = centre;
+            if (lineSlot[edge] != -1)
+            {
+                lineBatch[lineSlot[edge] + end % 2].position = centre;
+                movedLineSlots.push_back(lineSlot[edge]);
+            }
+            if (loopSlot[edge] != -1)
+                loops[loopSlot[edge]].setPosition(centre);
+            if (curveStart[edge] != -1)
+                placeCurve(edge);
+        }
+    };
+
+    // Place a drawn vertex with its corner at position
+    auto placeDrawnVertex = [&](Vector2f position)
+    {
+        CircleShape vertex(10);
+        vertex.setFillColor(vertexColour(vertexColours[vertexCount]));
+        vertex.setPosition(position);
+
+        // Add the vertex to the vector
+        vertices[vertexCount] = vertex;
+
+        // Increment the vertex count
+        vertexCount++;
+        connectivity.addVertex();
+        if (journal)
+            journal->vertexPlaced(position);
+    };
+
+    // Join two placed vertices, with a curve if they are already joined
+    auto addDrawnEdge = [&](int startVertexIndex, int endVertexIndex)
+    {
+        Vector2f startPoint = getCenter(vertices[startVertexIndex]);
+        Vector2f endPoint = getCenter(vertices[endVertexIndex]);
+
+        // Check if an edge already exists between the two selected vertices
+        bool isExistingEdge = false;
+        for (int i = 0; i < edgeCount; i++)
+        {
+            Vector2f existingStartPoint = edges[i * 2].position;
+            Vector2f existingEndPoint = edges[i * 2 + 1].position;
+            if ((existingStartPoint == startPoint && existingEndPoint == endPoint) ||
+                (existingStartPoint == endPoint && existingEndPoint == startPoint))
+            {
+                isExistingEdge = true;
+                break;
+            }
+        }
+
+        if (isExistingEdge)
+        {
+            // Save the previous state before modifying edges
+            prevEdgeCountStack.push(edgeCount);
+            if (journal)
+                journal->edgeAdded(startVertexIndex, endVertexIndex);
+
+            // Add the line vertices to the vector
+            edges[edgeCount * 2] = startPoint;
+            edges[edgeCount * 2 + 1] = endPoint;
+            noteIncidence(edgeCount, startVertexIndex, endVertexIndex);
+
+            // Draw a curved edge using a quadratic Bezier curve
+            placeCurve(edgeCount);
+            if (!crossingsPending)
+                drawingCrossings += crossingsOfEdge(edgeCount);
+
+            // Increment the edge count
+            edgeCount++;
+            lineBatchStale = true;
+            connectivity.addEdge(startVertexIndex, endVertexIndex);
+            colourNewEdge(startVertexIndex, endVertexIndex);
+
+            logVerbose("Curved edge drawing tool disabled.");
+        }
+        else
+        {
+            // Draw a straight edge between the two selected vertices
+            prevIsLoopOrLineStack.push(isLoopOrLine);
+            if (startPoint == endPoint)
+                isLoopOrLine[edgeCount] = "Loop";
+            else
+                isLoopOrLine[edgeCount] = "Line";
+
+            logVerbose(isLoopOrLine[edgeCount]);
+
+            // Save the previous state before modifying edges
+            prevEdgeCountStack.push(edgeCount);
+            if (journal)
+                journal->edgeAdded(startVertexIndex, endVertexIndex);
+
+            // Add the line vertices to the vector
+            edges[edgeCount * 2] = startPoint;
+            edges[edgeCount * 2 + 1] = endPoint;
+            noteIncidence(edgeCount, startVertexIndex, endVertexIndex);
+            if (!crossingsPending)
+                drawingCrossings += crossingsOfEdge(edgeCount);
+
+            // Increment the edge count
+            edgeCount++;
+            lineBatchStale = true;
+            connectivity.addEdge(startVertexIndex, endVertexIndex);
+            colourNewEdge(startVertexIndex, endVertexIndex);
+
+            for (int i = 0; i < edgeCount; i++)
+            {
+                Vector2f existingStartPoint = edges[i * 2].position;
+                Vector2f existingEndPoint = edges[i * 2 + 1].position;
+                if ((existingStartPoint == startPoint && existingEndPoint == endPoint) ||
+                    (existingStartPoint == endPoint && existingEndPoint == startPoint))
+                {
+                    updatingDegree[i] += 1;
+                    prevDegreeIndexStack.push(degreeIndex);
+                    degreeIndex[edgeCount] = i;
+                    logVerbose("Updated degree [" + to_string(i) + "] : " + to_string(updatingDegree[i]));
+                    break;
+                }
+            }
+
+            logVerbose("Edge drawing tool disabled.");
+        }
+        if (crossingsPending)
+            recountDrawingCrossings();
+    };
+
+    // Take back the newest edge, restoring the state saved before it. The
+    // edges past the restored count are never read, so the edge array stays
+    // as it is and vertices moved since keep their edges where they are.
+    auto undoDrawnEdge = [&]()
+    {
+        updatingDegree[degreeIndex[edgeCount]] -= 1;
+
+        // The undone edge sits just past the restored edge count
+        int undoneEdge = prevEdgeCountStack.top();
+
+        // Restore the previous state of edges
+        edgeCount = prevEdgeCountStack.top();
+        isLoopOrLine = prevIsLoopOrLineStack.top();
+        degreeIndex = prevDegreeIndexStack.top();
+
+        // Pop the previous state from the stacks
+        prevEdgeCountStack.pop();
+        prevIsLoopOrLineStack.pop();
+        prevDegreeIndexStack.pop();
+        if (journal)
+            journal->edgeUndone();
+        connectivity.undoEdge();
+        dropIncidence(drawnEdgeEnds.back().first, drawnEdgeEnds.back().second);
+        uncolourUndoneEdge();
+        if (!crossingsPending)
+            drawingCrossings -= crossingsOfEdge(undoneEdge);
+
+        // Its curve is the newest, so it is the end of the strip
+        if (curveStart[undoneEdge] != -1)
+        {
+            curveLine.resize(curveStart[undoneEdge]);
+            curveStart[undoneEdge] = -1;
+        }
+
+        if (crossingsPending)
+            recountDrawingCrossings();
+        lineBatchStale = true;
+    };
+
+    // Snapshot the finished drawing and hand it to the analysis threads. Edges
+    // cannot be undone any more, so there is nothing left to recover.
+    auto completeDrawing = [&]()
+    {
+        submitCompletionAnalysis(vertexCount, drawnEdgeEnds);
+
+        if (journal)
+        {
+            journal.reset();
+            discardJournal(journalPath);
+        }
+    };
+
+    // Put a saved session back as it was. Only the render state is built
+    // here; every array is read straight from the mapped file.
+    auto restoreSession = [&](const Session& session)
+    {
+        int placed = (int)session.vertices.size;
+        vertexColours.assign(session.colours.begin(), session.colours.end());
+        for (int i = 0; i < placed; i++)
+        {
+            CircleShape vertex(session.vertexRadius);
+            vertex.setFillColor(vertexColour(vertexColours[i]));
+            vertex.setPosition(session.vertices[i]);
+            vertices[i] = vertex;
+        }
+        vertexCount = placed;
+
+        // Edges that can be undone need their connectivity changes logged, so
+        // they are replayed, as they are when no forest was saved; otherwise
+        // the saved forest is put back as it is
+        edgeCount = (int)session.edges.size / 2;
+        bool replayConnectivity = session.undoEdgeCounts.size > 0 || session.unionParents.size == 0 ||
+                                  !connectivity.restore(placed, numVertices, session.unionParents.data, session.unionRanks.data,
+                                                        session.unionParities.data, session.oddCycleEdges);
+        if (replayConnectivity)
+        {
+            connectivity.reset(numVertices);
+            for (int i = 0; i < placed; i++)
+                connectivity.addVertex();
+        }
+
+        // A finished drawing keeps its edges for exporting, one in progress
+        // for recolouring as edges are added
+        vector<pair<int, int>>& edgeEnds = session.complete ? drawnEdges : drawnEdgeEnds;
+        edgeEnds.resize(edgeCount);
+        for (int i = 0; i < edgeCount; i++)
+        {
+            int startVertex = (int)session.edges[i * 2];
+            int endVertex = (int)session.edges[i * 2 + 1];
+            edges[i * 2] = getCenter(vertices[startVertex]);
+            edges[i * 2 + 1] = getCenter(vertices[endVertex]);
+            edgeEnds[i] = make_pair(startVertex, endVertex);
+            if (replayConnectivity)
+                connectivity.addEdge(startVertex, endVertex);
+            if (!session.complete && startVertex != endVertex)
+            {
+                drawnNeighbours[startVertex].push_back(endVertex);
+                drawnNeighbours[endVertex].push_back(startVertex);
+            }
+        }
+        for (int i = 0; i < numEdges; i++)
+        {
+            isLoopOrLine[i] = edgeKindName(session.edgeKinds[i]);
+            updatingDegree[i] = (int)session.multiplicities[i];
+            degreeIndex[i] = (int)session.multiplicityIndex[i];
+        }
+
+        // A saved strip can still hold curves of edges undone before it was
+        // saved, so the curves are laid out again: an edge is curved when an
+        // earlier one joins the same pair. Only drawn repeats are curved, so a
+        // session without any skips the search.
+        if (session.curvePoints.size > 0)
+        {
+            unordered_set<long long> joined;
+            for (int i = 0; i < edgeCount; i++)
+            {
+                long long low = min(session.edges[i * 2], session.edges[i * 2 + 1]);
+                long long high = max(session.edges[i * 2], session.edges[i * 2 + 1]);
+                if (!joined.insert(low * numVertices + high).second)
+                    placeCurve(i);
+            }
+        }
+
+        for (uint32_t count : session.undoEdgeCounts)
+            prevEdgeCountStack.push((int)count);
+        for (size_t level = 0; numEdges > 0 && level < session.undoEdgeKinds.size / numEdges; level++)
+        {
+            vector<string> kinds(numEdges);
+            for (int i = 0; i < numEdges; i++)
+                kinds[i] = edgeKindName(session.undoEdgeKinds[level * numEdges + i]);
+            prevIsLoopOrLineStack.push(kinds);
+        }
+        for (size_t level = 0; numEdges > 0 && level < session.undoMultiplicityIndex.size / numEdges; level++)
+        {
+            const uint32_t* saved = session.undoMultiplicityIndex.data + level * numEdges;
+            prevDegreeIndexStack.push(vector<int>(saved, saved + numEdges));
+        }
+
+        if ((int)session.panel1.size == panelVertices)
+        {
+            for (int i = 0; i < panelVertices; i++)
+            {
+                isomorphicVertices1[i].setPosition(session.panel1[i]);
+                isomorphicVertices2[i].setPosition(session.panel2[i]);
+            }
+        }
+        if (session.layoutMode2 <= (int)LayoutMode::Stress)
+            layoutMode2 = (LayoutMode)session.layoutMode2;
+        spectrumFingerprint.assign(session.fingerprint.begin(), session.fingerprint.end());
+        drawingCrossings = session.drawingCrossings;
+        lineBatchStale = true;
+        panelColoursStale = true;
+        panelLinesStale = true;
+
+        // A count still running when the session was saved is taken again
+        if (drawingCrossings < 0 && panelVertices > 0)
+            recountDrawingCrossings();
+
+        if (session.complete)
+        {
+            crossings1 = session.crossings1;
+            crossings2 = session.crossings2;
+            for (const auto& edge : drawnEdges)
+            {
+                if (panelVertices == 0)
+                    break;
+                adjacencyMatrix[edge.first][edge.second] += 1;
+                if (edge.first != edge.second)
+                    adjacencyMatrix[edge.second][edge.first] += 1;
+            }
+            graphComplete = true;
+        }
+
+        else
+        {
+            // A drawing still in progress is journalled on from here
+            startingDrawing.vertices.assign(session.vertices.begin(), session.vertices.end());
+            startingDrawing.edges = drawnEdgeEnds;
+        }
+    };
+
+    // Copy the session into flat arrays here and write them out on an
+    // analysis thread, so saving a big graph never holds up a frame
+    string savePath = sessionPath != nullptr ? sessionPath : defaultSessionPath;
+    auto saveCurrentSession = [&]()
+    {
+        Session header;
+        header.seed = puzzleSeed;
+        header.numVertices = numVertices;
+        header.numEdges = numEdges;
+        header.complete = graphComplete;
+        header.layoutMode2 = (int)layoutMode2;
+        header.vertexRadius = vertexCount > 0 ? vertices[0].getRadius() : 10.f;
+        header.drawingCrossings = drawingCrossings;
+        header.crossings1 = crossings1;
+        header.crossings2 = crossings2;
+        header.oddCycleEdges = connectivity.oddCycleEdges();
+
+        vector<Vector2f> corners(vertexCount);
+        for (int i = 0; i < vertexCount; i++)
+            corners[i] = vertices[i].getPosition();
+        vector<int32_t> colours(vertexColours.begin(), vertexColours.end());
+        const vector<pair<int, int>>& edgeEnds = standingEdgeEnds();
+        vector<uint32_t> edgeList(edgeCount * 2);
+        for (int i = 0; i < edgeCount; i++)
+        {
+            edgeList[i * 2] = (uint32_t)edgeEnds[i].first;
+            edgeList[i * 2 + 1] = (uint32_t)edgeEnds[i].second;
+        }
+        vector<EdgeKind> kinds(numEdges);
+        vector<uint32_t> multiplicities(numEdges), multiplicityIndex(numEdges);
+        for (int i = 0; i < numEdges; i++)
+        {
+            kinds[i] = edgeKindOf(isLoopOrLine[i]);
+            multiplicities[i] = (uint32_t)updatingDegree[i];
+            multiplicityIndex[i] = (uint32_t)degreeIndex[i];
+        }
+        vector<Vector2f> curvePoints(curveLine.getVertexCount());
+        for (size_t i = 0; i < curvePoints.size(); i++)
+            curvePoints[i] = curveLine[i].position;
+
+        // A stack only shows its top, so the undo history is read off copies
+        // newest first and turned round
+        vector<uint32_t> undoEdgeCounts;
+        for (stack<int> levels = prevEdgeCountStack; !levels.empty(); levels.pop())
+            undoEdgeCounts.push_back((uint32_t)levels.top());
+        reverse(undoEdgeCounts.begin(), undoEdgeCounts.end());
+        vector<EdgeKind> undoEdgeKinds;
+        for (stack<vector<string>> levels = prevIsLoopOrLineStack; !levels.empty(); levels.pop())
+        {
+            for (int i = numEdges - 1; i >= 0; i--)
+                undoEdgeKinds.push_back(edgeKindOf(levels.top()[i]));
+        }
+        reverse(undoEdgeKinds.begin(), undoEdgeKinds.end());
+        vector<uint32_t> undoMultiplicityIndex;
+        for (stack<vector<int>> levels = prevDegreeIndexStack; !levels.empty(); levels.pop())
+        {
+            for (int i = numEdges - 1; i >= 0; i--)
+                undoMultiplicityIndex.push_back((uint32_t)levels.top()[i]);
+        }
+        reverse(undoMultiplicityIndex.begin(), undoMultiplicityIndex.end());
+
+        vector<Vector2f> panel1(panelVertices), panel2(panelVertices);
+        for (int i = 0; i < panelVertices; i++)
+        {
+            panel1[i] = isomorphicVertices1[i].getPosition();
+            panel2[i] = isomorphicVertices2[i].getPosition();
+        }
+        string fingerprint = spectrumFingerprint;
+        vector<int32_t> unionParents(connectivity.parents().begin(), connectivity.parents().end());
+        vector<int32_t> unionRanks(connectivity.ranks().begin(), connectivity.ranks().end());
+        vector<char> unionParities = connectivity.parities();
+        string path = savePath;
+
+        analysis.submit([=]()
+        {
+            Session session = header;
+            session.vertices = corners;
+            session.colours = colours;
+            session.edges = edgeList;
+            session.edgeKinds = kinds;
+            session.multiplicities = multiplicities;
+            session.multiplicityIndex = multiplicityIndex;
+            session.curvePoints = curvePoints;
+            session.undoEdgeCounts = undoEdgeCounts;
+            session.undoEdgeKinds = undoEdgeKinds;
+            session.undoMultiplicityIndex = undoMultiplicityIndex;
+            session.panel1 = panel1;
+            session.panel2 = panel2;
+            session.fingerprint = ArrayView<char>(fingerprint.data(), fingerprint.size());
+            session.unionParents = unionParents;
+            session.unionRanks = unionRanks;
+            session.unionParities = unionParities;
+            if (saveSession(path, session))
+                logInfo("Saved the session to " + path);
+            else
+                logError("Could not write " + path);
+        });
+    };
+
+    if (sessionLoaded)
+    {
+        restoreSession(sessionFile.session());
+        double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - sessionStart).count();
+        logInfo("Restored the session from " + string(sessionPath) + ": " + to_string(vertexCount) + " vertices and " + to_string(edgeCount) +
+                " edges in " + to_string((int)milliseconds) + " ms");
+    }
+    else if (!graphProvided)
+    {
+        // Redraw a recovered drawing through the same steps as the clicks, so
+        // undo works on it as before
+        for (Vector2f position : startingDrawing.vertices)
+            placeDrawnVertex(position);
+        for (const auto& edge : startingDrawing.edges)
+            addDrawnEdge(edge.first, edge.second);
+    }
+
+    // Journal a drawing still in progress from where it now stands
+    if (!graphProvided && !graphComplete)
+    {
+        journal = make_unique<SessionJournal>(journalPath, startingDrawing);
+        if (edgeCount == numEdges && vertexCount == numVertices)
+            completeDrawing();
+    }
+
+    if (graphProvided)
+    {
+        // Lay the loaded graph out in the background; it appears once placed
+        CancelToken token = analysisToken;
+        int n = numVertices;
+        const vector<pair<int, int>>* edgeList = &importedEdges;
+        analysis.submit([=, &analysisResults]()
+        {
+            vector<Vector2f> positions;
+            multilevelLayout(buildGraph(n, *edgeList), drawingArea, positions, puzzleSeed, &token);
+            analysisResults.push([=]()
+            {
+                if (!token.cancelled())
+                    applyImportedLayout(positions);
+            });
+        });
+    }
 
     // Game loop
     while (startingWindow.isOpen())
@@ -247,6 +1688,11 @@ int main()
 
     while (window.isOpen())
     {
+        // Apply results finished by the analysis threads
+        function<void()> analysisResult;
+        while (analysisResults.pop(analysisResult))
+            analysisResult();
+
         // Event polling
         while (window.pollEvent(ev))
         {
@@ -263,42 +1709,145 @@ int main()
                 {
                     vertexToolActive = true;
                     edgeToolActive = false;
+                    moveToolActive = false;
+                    verifyModeActive = false;
+                    patternModeActive = false;
                     startVertexIndex = -1;
-                    cout << "Vertex Tool is Active" << endl;
+                    logInfo("Vertex Tool is Active");
 
                 }
                 else if (ev.key.code == Keyboard::G)
                 {
                     edgeToolActive = true;
                     vertexToolActive = false;
+                    moveToolActive = false;
+                    verifyModeActive = false;
+                    patternModeActive = false;
+                    startVertexIndex = -1;
+                    logInfo("Edge Tool is Active");
+                }
+                else if (ev.key.code == Keyboard::M)
+                {
+                    moveToolActive = true;
+                    vertexToolActive = false;
+                    edgeToolActive = false;
+                    verifyModeActive = false;
+                    patternModeActive = false;
                     startVertexIndex = -1;
-                    cout << "Edge Tool is Active" << endl;
+                    logInfo("Move Tool is Active");
+                }
+                else if (ev.key.code == Keyboard::L)
+                {
+                    // Cycle the layout of generated graph 2: circle, force-directed, stress
+                    if (layoutMode2 == LayoutMode::Circle)
+                    {
+                        layoutMode2 = LayoutMode::Force;
+                        logInfo("Generated Graph 2 Layout: Force");
+                    }
+                    else if (layoutMode2 == LayoutMode::Force)
+                    {
+                        layoutMode2 = LayoutMode::Stress;
+                        logInfo("Generated Graph 2 Layout: Stress");
+                    }
+                    else
+                    {
+                        layoutMode2 = LayoutMode::Circle;
+                        logInfo("Generated Graph 2 Layout: Circle");
+                    }
+
+                    if (graphComplete)
+                        submitGraph2Layout();
+                }
+                else if (ev.key.code == Keyboard::E)
+                {
+                    // Export the finished drawing in every supported format
+                    if (graphComplete)
+                    {
+                        int n = numVertices;
+                        vector<pair<int, int>> edgeList = drawnEdges;
+                        analysis.submit([n, edgeList]()
+                        {
+                            const ExportFormat formats[] = { ExportFormat::MatrixCsv, ExportFormat::MatrixBinary, ExportFormat::EdgeList,
+                                                             ExportFormat::Graph6, ExportFormat::Sparse6, ExportFormat::Dot };
+                            for (ExportFormat format : formats)
+                            {
+                                string path = string("drawn_graph") + exportExtension(format);
+                                if (exportGraph(path, format, n, edgeList))
+                                    logInfo("Exported " + path);
+                                else
+                                    logError("Could not write " + path);
+                            }
+                        });
+                    }
+                    else
+                        logInfo("Finish drawing the graph before exporting it.");
+                }
+                else if (ev.key.code == Keyboard::V)
+                {
+                    // Toggle verify mode, starting each time from an empty mapping
+                    if (verifyModeActive)
+                    {
+                        verifyModeActive = false;
+                        logInfo("Verify Mode is Off");
+                    }
+                    else if (graphComplete && panelVertices > 0)
+                    {
+                        verifyMatrix = adjacencyMatrix;
+                        verifyMapping = make_unique<PartialMapping>(verifyMatrix, verifyMatrix);
+                        verifySource = -1;
+                        verifyModeActive = true;
+                        patternModeActive = false;
+                        vertexToolActive = false;
+                        edgeToolActive = false;
+                        moveToolActive = false;
+                        startVertexIndex = -1;
+                        logInfo("Verify Mode is Active: click a drawn vertex, then its match in Generated Graph 2");
+                    }
+                    else
+                        logInfo("Finish drawing the graph before verifying a mapping.");
                 }
+                else if (ev.key.code == Keyboard::P)
+                {
+                    // Toggle pattern mode, starting each time with nothing picked
+                    if (patternModeActive)
+                    {
+                        patternModeActive = false;
+                        logInfo("Pattern Mode is Off");
+                    }
+                    else if (patternPath == nullptr)
+                        logInfo("Start with --pattern <file> to look for a pattern graph.");
+                    else if (graphComplete)
+                    {
+                        patternHost = buildGraph(numVertices, drawnEdges);
+                        patternChoice.clear();
+                        patternFound = false;
+                        patternModeActive = true;
+                        verifyModeActive = false;
+                        vertexToolActive = false;
+                        edgeToolActive = false;
+                        moveToolActive = false;
+                        startVertexIndex = -1;
+                        logInfo("Pattern Mode is Active: click the drawn vertices for pattern vertices 1 to " + to_string(pattern.numVertices) +
+                                " in order");
+                    }
+                    else
+                        logInfo("Finish drawing the graph before looking for the pattern.");
+                }
+                else if (ev.key.code == Keyboard::S && ev.key.control)
+                    saveCurrentSession();
                 else if (ev.key.code == Keyboard::Z && ev.key.control){
                     if(edgeCount != numEdges)
                         {
                             // Undo the previous modification
-                            if (startVertexIndex == -1 && !prevEdgesStack.empty() && !prevEdgeCountStack.empty() && !prevIsLoopOrLineStack.empty() && !prevDegreeIndexStack.empty())
+                            if (startVertexIndex == -1 && !prevEdgeCountStack.empty() && !prevIsLoopOrLineStack.empty() && !prevDegreeIndexStack.empty())
                             {
-                                updatingDegree[degreeIndex[edgeCount]] -= 1;
-
-                                // Restore the previous state of edges
-                                edges = prevEdgesStack.top();
-                                edgeCount = prevEdgeCountStack.top();    
-                                isLoopOrLine = prevIsLoopOrLineStack.top();           
-                                degreeIndex = prevDegreeIndexStack.top();                                
-
-                                // Pop the previous state from the stacks
-                                prevEdgesStack.pop();
-                                prevEdgeCountStack.pop();
-                                prevIsLoopOrLineStack.pop();
-                                prevDegreeIndexStack.pop();
+                                undoDrawnEdge();
 
                                 und.play();
-                                cout << "Edge undone.\n";
+                                logInfo("Edge undone.");
                             }
                             else if (edgeCount != 0)
-                                cout << "Draw the edge first before undoing an edge.\n";
+                                logInfo("Draw the edge first before undoing an edge.");
                         }
                     }
                 break;
@@ -306,7 +1855,129 @@ int main()
             case Event::MouseButtonPressed:
                 if (ev.mouseButton.button == Mouse::Left)
                 {
-                    if (vertexToolActive && vertexCount < numVertices)
+                    if (patternModeActive)
+                    {
+                        Vector2f mousePosition = static_cast<Vector2f>(Mouse::getPosition(window));
+                        float closestDistance = 18;
+                        int picked = -1;
+                        for (int i = 0; i < vertexCount; i++)
+                        {
+                            float distance = calculateDistance(mousePosition, vertices[i].getPosition());
+                            if (distance < closestDistance)
+                            {
+                                closestDistance = distance;
+                                picked = i;
+                            }
+                        }
+                        if (picked == -1)
+                            break;
+
+                        // Clicking a picked vertex takes it and every later pick back
+                        auto earlier = find(patternChoice.begin(), patternChoice.end(), picked);
+                        if (earlier != patternChoice.end())
+                        {
+                            patternChoice.erase(earlier, patternChoice.end());
+                            patternFound = false;
+                            logInfo("Picking again from pattern vertex " + to_string(patternChoice.size() + 1));
+                            break;
+                        }
+                        if ((int)patternChoice.size() == pattern.numVertices)
+                            break;
+
+                        patternChoice.push_back(picked);
+                        if ((int)patternChoice.size() < pattern.numVertices)
+                            break;
+                        patternFound = isSubgraphMatch(pattern, patternHost, patternInduced, patternChoice);
+                        if (patternFound)
+                            logInfo("Pattern found: the picked vertices hold it" + string(patternInduced ? " as an induced subgraph" : ""));
+                        else
+                            logInfo("The picked vertices do not hold the pattern" + string(patternInduced ? " as an induced subgraph" : ""));
+                    }
+                    else if (verifyModeActive)
+                    {
+                        Vector2f mousePosition = static_cast<Vector2f>(Mouse::getPosition(window));
+
+                        // A drawn vertex picks the source of the next pair
+                        float closestDistance = 18;
+                        int picked = -1;
+                        for (int i = 0; i < vertexCount; i++)
+                        {
+                            float distance = calculateDistance(mousePosition, vertices[i].getPosition());
+                            if (distance < closestDistance)
+                            {
+                                closestDistance = distance;
+                                picked = i;
+                            }
+                        }
+                        if (picked != -1)
+                        {
+                            verifySource = picked;
+                            break;
+                        }
+                        if (verifySource == -1)
+                            break;
+
+                        // A panel 2 vertex completes the pair; clicking the current
+                        // image again takes the pair back
+                        closestDistance = 10;
+                        int target = -1;
+                        for (int j = 0; j < panelVertices; j++)
+                        {
+                            float distance = calculateDistance(mousePosition, getCenter(isomorphicVertices2[j]));
+                            if (distance < closestDistance)
+                            {
+                                closestDistance = distance;
+                                target = j;
+                            }
+                        }
+                        if (target == -1)
+                            break;
+
+                        if (verifyMapping->imageOf(verifySource) == target)
+                        {
+                            verifyMapping->unassign(verifySource);
+                            logInfo("Unmapped vertex " + to_string(verifySource + 1));
+                        }
+                        else
+                        {
+                            verifyMapping->unassign(verifySource);
+                            if (verifyMapping->preimageOf(target) != -1)
+                                verifyMapping->unassign(verifyMapping->preimageOf(target));
+                            verifyMapping->assign(verifySource, target);
+                            if (verifyMapping->complete())
+                                logInfo("Mapping complete: the graphs are isomorphic.");
+                            else if (verifyMapping->consistent())
+                                logInfo("Mapped " + to_string(verifySource + 1) + " -> " + to_string(target + 1) + ", still consistent");
+                            else
+                                logInfo("Mapped " + to_string(verifySource + 1) + " -> " + to_string(target + 1) + ", " +
+                                        to_string(verifyMapping->conflictsAt(verifySource)) + " conflicting edges here");
+                        }
+                        verifySource = -1;
+                    }
+                    else if (moveToolActive)
+                    {
+                        Vector2f mousePosition = static_cast<Vector2f>(Mouse::getPosition(window));
+
+                        // Grab the closest vertex to the mouse position
+                        float closestDistance = 18;
+                        for (int i = 0; i < vertexCount; i++)
+                        {
+                            float distance = calculateDistance(mousePosition, vertices[i].getPosition());
+                            if (distance < closestDistance)
+                            {
+                                closestDistance = distance;
+                                draggedVertex = i;
+                            }
+                        }
+                        if (draggedVertex == -1)
+                            break;
+
+                        if (!incidenceBuilt)
+                            buildIncidence();
+                        dragStart = vertices[draggedVertex].getPosition();
+                        dragOffset = dragStart - mousePosition;
+                    }
+                    else if (vertexToolActive && vertexCount < numVertices)
                     {
                         // Get the mouse position relative to the window
                         pop.play();
@@ -316,16 +1987,7 @@ int main()
                         if (!drawingArea.contains(mousePosition))
                             break;
 
-                        // Create a circle shape at the mouse position
-                        CircleShape vertex(10);
-                        vertex.setFillColor(Color::White);
-                        vertex.setPosition(mousePosition);
-
-                        // Add the vertex to the vector
-                        vertices[vertexCount] = vertex;
-
-                        // Increment the vertex count
-                        vertexCount++;
+                        placeDrawnVertex(mousePosition);
                     }
                     else if (edgeToolActive && edgeCount < numEdges)
                     {
@@ -337,7 +1999,7 @@ int main()
 
                         if (startVertexIndex == -1)
                         {
-                            cout << "Edge drawing tool enabled.\n";
+                            logVerbose("Edge drawing tool enabled.");
 
                             // Find the closest vertex to the mouse position
                             float closestDistance = 18;
@@ -370,227 +2032,51 @@ int main()
                             if (endVertexIndex != -1)
                             {
                                 line.play();
-                                Vector2f startPoint = getCenter(vertices[startVertexIndex]);
-                                Vector2f endPoint = getCenter(vertices[endVertexIndex]);
-
-                                // Check if an edge already exists between the two selected vertices
-                                bool isExistingEdge = false;
-                                for (int i = 0; i < edgeCount; i++)
-                                {
-                                    Vector2f existingStartPoint = edges[i * 2].position;
-                                    Vector2f existingEndPoint = edges[i * 2 + 1].position;
-                                    if ((existingStartPoint == startPoint && existingEndPoint == endPoint) ||
-                                        (existingStartPoint == endPoint && existingEndPoint == startPoint))
-                                    {
-                                        isExistingEdge = true;
-                                        break;
-                                    }
-                                }
+                                addDrawnEdge(startVertexIndex, endVertexIndex);
 
-                                if (isExistingEdge)
-                                {
-                                    // Draw a curved edge using a quadratic Bezier curve
-                                    Vector2f controlPoint;
-                                    controlPoint.x = startPoint.x;
-                                    controlPoint.y = endPoint.y;
-
-                                    // Save the previous state before modifying edges
-                                    prevEdgesStack.push(edges);
-                                    prevEdgeCountStack.push(edgeCount);
-
-                                    // Add the line vertices to the vector
-                                    edges[edgeCount * 2] = startPoint;
-                                    edges[edgeCount * 2 + 1] = endPoint;
-
-                                    for (float t = 0; t <= 1.0; t += 0.05)
-                                    {
-                                        Vector2f point = calculateBezierPoint(startPoint, controlPoint, endPoint, t);
-                                        curveLine.append(Vertex(point, Color::White));
-                                    }
-
-                                    // Increment the edge count
-                                    edgeCount++;
-
-                                    // Reset the start vertex index
-                                    startVertexIndex = -1;
-
-                                    cout << "Curved edge drawing tool disabled.\n";
-                                    }
-                                    else
-                                    {
-                                        // Draw a straight edge between the two selected vertices
-                                        Vertex line[] ={
-                                            Vertex(startPoint, Color(50, 100, 150, 255)),
-                                            Vertex(endPoint, Color(200, 150, 100, 255))
-                                        };
-
-                                prevIsLoopOrLineStack.push(isLoopOrLine);
-                                if (startPoint == endPoint)                                
-                                    isLoopOrLine[edgeCount] = "Loop";
-                                else
-                                    isLoopOrLine[edgeCount] = "Line";
-
-                                cout << isLoopOrLine[edgeCount] << endl;
-
-                                // Save the previous state before modifying edges
-                                prevEdgesStack.push(edges);
-                                prevEdgeCountStack.push(edgeCount);
-
-                                // Add the line vertices to the vector
-                                edges[edgeCount * 2] = startPoint;
-                                edges[edgeCount * 2 + 1] = endPoint;
-
-                                // Increment the edge count
-                                edgeCount++;
-
-                                for (int i = 0; i < edgeCount; i++)
-                                {
-                                    Vector2f existingStartPoint = edges[i * 2].position;
-                                    Vector2f existingEndPoint = edges[i * 2 + 1].position;
-                                    if ((existingStartPoint == startPoint && existingEndPoint == endPoint) ||
-                                        (existingStartPoint == endPoint && existingEndPoint == startPoint))
-                                    {
-                                        updatingDegree[i] += 1;
-                                        prevDegreeIndexStack.push(degreeIndex);
-                                        degreeIndex[edgeCount] = i;
-                                        cout << "Updated degree [" << i << "] : " << updatingDegree[i] << endl;
-                                        break;
-                                    }
-                                }
-                                
                                 // Reset the start vertex index
                                 startVertexIndex = -1;
-
-                                cout << "Edge drawing tool disabled.\n";
-                                }
                             }             
 
                             if (edgeCount == numEdges && vertexCount == numVertices)
-                            {
-                                for (int i = 0; i < edgeCount; i++)
-                                {
-                                    Vector2f startPoint = edges[i * 2].position;
-                                    Vector2f endPoint = edges[i * 2 + 1].position;
-
-                                    int startVertex = -1;
-                                    int endVertex = -1;
-
-                                    // Find the index of start and end vertices in the vertices vector
-                                    for (int j = 0; j < vertexCount; j++)
-                                    {
-                                        if (getCenter(vertices[j]) == startPoint)
-                                            startVertex = j;
-                                        if (getCenter(vertices[j]) == endPoint)
-                                            endVertex = j;
-                                    }
-
-                                    if (startVertex != -1 && endVertex != -1 && !(startVertex == endVertex))
-                                    {
-                                        adjacencyMatrix[startVertex][endVertex] += 1;
-                                        adjacencyMatrix[endVertex][startVertex] += 1;
-                                    }
-                                    else
-                                        adjacencyMatrix[startVertex][endVertex] += 1;
-                                }
-
-                                // Output the adjacency matrix
-                                cout << "\nAdjacency Matrix of Drawn Graph:" << endl;
-
-                                for (int i = 0; i < numVertices; i++)
-                                {
-                                    for (int j = 0; j < numVertices; j++)
-                                    {
-                                        cout << adjacencyMatrix[i][j] << " ";
-                                    }
-                                    cout << endl;
-                                }
-
-                                for (int i = 0; i < numVertices; i++)
-                                {
-                                    int degree = 0;
-                                    for (int j = 0; j < numVertices; j++)
-                                    {
-                                        degree += adjacencyMatrix[i][j];
-                                    }
-                                    degrees[i] = degree;
-                                }
-
-                                // Output the degree of each vertex
-                                cout << "\nDegree of the Graph of Drawn Graph:" << endl;
-
-                                for (int i = 0; i < numVertices; i++)
-                                {
-                                    cout << "Vertex " << i + 1 << ": " << degrees[i] << endl;
-                                }
-
-                                // Output the adjacency matrix for the isomorphic graph 1
-                                cout << "\nAdjacency Matrix for Generated Graph 1:" << endl;
-                                for (int i = 0; i < numVertices; i++)
-                                {
-                                    for (int j = 0; j < numVertices; j++)
-                                    {
-                                        int isomorphicValue = adjacencyMatrix[i][j] > 0 ? 1 : 0;
-                                        cout << isomorphicValue << " ";
-                                    }
-                                    cout << endl;
-                                }
-
-                                for (int i = 0; i < numVertices; i++)
-                                {
-                                    int degree = 0;
-                                    for (int j = 0; j < numVertices; j++)
-                                    {
-                                        degree += adjacencyMatrix[i][j] > 0 ? 1 : 0;
-                                    }
-                                    degrees[i] = degree;
-                                }
-
-                                // Output the degree of each vertex for the isomorphic graph 1
-                                cout << "\nDegree of the Generated Graph 1:" << endl;
-                                for (int i = 0; i < numVertices; i++)
-                                {
-                                    cout << "Vertex " << i + 1 << ": " << degrees[i] << endl;
-                                }
-
-                                // Output the adjacency matrix for the isomorphic graph 2
-                                cout << "\nAdjacency Matrix for Generated Graph 2:" << endl;
-                                for (int i = 0; i < numVertices; i++)
-                                {
-                                    for (int j = 0; j < numVertices; j++)
-                                    {
-                                        int isomorphicValue = adjacencyMatrix[i][j] > 0 ? 1 : 0;
-                                        cout << isomorphicValue << " ";
-                                    }
-                                    cout << endl;
-                                }
-
-                                for (int i = 0; i < numVertices; i++)
-                                {
-                                    int degree = 0;
-                                    for (int j = 0; j < numVertices; j++)
-                                    {
-                                        degree += adjacencyMatrix[i][j] > 0 ? 1 : 0;
-                                    }
-                                    degrees[i] = degree;
-                                }
-
-                                // Output the degree of each vertex for the isomorphic graph 2
-                                cout << "\nDegree of the Generated Graph 2:" << endl;
-                                for (int i = 0; i < numVertices; i++)
-                                {
-                                    cout << "Vertex " << i + 1 << ": " << degrees[i] << endl;
-                                }
-                            }
+                                completeDrawing();
                         }
                     }
                 }
                 break;
+
+            case Event::MouseButtonReleased:
+                if (ev.mouseButton.button == Mouse::Left && draggedVertex != -1)
+                {
+                    // The drop is journalled once rather than every step of the way
+                    if (vertices[draggedVertex].getPosition() != dragStart)
+                    {
+                        if (journal)
+                            journal->vertexMoved(draggedVertex, vertices[draggedVertex].getPosition());
+                        if (drawingCrossings >= 0 || crossingsPending)
+                            recountDrawingCrossings();
+                    }
+                    draggedVertex = -1;
+                }
+                break;
             }
         }
 
+        // The dragged vertex follows the mouse, once a frame however many
+        // moves came in, and stays inside the drawing area
+        if (draggedVertex != -1)
+        {
+            Vector2f position = static_cast<Vector2f>(Mouse::getPosition(window)) + dragOffset;
+            float diameter = vertices[draggedVertex].getRadius() * 2;
+            position.x = max(drawingArea.left, min(position.x, drawingArea.left + drawingArea.width - diameter));
+            position.y = max(drawingArea.top, min(position.y, drawingArea.top + drawingArea.height - diameter));
+            if (position != vertices[draggedVertex].getPosition())
+                moveDrawnVertex(draggedVertex, position);
+        }
+
         // Update
         // Vertex lights up when the mouse cursor hovers over it
-            if (edgeToolActive && vertexCount > 0)
+            if ((edgeToolActive || moveToolActive) && vertexCount > 0)
             {
                 // Get the mouse position relative to the window
                 Vector2f mousePosition = static_cast<Vector2f>(Mouse::getPosition(window));
@@ -606,7 +2092,7 @@ int main()
                     }
                     else
                     {
-                        vertices[i].setFillColor(Color::White);
+                        vertices[i].setFillColor(vertexColour(vertexColours[i]));
                     }
                 }
             }
@@ -614,7 +2100,14 @@ int main()
             {
                 for (int i = 0; i < vertexCount; i++)
                 {
-                    vertices[i].setFillColor(Color::White);
+                    vertices[i].setFillColor(vertexColour(vertexColours[i]));
+                }
+                if (verifyModeActive && verifySource != -1)
+                    vertices[verifySource].setFillColor(Color::Yellow);
+                if (patternModeActive)
+                {
+                    for (int v : patternChoice)
+                        vertices[v].setFillColor(Color::Yellow);
                 }
             }
 
@@ -639,10 +2132,18 @@ int main()
         
         window.draw(curveLine);
 
-        for (int i = 0; i < edgeCount; i++)
+        // Straight edges are collected and drawn in one call, loops are kept
+        // as shapes; both only change when the edges do
+        if (lineBatchStale)
+        {
+            lineBatch.clear();
+            loops.clear();
+            movedLineSlots.clear();
+            fill(lineSlot.begin(), lineSlot.end(), -1);
+            fill(loopSlot.begin(), loopSlot.end(), -1);
+            for (int i = 0; i < edgeCount; i++)
             {
                 Vector2f startPoint = edges[i * 2].position;
-                Vector2f endPoint = edges[i * 2 + 1].position;
 
                 if (isLoopOrLine[i] == "Loop")
                 {
@@ -660,15 +2161,14 @@ int main()
                     {
                         float scaleFactor = 1.0f + 0.1f * updatingDegree[degreeIndex[i]];
 
-                        // Draw a loop (circle) at the center of the vertex
+                        // A loop (circle) at the center of the vertex
                         CircleShape loop(25 * scaleFactor);
                         loop.setFillColor(Color::Transparent);
                         loop.setOutlineThickness(2.f);
                         loop.setOutlineColor(Color(50, 100, 150, 255));
                         loop.setOrigin(Vector2f(10, 10));
                         loop.setPosition(startPoint);
-                        window.draw(loop);
-
+                        loopSlot[i] = (int)loops.size();
                         loops.push_back(loop);
                     }
                 }
@@ -677,66 +2177,162 @@ int main()
                     // Draw the line if it's not a loop and the degree is odd
                     if (updatingDegree[i] % 2 != 0)
                     {
-                        Vertex line[] = {edges[i * 2], edges[i * 2 + 1]};
-                        window.draw(line, 2, Lines);
+                        lineSlot[i] = (int)lineBatch.size();
+                        lineBatch.push_back(edges[i * 2]);
+                        lineBatch.push_back(edges[i * 2 + 1]);
                     }
                 }
             }
-            for (const auto& loop : loops)
+            lineBatchStale = false;
+            lineBufferReady = !lineBatch.empty() && VertexBuffer::isAvailable() && lineBuffer.create(lineBatch.size()) &&
+                              lineBuffer.update(lineBatch.data());
+        }
+
+        // A drag only sends the slots it moved
+        if (!movedLineSlots.empty())
+        {
+            if (lineBufferReady)
             {
-                window.draw(loop);
+                sort(movedLineSlots.begin(), movedLineSlots.end());
+                movedLineSlots.erase(unique(movedLineSlots.begin(), movedLineSlots.end()), movedLineSlots.end());
+                int runs = 1;
+                for (size_t k = 1; k < movedLineSlots.size(); k++)
+                {
+                    if (movedLineSlots[k] != movedLineSlots[k - 1] + 2)
+                        runs++;
+                }
+                if (runs > lineUploadRuns)
+                {
+                    int first = movedLineSlots.front();
+                    int last = movedLineSlots.back() + 2;
+                    lineBuffer.update(lineBatch.data() + first, last - first, first);
+                }
+                else
+                {
+                    size_t runStart = 0;
+                    for (size_t k = 1; k <= movedLineSlots.size(); k++)
+                    {
+                        if (k < movedLineSlots.size() && movedLineSlots[k] == movedLineSlots[k - 1] + 2)
+                            continue;
+                        int first = movedLineSlots[runStart];
+                        int last = movedLineSlots[k - 1] + 2;
+                        lineBuffer.update(lineBatch.data() + first, last - first, first);
+                        runStart = k;
+                    }
+                }
             }
+            movedLineSlots.clear();
+        }
+
+        if (lineBufferReady)
+            window.draw(lineBuffer);
+        else if (!lineBatch.empty())
+            window.draw(lineBatch.data(), lineBatch.size(), Lines);
+        for (const auto& loop : loops)
+        {
+            window.draw(loop);
+        }
 
         // Draw the isomorphic graph vertices and edges
-        for (size_t i = 0; i < isomorphicVertices1.size(); i++)
+        if (panelColoursStale)
         {
-            window.draw(isomorphicVertices1[i]);
+            for (int i = 0; i < panelVertices; i++)
+            {
+                isomorphicVertices1[i].setFillColor(vertexColour(vertexColours[i]));
+                isomorphicVertices2[i].setFillColor(vertexColour(vertexColours[i]));
+            }
+            panelColoursStale = false;
         }
-        for (int i = 0; i < numVertices; i++)
+        if (panelLinesStale)
         {
-            for (int j = i + 1; j < numVertices; j++)
+            auto collectLines = [&](vector<Vertex>& batch, const vector<CircleShape>& panel, Color colour)
             {
-                if (adjacencyMatrix[i][j] > 0)
+                batch.clear();
+                for (int i = 0; i < panelVertices; i++)
                 {
-                    Vector2f startPoint = getCenter(isomorphicVertices1[i]);
-                    Vector2f endPoint = getCenter(isomorphicVertices1[j]);
-
-                    Vertex line1[] =
+                    for (int j = i + 1; j < panelVertices; j++)
                     {
-                        Vertex(startPoint, Color(50, 100, 150, 255)),
-                        Vertex(endPoint, Color(50, 100, 150, 255))
-                    };
-                    window.draw(line1, 2, Lines);
+                        if (adjacencyMatrix[i][j] > 0)
+                        {
+                            batch.push_back(Vertex(getCenter(panel[i]), colour));
+                            batch.push_back(Vertex(getCenter(panel[j]), colour));
+                        }
+                    }
                 }
-            }
+            };
+            collectLines(panelLines1, isomorphicVertices1, Color(50, 100, 150, 255));
+            collectLines(panelLines2, isomorphicVertices2, Color(200, 150, 100, 255));
+            panelLinesStale = false;
+            panelBuffersReady = !panelLines1.empty() && VertexBuffer::isAvailable() && panelBuffer1.create(panelLines1.size()) &&
+                                panelBuffer1.update(panelLines1.data()) && panelBuffer2.create(panelLines2.size()) &&
+                                panelBuffer2.update(panelLines2.data());
+        }
+
+        for (size_t i = 0; i < isomorphicVertices1.size(); i++)
+        {
+            window.draw(isomorphicVertices1[i]);
         }
+        if (panelBuffersReady)
+            window.draw(panelBuffer1);
+        else if (!panelLines1.empty())
+            window.draw(panelLines1.data(), panelLines1.size(), Lines);
 
         for (size_t i = 0; i < isomorphicVertices2.size(); i++)
         {
+            // In verify mode mapped vertices are ringed, red where an edge does not match
+            int preimage = verifyModeActive ? verifyMapping->preimageOf((int)i) : -1;
+            isomorphicVertices2[i].setOutlineThickness(preimage == -1 ? 0.f : 2.f);
+            if (preimage != -1)
+                isomorphicVertices2[i].setOutlineColor(verifyMapping->conflictsAt(preimage) > 0 ? Color::Red : Color::Green);
             window.draw(isomorphicVertices2[i]);
         }
-        for (int i = 0; i < numVertices; i++)
+        if (panelBuffersReady)
+            window.draw(panelBuffer2);
+        else if (!panelLines2.empty())
+            window.draw(panelLines2.data(), panelLines2.size(), Lines);
+
+        // Draw the crossing counts
+        drawingCrossingsText.setString(drawingCrossings < 0 ? "Crossings: -" : "Crossings: " + to_string(drawingCrossings));
+        window.draw(drawingCrossingsText);
+        if (vertexCount > 0)
         {
-            for (int j = i + 1; j < numVertices; j++)
-            {
-                if (adjacencyMatrix[i][j] > 0)
-                {
-                    Vector2f startPoint = getCenter(isomorphicVertices2[i]);
-                    Vector2f endPoint = getCenter(isomorphicVertices2[j]);
-
-                    Vertex line2[] =
-                    {
-                        Vertex(startPoint, Color(200, 150, 100, 255)),
-                        Vertex(endPoint, Color(200, 150, 100, 255))
-                    };
-                    window.draw(line2, 2, Lines);
-                }
-            }
+            int components = connectivity.componentCount();
+            connectivityText.setString(to_string(components) + (components == 1 ? " component" : " components") +
+                                       (connectivity.bipartite() ? ", bipartite" : ", odd cycle"));
+            window.draw(connectivityText);
+        }
+        if (!spectrumFingerprint.empty())
+        {
+            spectrumText.setString(spectrumFingerprint);
+            window.draw(spectrumText);
+        }
+        if (graphComplete && panelVertices > 0)
+        {
+            crossingsText1.setString("Crossings: " + to_string(crossings1));
+            crossingsText2.setString("Crossings: " + to_string(crossings2));
+            window.draw(crossingsText1);
+            window.draw(crossingsText2);
+        }
+        if (verifyModeActive)
+        {
+            verifyText.setString("Mapped " + to_string(verifyMapping->mappedCount()) + "/" + to_string(panelVertices) + ", " +
+                                 to_string(verifyMapping->conflicts()) + " conflicts");
+            verifyText.setFillColor(verifyMapping->consistent() ? Color::Green : Color::Red);
+            window.draw(verifyText);
+        }
+        if (patternModeActive)
+        {
+            bool checked = (int)patternChoice.size() == pattern.numVertices;
+            patternText.setString("Pattern " + to_string(patternChoice.size()) + "/" + to_string(pattern.numVertices) +
+                                  (!checked ? string(" picked") : patternFound ? string(", found") : string(", not a match")));
+            patternText.setFillColor(!checked ? Color::White : patternFound ? Color::Green : Color::Red);
+            window.draw(patternText);
         }
 
         window.display(); // Tell app that window is done drawing
     }
 
     // End of app
+    analysisToken.cancel();
     return 0;
 }
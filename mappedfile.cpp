@@ -0,0 +1,91 @@
+#include "mappedfile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const string& path)
+    : m_open(false), m_data(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+{
+    m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+        return;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size))
+        return;
+    m_size = (size_t)size.QuadPart;
+
+    // Empty files cannot be mapped but are still valid input
+    if (m_size == 0)
+    {
+        m_open = true;
+        return;
+    }
+
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping == nullptr)
+        return;
+    m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    m_open = m_data != nullptr;
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+    if (m_mapping != nullptr)
+        CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+}
+
+#else
+
+MappedFile::MappedFile(const string& path)
+    : m_open(false), m_data(nullptr), m_size(0), m_descriptor(-1)
+{
+    m_descriptor = open(path.c_str(), O_RDONLY);
+    if (m_descriptor < 0)
+        return;
+
+    struct stat status;
+    if (fstat(m_descriptor, &status) != 0)
+        return;
+    m_size = (size_t)status.st_size;
+
+    // Empty files cannot be mapped but are still valid input
+    if (m_size == 0)
+    {
+        m_open = true;
+        return;
+    }
+
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_descriptor, 0);
+    if (data == MAP_FAILED)
+        return;
+    madvise(data, m_size, MADV_SEQUENTIAL);
+    m_data = (const char*)data;
+    m_open = true;
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+        munmap((void*)m_data, m_size);
+    if (m_descriptor >= 0)
+        close(m_descriptor);
+}
+
+#endif
@@ -0,0 +1,92 @@
+#include "parallel.hpp"
+
+using namespace std;
+
+namespace
+{
+    // Set on the pool's threads, and on a caller while its job runs, so a
+    // parallelFor nested inside a task runs serially instead of waiting on
+    // the pool it is part of
+    thread_local bool insidePool = false;
+}
+
+WorkerPool& WorkerPool::instance()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+WorkerPool::WorkerPool()
+{
+    for (int i = 1; i < workerCount(); i++)
+        m_threads.emplace_back(&WorkerPool::loop, this, i);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_stopping = true;
+    }
+    m_start.notify_all();
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+bool WorkerPool::run(int workers, const function<void(int)>& task)
+{
+    if (insidePool || workers - 1 > (int)m_threads.size() || !m_busy.try_lock())
+        return false;
+
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_task = &task;
+        m_workers = workers;
+        m_remaining = workers - 1;
+        m_generation++;
+    }
+    m_start.notify_all();
+
+    insidePool = true;
+    task(0);
+    insidePool = false;
+
+    {
+        unique_lock<mutex> lock(m_lock);
+        m_done.wait(lock, [&]() { return m_remaining == 0; });
+        m_task = nullptr;
+    }
+    m_busy.unlock();
+    return true;
+}
+
+// Wait for each new job and take part in it if its worker count reaches this thread
+void WorkerPool::loop(int index)
+{
+    insidePool = true;
+    unsigned seen = 0;
+    while (true)
+    {
+        const function<void(int)>* task;
+        {
+            unique_lock<mutex> lock(m_lock);
+            m_start.wait(lock, [&]() { return m_generation != seen || m_stopping; });
+            if (m_stopping)
+                return;
+            seen = m_generation;
+            if (index >= m_workers)
+                continue;
+            task = m_task;
+        }
+
+        (*task)(index);
+
+        bool last;
+        {
+            lock_guard<mutex> lock(m_lock);
+            last = --m_remaining == 0;
+        }
+        if (last)
+            m_done.notify_one();
+    }
+}
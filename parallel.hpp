@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of threads used for parallel graph computations. Cached, because
+// hardware_concurrency asks the system every time and parallelFor runs in
+// the inner loops of the layouts.
+inline int workerCount()
+{
+    static const int count = std::max(1, (int)std::thread::hardware_concurrency());
+    return count;
+}
+
+// Threads kept for parallelFor, started on first use and parked between
+// calls, so the layouts' inner loops do not spawn threads every iteration
+class WorkerPool
+{
+public:
+    static WorkerPool& instance();
+
+    // Run task(worker) for every worker in [0, workers), the calling thread
+    // taking worker 0. False when the pool is busy with another caller or the
+    // call comes from inside a task; the caller then runs the workers itself.
+    bool run(int workers, const std::function<void(int)>& task);
+
+private:
+    WorkerPool();
+    ~WorkerPool();
+
+    void loop(int index);
+
+    std::mutex m_busy; // held by the caller whose job the pool is running
+    std::mutex m_lock;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    const std::function<void(int)>* m_task = nullptr;
+    int m_workers = 0;
+    int m_remaining = 0;
+    unsigned m_generation = 0;
+    bool m_stopping = false;
+    std::vector<std::thread> m_threads;
+};
+
+// Split [0, count) into chunks of grainSize and run fn(begin, end, worker) on
+// them. Chunk c always goes to worker c % workers, in increasing order, so
+// per-worker accumulators hold the same sums every run, whether the pool
+// runs the job or the caller has to run it alone.
+template <typename Function>
+void parallelFor(int count, Function fn, int grainSize = 1024)
+{
+    if (count <= 0)
+        return;
+    int chunks = (int)((count + (long long)grainSize - 1) / grainSize);
+    int workers = std::min(workerCount(), chunks);
+    if (workers <= 1)
+    {
+        fn(0, count, 0);
+        return;
+    }
+
+    auto task = [&](int worker)
+    {
+        for (int chunk = worker; chunk < chunks; chunk += workers)
+        {
+            int begin = (int)((long long)chunk * grainSize);
+            fn(begin, (int)std::min<long long>((long long)begin + grainSize, count), worker);
+        }
+    };
+    if (!WorkerPool::instance().run(workers, task))
+    {
+        for (int worker = 0; worker < workers; worker++)
+            task(worker);
+    }
+}
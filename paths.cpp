@@ -0,0 +1,416 @@
+#include "paths.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include "bits.hpp"
+
+using namespace std;
+
+namespace
+{
+    // Work between looks at the cancel token
+    const long long workPerCancelCheck = 1 << 16;
+
+    // Subsets filled between looks at the cancel token
+    const uint32_t subsetsPerCancelCheck = 1 << 16;
+
+    // Quick ways to rule a Hamiltonian path out: a disconnected graph, an
+    // isolated vertex, more than two vertices of degree 1, or a bipartite
+    // graph whose sides differ by more than one, as the path alternates sides
+    bool couldHaveHamiltonianPath(const Graph& graph)
+    {
+        int n = graph.numVertices;
+        int leaves = 0;
+        for (int v = 0; v < n; v++)
+        {
+            if (n > 1 && graph.degree(v) == 0)
+                return false;
+            if (graph.degree(v) == 1)
+                leaves++;
+        }
+        if (leaves > 2)
+            return false;
+
+        vector<int> side(n, -1);
+        vector<int> queue;
+        int sideCounts[2] = {0, 0};
+        bool bipartite = true;
+        if (n > 0)
+        {
+            side[0] = 0;
+            queue.push_back(0);
+        }
+        for (size_t head = 0; head < queue.size(); head++)
+        {
+            int v = queue[head];
+            sideCounts[side[v]]++;
+            graph.forEachNeighbour(v, [&](int w) {
+                if (side[w] == -1)
+                {
+                    side[w] = 1 - side[v];
+                    queue.push_back(w);
+                }
+                else if (side[w] == side[v])
+                    bipartite = false;
+            });
+        }
+        if ((int)queue.size() != n)
+            return false;
+        return !bipartite || abs(sideCounts[0] - sideCounts[1]) <= 1;
+    }
+
+    // ends[S] holds the vertices v of S such that some path through exactly
+    // the vertices of S ends at v. v qualifies if it is next to an end of a
+    // path through S - v, so each subset takes one pass over its vertices.
+    Solvability subsetPath(const Graph& graph, vector<int>& path, const CancelToken* cancel)
+    {
+        int n = graph.numVertices;
+        vector<uint32_t> adjacent(n, 0);
+        for (int v = 0; v < n; v++)
+            graph.forEachNeighbour(v, [&](int w) { adjacent[v] |= (uint32_t)1 << w; });
+
+        uint32_t full = n == 32 ? ~(uint32_t)0 : ((uint32_t)1 << n) - 1;
+        vector<uint32_t> ends((size_t)full + 1, 0);
+        for (uint32_t subset = 1; subset <= full; subset++)
+        {
+            if (subset % subsetsPerCancelCheck == 0 && cancel != nullptr && cancel->cancelled())
+                return Solvability::Unknown;
+            if ((subset & (subset - 1)) == 0)
+            {
+                ends[subset] = subset;
+                continue;
+            }
+            uint32_t reachable = 0;
+            for (uint32_t rest = subset; rest != 0; rest &= rest - 1)
+            {
+                int v = lowestBit(rest);
+                if (ends[subset ^ ((uint32_t)1 << v)] & adjacent[v])
+                    reachable |= (uint32_t)1 << v;
+            }
+            ends[subset] = reachable;
+        }
+        if (ends[full] == 0)
+            return Solvability::Unsolvable;
+
+        // Walk back from any end, each time to an end of the smaller subset
+        path.clear();
+        uint32_t subset = full;
+        int v = lowestBit(ends[full]);
+        while (true)
+        {
+            path.push_back(v);
+            subset ^= (uint32_t)1 << v;
+            if (subset == 0)
+                break;
+            v = lowestBit(ends[subset] & adjacent[v]);
+        }
+        reverse(path.begin(), path.end());
+        return Solvability::Solvable;
+    }
+
+    class PathSearch
+    {
+    public:
+        PathSearch(const Graph& graph, const CancelToken* cancel)
+            : m_graph(graph), m_n(graph.numVertices), m_cancel(cancel), m_visited(graph.numVertices, 0), m_ways(graph.numVertices)
+        {
+        }
+
+        // Every path from start, or until the work limit; true if one was found
+        bool runFrom(int start)
+        {
+            if (m_cancel != nullptr && m_cancel->cancelled())
+            {
+                m_stopped = true;
+                return false;
+            }
+            if (!spend(m_n))
+                return false;
+            for (int v = 0; v < m_n; v++)
+            {
+                m_ways[v] = m_graph.degree(v);
+                m_visited[v] = 0;
+            }
+            m_singleWays = 0;
+            m_cutOff = 0;
+            for (int v = 0; v < m_n; v++)
+            {
+                if (v != start && m_ways[v] == 1)
+                    m_singleWays++;
+            }
+            m_path.assign(1, start);
+            m_visited[start] = 1;
+            m_frames.clear();
+            m_candidates.clear();
+
+            while (true)
+            {
+                if ((int)m_path.size() == m_n)
+                    return true;
+                if (m_stopped)
+                    return false;
+                if (m_frames.size() < m_path.size())
+                    pushCandidates(m_path.back());
+
+                Frame& frame = m_frames.back();
+                if (frame.next == frame.end)
+                {
+                    m_candidates.resize(frame.begin);
+                    m_frames.pop_back();
+                    if (m_path.size() == 1)
+                        return false;
+                    retreat();
+                    continue;
+                }
+
+                int v = m_candidates[frame.next++];
+                advance(v);
+                if (m_cutOff > 0 || m_singleWays > 1)
+                    retreat();
+            }
+        }
+
+        const vector<int>& path() const { return m_path; }
+        bool stopped() const { return m_stopped; }
+
+    private:
+        struct Frame
+        {
+            int begin;
+            int end;
+            int next;
+        };
+
+        // Charge work to the limit; false, and stopped, once it is used up
+        // or the token is cancelled
+        bool spend(long long work)
+        {
+            m_work += work;
+            if (m_work > hamiltonianWorkLimit)
+                m_stopped = true;
+            else if (m_work >= m_nextCancelCheck)
+            {
+                m_nextCancelCheck = m_work + workPerCancelCheck;
+                if (m_cancel != nullptr && m_cancel->cancelled())
+                    m_stopped = true;
+            }
+            return !m_stopped;
+        }
+
+        // Unvisited neighbours of the path end, fewest ways on first
+        void pushCandidates(int end)
+        {
+            spend(m_graph.degree(end) + 1);
+            int begin = (int)m_candidates.size();
+            m_graph.forEachNeighbour(end, [&](int w) {
+                if (!m_visited[w])
+                    m_candidates.push_back(w);
+            });
+            sort(m_candidates.begin() + begin, m_candidates.end(), [&](int a, int b) { return m_ways[a] < m_ways[b]; });
+            m_frames.push_back({begin, (int)m_candidates.size(), begin});
+        }
+
+        // The old end becomes an inner vertex of the path, so its unvisited
+        // neighbours lose a way in; the new end keeps its ways
+        void advance(int v)
+        {
+            int u = m_path.back();
+            spend(m_graph.degree(u) + 1);
+            if (m_ways[v] == 1)
+                m_singleWays--;
+            m_visited[v] = 1;
+            m_path.push_back(v);
+            m_graph.forEachNeighbour(u, [&](int w) {
+                if (m_visited[w])
+                    return;
+                if (m_ways[w] == 2)
+                    m_singleWays++;
+                else if (m_ways[w] == 1)
+                {
+                    m_singleWays--;
+                    m_cutOff++;
+                }
+                m_ways[w]--;
+            });
+        }
+
+        void retreat()
+        {
+            int v = m_path.back();
+            m_path.pop_back();
+            int u = m_path.back();
+            spend(m_graph.degree(u) + 1);
+            m_visited[v] = 0;
+            m_graph.forEachNeighbour(u, [&](int w) {
+                if (m_visited[w] || w == v)
+                    return;
+                m_ways[w]++;
+                if (m_ways[w] == 2)
+                    m_singleWays--;
+                else if (m_ways[w] == 1)
+                {
+                    m_singleWays++;
+                    m_cutOff--;
+                }
+            });
+            if (m_ways[v] == 1)
+                m_singleWays++;
+        }
+
+        const Graph& m_graph;
+        int m_n;
+        const CancelToken* m_cancel;
+        vector<char> m_visited;
+        vector<int> m_ways;       // unvisited neighbours of each unvisited vertex, plus the path end if next to it
+        int m_singleWays = 0;     // unvisited vertices with one way left, each of which must end the path
+        int m_cutOff = 0;         // unvisited vertices with no way left
+        vector<int> m_path;
+        vector<Frame> m_frames;   // candidates still to try at each path position
+        vector<int> m_candidates;
+        long long m_work = 0;
+        long long m_nextCancelCheck = 0;
+        bool m_stopped = false;
+    };
+}
+
+bool eulerTrail(int numVertices, const vector<pair<int, int>>& edgeList, EulerTrail& trail)
+{
+    trail = EulerTrail();
+    int m = (int)edgeList.size();
+
+    // Edges at each vertex, a loop twice at its vertex
+    vector<int> offsets(numVertices + 1, 0);
+    for (const auto& edge : edgeList)
+    {
+        offsets[edge.first + 1]++;
+        offsets[edge.second + 1]++;
+    }
+    int start = -1, odd = 0;
+    for (int v = 0; v < numVertices; v++)
+    {
+        int degree = offsets[v + 1];
+        if (degree % 2 != 0)
+        {
+            if (odd++ == 0)
+                start = v;
+        }
+        else if (start == -1 && degree > 0)
+            start = v;
+        offsets[v + 1] += offsets[v];
+    }
+    if (odd > 2)
+        return false;
+    if (m == 0)
+    {
+        trail.closed = true;
+        return true;
+    }
+    if (odd == 0)
+        start = edgeList[0].first;
+
+    vector<int> incidence(2 * m);
+    {
+        vector<int> fill(offsets.begin(), offsets.end() - 1);
+        for (int e = 0; e < m; e++)
+        {
+            incidence[fill[edgeList[e].first]++] = e;
+            incidence[fill[edgeList[e].second]++] = e;
+        }
+    }
+
+    // Follow unused edges until stuck, then back up, emitting vertices as
+    // they are backed over; the emitted walk, reversed, is the trail
+    vector<char> used(m, 0);
+    vector<int> next(offsets.begin(), offsets.end() - 1);
+    vector<int> vertexStack = {start};
+    vector<int> edgeStack = {-1};
+    while (!vertexStack.empty())
+    {
+        int v = vertexStack.back();
+        while (next[v] < offsets[v + 1] && used[incidence[next[v]]])
+            next[v]++;
+        if (next[v] < offsets[v + 1])
+        {
+            int e = incidence[next[v]++];
+            used[e] = 1;
+            vertexStack.push_back(edgeList[e].first == v ? edgeList[e].second : edgeList[e].first);
+            edgeStack.push_back(e);
+        }
+        else
+        {
+            trail.vertices.push_back(v);
+            if (edgeStack.back() != -1)
+                trail.edges.push_back(edgeStack.back());
+            vertexStack.pop_back();
+            edgeStack.pop_back();
+        }
+    }
+
+    // Edges in another component were never reached
+    if ((int)trail.edges.size() != m)
+    {
+        trail = EulerTrail();
+        return false;
+    }
+    reverse(trail.vertices.begin(), trail.vertices.end());
+    reverse(trail.edges.begin(), trail.edges.end());
+    trail.closed = odd == 0;
+    return true;
+}
+
+Solvability hamiltonianPath(const Graph& graph, vector<int>& path, const CancelToken* cancel)
+{
+    path.clear();
+    int n = graph.numVertices;
+    if (!couldHaveHamiltonianPath(graph))
+        return Solvability::Unsolvable;
+    if (n <= 1)
+    {
+        if (n == 1)
+            path.push_back(0);
+        return Solvability::Solvable;
+    }
+    if (n <= hamiltonianDpLimit)
+        return subsetPath(graph, path, cancel);
+
+    // A vertex of degree 1 has to end the path, so start there if there is
+    // one; otherwise try the starts from the lowest degree up
+    vector<int> starts(n);
+    for (int v = 0; v < n; v++)
+        starts[v] = v;
+    stable_sort(starts.begin(), starts.end(), [&](int a, int b) { return graph.degree(a) < graph.degree(b); });
+    if (graph.degree(starts[0]) == 1)
+        starts.resize(1);
+
+    PathSearch search(graph, cancel);
+    for (int start : starts)
+    {
+        if (search.runFrom(start))
+        {
+            path = search.path();
+            return Solvability::Solvable;
+        }
+        if (search.stopped())
+            return Solvability::Unknown;
+    }
+    return Solvability::Unsolvable;
+}
+
+bool isHamiltonianPath(const Graph& graph, const vector<int>& path)
+{
+    if ((int)path.size() != graph.numVertices)
+        return false;
+    vector<char> seen(graph.numVertices, 0);
+    for (size_t i = 0; i < path.size(); i++)
+    {
+        int v = path[i];
+        if (v < 0 || v >= graph.numVertices || seen[v])
+            return false;
+        seen[v] = 1;
+        if (i > 0 && !graph.adjacent(path[i - 1], v))
+            return false;
+    }
+    return true;
+}
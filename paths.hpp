@@ -0,0 +1,53 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "cancel.hpp"
+#include "graph.hpp"
+
+// Largest graph the Hamiltonian path search solves by dynamic programming
+// over vertex subsets; the table takes 4 * 2^n bytes
+const int hamiltonianDpLimit = 24;
+
+// Work the backtracking Hamiltonian path search spends on bigger graphs
+// before giving up, counted in vertices reset and neighbours scanned
+const long long hamiltonianWorkLimit = 20000000;
+
+// Largest imported graph the Hamiltonian path search is run on at all
+const int hamiltonianVertexLimit = 20000;
+
+// Whether a challenge has an answer, or the search could not tell
+enum class Solvability
+{
+    Solvable,
+    Unsolvable,
+    Unknown
+};
+
+// Walk using every edge exactly once, loops and repeated edges included
+struct EulerTrail
+{
+    bool closed = false;       // ends where it starts
+    std::vector<int> vertices; // edges.size() + 1 vertices, or none without edges
+    std::vector<int> edges;    // indices into the edge list, in walking order
+};
+
+// Hierholzer's algorithm over the edge list in O(V + E), with an explicit
+// stack. The edges must lie in one component and at most two vertices may
+// have odd degree (a loop adds 2); the trail then runs between those two, or
+// is closed when there are none. Returns false when there is no trail.
+bool eulerTrail(int numVertices, const std::vector<std::pair<int, int>>& edgeList, EulerTrail& trail);
+
+// Path through every vertex exactly once. Up to hamiltonianDpLimit vertices
+// it is decided by Held and Karp style dynamic programming: the set of
+// possible path ends for every vertex subset, one bitmask each. Bigger graphs
+// get a backtracking search with an explicit stack, trying the neighbour with
+// the fewest ways on first (Warnsdorff's rule). It prunes as soon as an
+// unvisited vertex is cut off, or more than one is left with a single way in,
+// since that one must end the path. Unknown if the work limit was reached
+// or the token cancelled.
+Solvability hamiltonianPath(const Graph& graph, std::vector<int>& path, const CancelToken* cancel = nullptr);
+
+// Whether path visits every vertex once along edges of the graph
+bool isHamiltonianPath(const Graph& graph, const std::vector<int>& path);
@@ -0,0 +1,910 @@
+#include "planarity.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_set>
+
+using namespace std;
+
+void PlanarEmbedding::reset(int vertices)
+{
+    numVertices = vertices;
+    target.clear();
+    cw.clear();
+    ccw.clear();
+    first.assign(vertices, -1);
+}
+
+int PlanarEmbedding::addEdge(int u, int v)
+{
+    int h = (int)target.size();
+    target.push_back(v);
+    target.push_back(u);
+    cw.resize(h + 2, -1);
+    ccw.resize(h + 2, -1);
+    return h;
+}
+
+void PlanarEmbedding::insertCw(int h, int ref)
+{
+    if (ref == -1)
+    {
+        cw[h] = ccw[h] = h;
+        first[origin(h)] = h;
+        return;
+    }
+    int after = cw[ref];
+    cw[ref] = h;
+    cw[h] = after;
+    ccw[after] = h;
+    ccw[h] = ref;
+}
+
+void PlanarEmbedding::insertCcw(int h, int ref)
+{
+    if (ref == -1)
+    {
+        insertCw(h, -1);
+        return;
+    }
+    insertCw(h, ccw[ref]);
+    if (first[origin(h)] == ref)
+        first[origin(h)] = h;
+}
+
+void PlanarEmbedding::insertFirst(int h)
+{
+    insertCcw(h, first[origin(h)]);
+}
+
+namespace
+{
+    // Run of return edges on one side, from low (lowest return point) to
+    // high; -1 for both when empty
+    struct Interval
+    {
+        int low = -1;
+        int high = -1;
+
+        bool empty() const { return low == -1 && high == -1; }
+    };
+
+    // Return edges that must go on opposite sides. The id identifies a pair
+    // on the stack, as the stack bottoms are compared by identity.
+    struct ConflictPair
+    {
+        Interval left;
+        Interval right;
+        int id = -1;
+    };
+
+    // The three depth-first passes of the left-right test: orient the edges
+    // and find lowpoints, test the constraints, then build the embedding.
+    // Edges are numbered as they are oriented; edge e runs from m_from[e] to
+    // m_to[e] and becomes half-edges 2e and 2e + 1 of the embedding.
+    class LeftRightTest
+    {
+    public:
+        explicit LeftRightTest(const Graph& graph) : m_graph(graph) {}
+
+        bool run(PlanarEmbedding* embedding)
+        {
+            int n = m_graph.numVertices;
+            if (n > 2 && m_graph.numEdges() > 3 * n - 6)
+                return false;
+
+            orient();
+            int edges = (int)m_from.size();
+            auto byNesting = [&](int a, int b) { return m_nestingDepth[a] < m_nestingDepth[b]; };
+            for (auto& out : m_outEdges)
+                stable_sort(out.begin(), out.end(), byNesting);
+
+            m_ref.assign(edges, -1);
+            m_side.assign(edges, 1);
+            m_stackBottom.assign(edges, -1);
+            m_lowptEdge.assign(edges, -1);
+            for (int root : m_roots)
+            {
+                if (!test(root))
+                    return false;
+            }
+            if (!embedding)
+                return true;
+
+            // Signed nesting depths put left edges before right ones
+            for (int e = 0; e < edges; e++)
+                m_nestingDepth[e] *= sign(e);
+            for (auto& out : m_outEdges)
+                stable_sort(out.begin(), out.end(), byNesting);
+
+            embedding->reset(n);
+            for (int e = 0; e < edges; e++)
+                embedding->addEdge(m_from[e], m_to[e]);
+            for (int v = 0; v < n; v++)
+            {
+                int previous = -1;
+                for (int e : m_outEdges[v])
+                {
+                    embedding->insertCw(2 * e, previous);
+                    previous = 2 * e;
+                }
+            }
+
+            m_leftRef.assign(n, -1);
+            m_rightRef.assign(n, -1);
+            for (int root : m_roots)
+                embed(root, *embedding);
+            return true;
+        }
+
+    private:
+        struct Frame
+        {
+            int v;
+            int next;
+            bool descended;
+        };
+
+        int newEdge(int from, int to)
+        {
+            int e = (int)m_from.size();
+            m_from.push_back(from);
+            m_to.push_back(to);
+            m_lowpt.push_back(0);
+            m_lowpt2.push_back(0);
+            m_nestingDepth.push_back(0);
+            m_outEdges[from].push_back(e);
+            return e;
+        }
+
+        // Depth-first orientation. Tree edges point away from the roots and
+        // back edges towards them; a neighbour already visited from deeper
+        // down was oriented from its own end.
+        void orient()
+        {
+            int n = m_graph.numVertices;
+            m_height.assign(n, -1);
+            m_parentEdge.assign(n, -1);
+            m_outEdges.assign(n, vector<int>());
+
+            vector<Frame> frames;
+            for (int root = 0; root < n; root++)
+            {
+                if (m_height[root] != -1)
+                    continue;
+                m_height[root] = 0;
+                m_roots.push_back(root);
+                frames.push_back({root, m_graph.offsets[root], false});
+                while (!frames.empty())
+                {
+                    int v = frames.back().v;
+                    if (frames.back().next == m_graph.offsets[v + 1])
+                    {
+                        frames.pop_back();
+                        if (m_parentEdge[v] != -1)
+                            finishEdge(m_parentEdge[v]);
+                        continue;
+                    }
+
+                    int w = m_graph.neighbours[frames.back().next++];
+                    if (m_height[w] == -1)
+                    {
+                        int e = newEdge(v, w);
+                        m_lowpt[e] = m_lowpt2[e] = m_height[v];
+                        m_parentEdge[w] = e;
+                        m_height[w] = m_height[v] + 1;
+                        frames.push_back({w, m_graph.offsets[w], false});
+                    }
+                    else if (m_height[w] < m_height[v] && (m_parentEdge[v] == -1 || m_from[m_parentEdge[v]] != w))
+                    {
+                        int e = newEdge(v, w);
+                        m_lowpt[e] = m_height[w];
+                        m_lowpt2[e] = m_height[v];
+                        finishEdge(e);
+                    }
+                }
+            }
+        }
+
+        // Nesting depth of a finished edge and the lowpoints it passes up to
+        // the tree edge above it
+        void finishEdge(int e)
+        {
+            int v = m_from[e];
+            m_nestingDepth[e] = 2 * m_lowpt[e];
+            if (m_lowpt2[e] < m_height[v])
+                m_nestingDepth[e]++;
+
+            int parent = m_parentEdge[v];
+            if (parent == -1)
+                return;
+            if (m_lowpt[e] < m_lowpt[parent])
+            {
+                m_lowpt2[parent] = min(m_lowpt[parent], m_lowpt2[e]);
+                m_lowpt[parent] = m_lowpt[e];
+            }
+            else if (m_lowpt[e] > m_lowpt[parent])
+                m_lowpt2[parent] = min(m_lowpt2[parent], m_lowpt[e]);
+            else
+                m_lowpt2[parent] = min(m_lowpt2[parent], m_lowpt2[e]);
+        }
+
+        int topId() const { return m_stack.empty() ? -1 : m_stack.back().id; }
+
+        void push(ConflictPair pair)
+        {
+            if (pair.id == -1)
+                pair.id = m_nextId++;
+            m_stack.push_back(pair);
+        }
+
+        ConflictPair pop()
+        {
+            ConflictPair pair = m_stack.back();
+            m_stack.pop_back();
+            return pair;
+        }
+
+        bool conflicting(const Interval& interval, int e) const
+        {
+            return !interval.empty() && m_lowpt[interval.high] > m_lowpt[e];
+        }
+
+        int lowest(const ConflictPair& pair) const
+        {
+            if (pair.left.empty())
+                return m_lowpt[pair.right.low];
+            if (pair.right.empty())
+                return m_lowpt[pair.left.low];
+            return min(m_lowpt[pair.left.low], m_lowpt[pair.right.low]);
+        }
+
+        void setRef(int e, int value)
+        {
+            if (e != -1)
+                m_ref[e] = value;
+        }
+
+        bool test(int root)
+        {
+            vector<Frame> frames;
+            frames.push_back({root, 0, false});
+            while (!frames.empty())
+            {
+                Frame& frame = frames.back();
+                int v = frame.v;
+                int e = m_parentEdge[v];
+                if (frame.next == (int)m_outEdges[v].size())
+                {
+                    frames.pop_back();
+                    if (e != -1)
+                        removeBackEdges(e);
+                    continue;
+                }
+
+                int ei = m_outEdges[v][frame.next];
+                if (!frame.descended)
+                {
+                    m_stackBottom[ei] = topId();
+                    if (m_parentEdge[m_to[ei]] == ei)
+                    {
+                        frame.descended = true;
+                        frames.push_back({m_to[ei], 0, false});
+                        continue;
+                    }
+                    m_lowptEdge[ei] = ei;
+                    ConflictPair pair;
+                    pair.right.low = pair.right.high = ei;
+                    push(pair);
+                }
+                frame.descended = false;
+                frame.next++;
+
+                // Integrate the return edges of ei
+                if (m_lowpt[ei] < m_height[v])
+                {
+                    if (ei == m_outEdges[v][0])
+                        m_lowptEdge[e] = m_lowptEdge[ei];
+                    else if (!addConstraints(ei, e))
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        bool addConstraints(int ei, int e)
+        {
+            ConflictPair pair;
+
+            // Merge the return edges of ei into the right interval
+            do
+            {
+                ConflictPair q = pop();
+                if (!q.left.empty())
+                    swap(q.left, q.right);
+                if (!q.left.empty())
+                    return false;
+                if (m_lowpt[q.right.low] > m_lowpt[e])
+                {
+                    if (pair.right.empty())
+                        pair.right = q.right;
+                    else
+                        setRef(pair.right.low, q.right.high);
+                    pair.right.low = q.right.low;
+                }
+                else
+                    setRef(q.right.low, m_lowptEdge[e]);
+            } while (topId() != m_stackBottom[ei]);
+
+            // Merge the conflicting return edges of earlier siblings into the left
+            while (!m_stack.empty() && (conflicting(m_stack.back().left, ei) || conflicting(m_stack.back().right, ei)))
+            {
+                ConflictPair q = pop();
+                if (conflicting(q.right, ei))
+                    swap(q.left, q.right);
+                if (conflicting(q.right, ei))
+                    return false;
+                setRef(pair.right.low, q.right.high);
+                if (q.right.low != -1)
+                    pair.right.low = q.right.low;
+                if (pair.left.empty())
+                    pair.left = q.left;
+                else
+                    setRef(pair.left.low, q.left.high);
+                pair.left.low = q.left.low;
+            }
+
+            if (!pair.left.empty() || !pair.right.empty())
+                push(pair);
+            return true;
+        }
+
+        // Drop the back edges that end at the parent of tree edge e
+        void removeBackEdges(int e)
+        {
+            int u = m_from[e];
+            while (!m_stack.empty() && lowest(m_stack.back()) == m_height[u])
+            {
+                ConflictPair pair = pop();
+                if (pair.left.low != -1)
+                    m_side[pair.left.low] = -1;
+            }
+
+            if (!m_stack.empty())
+            {
+                ConflictPair pair = pop();
+                while (pair.left.high != -1 && m_to[pair.left.high] == u)
+                    pair.left.high = m_ref[pair.left.high];
+                if (pair.left.high == -1 && pair.left.low != -1)
+                {
+                    m_ref[pair.left.low] = pair.right.low;
+                    m_side[pair.left.low] = -1;
+                    pair.left.low = -1;
+                }
+                while (pair.right.high != -1 && m_to[pair.right.high] == u)
+                    pair.right.high = m_ref[pair.right.high];
+                if (pair.right.high == -1 && pair.right.low != -1)
+                {
+                    m_ref[pair.right.low] = pair.left.low;
+                    m_side[pair.right.low] = -1;
+                    pair.right.low = -1;
+                }
+                push(pair);
+            }
+
+            // e goes on the side of its highest return edge
+            if (m_lowpt[e] < m_height[u] && !m_stack.empty())
+            {
+                int highLeft = m_stack.back().left.high;
+                int highRight = m_stack.back().right.high;
+                if (highLeft != -1 && (highRight == -1 || m_lowpt[highLeft] > m_lowpt[highRight]))
+                    m_ref[e] = highLeft;
+                else
+                    m_ref[e] = highRight;
+            }
+        }
+
+        // Side of e relative to its tree edge: the product of the sides
+        // along its chain of references, which are then cleared
+        int sign(int e)
+        {
+            m_chain.clear();
+            while (m_ref[e] != -1)
+            {
+                m_chain.push_back(e);
+                e = m_ref[e];
+            }
+            for (int i = (int)m_chain.size() - 1; i >= 0; i--)
+            {
+                m_side[m_chain[i]] *= m_side[e];
+                m_ref[m_chain[i]] = -1;
+                e = m_chain[i];
+            }
+            return m_side[e];
+        }
+
+        // Place the incoming half-edges: the tree edge from the parent first,
+        // back edges next to the most recent tree edge on their side
+        void embed(int root, PlanarEmbedding& embedding)
+        {
+            vector<Frame> frames;
+            frames.push_back({root, 0, false});
+            while (!frames.empty())
+            {
+                int v = frames.back().v;
+                if (frames.back().next == (int)m_outEdges[v].size())
+                {
+                    frames.pop_back();
+                    continue;
+                }
+
+                int ei = m_outEdges[v][frames.back().next++];
+                int w = m_to[ei];
+                if (m_parentEdge[w] == ei)
+                {
+                    embedding.insertFirst(2 * ei + 1);
+                    m_leftRef[v] = m_rightRef[v] = 2 * ei;
+                    frames.push_back({w, 0, false});
+                }
+                else if (m_side[ei] == 1)
+                    embedding.insertCw(2 * ei + 1, m_rightRef[w]);
+                else
+                {
+                    embedding.insertCcw(2 * ei + 1, m_leftRef[w]);
+                    m_leftRef[w] = 2 * ei + 1;
+                }
+            }
+        }
+
+        const Graph& m_graph;
+        vector<int> m_height;
+        vector<int> m_parentEdge;
+        vector<int> m_roots;
+        vector<vector<int>> m_outEdges;
+
+        vector<int> m_from;
+        vector<int> m_to;
+        vector<int> m_lowpt;
+        vector<int> m_lowpt2;
+        vector<int> m_nestingDepth;
+
+        vector<int> m_ref;
+        vector<int> m_side;
+        vector<int> m_stackBottom;
+        vector<int> m_lowptEdge;
+        vector<ConflictPair> m_stack;
+        int m_nextId = 0;
+        vector<int> m_chain;
+
+        vector<int> m_leftRef;
+        vector<int> m_rightRef;
+    };
+}
+
+bool planarEmbedding(const Graph& graph, PlanarEmbedding& embedding)
+{
+    return LeftRightTest(graph).run(&embedding);
+}
+
+bool isPlanar(const Graph& graph)
+{
+    return LeftRightTest(graph).run(nullptr);
+}
+
+namespace
+{
+    uint64_t edgeKey(int u, int v)
+    {
+        if (u > v)
+            swap(u, v);
+        return ((uint64_t)u << 32) | (uint32_t)v;
+    }
+
+    // Augments an embedding until it is biconnected and every face but the
+    // outer one is a triangle, keeping it planar
+    class Triangulator
+    {
+    public:
+        explicit Triangulator(PlanarEmbedding& embedding) : m_embedding(embedding)
+        {
+            for (int h = 0; h < embedding.numHalfEdges(); h += 2)
+                m_edges.insert(edgeKey(embedding.target[h], embedding.target[h + 1]));
+            m_onFace.assign(embedding.numVertices, -1);
+        }
+
+        // Returns the vertices of the outer face in order
+        vector<int> run()
+        {
+            connectComponents();
+
+            // Trace every face once, splitting off the parts around repeated
+            // vertices, and keep the largest as the outer face
+            vector<int> outerFace;
+            vector<int> faceStarts;
+            int outerStart = -1;
+            for (int v = 0; v < m_embedding.numVertices; v++)
+            {
+                int start = m_embedding.first[v];
+                int h = start;
+                do
+                {
+                    vector<int> face = traceFace(h);
+                    if (!face.empty())
+                    {
+                        faceStarts.push_back(h);
+                        if (face.size() > outerFace.size())
+                        {
+                            outerFace = face;
+                            outerStart = h;
+                        }
+                    }
+                    h = m_embedding.cw[h];
+                } while (h != start);
+            }
+
+            for (int h : faceStarts)
+            {
+                if (h != outerStart)
+                    triangulateFace(h);
+            }
+            return outerFace;
+        }
+
+    private:
+        // Edge u-v with u->v clockwise after refAtU and v->u counter-clockwise
+        // before refAtV
+        int addEdge(int u, int v, int refAtU, int refAtV)
+        {
+            int h = m_embedding.addEdge(u, v);
+            m_embedding.insertCw(h, refAtU);
+            m_embedding.insertCcw(h ^ 1, refAtV);
+            m_edges.insert(edgeKey(u, v));
+            m_visited.resize(m_embedding.numHalfEdges(), 0);
+            return h;
+        }
+
+        void connectComponents()
+        {
+            int n = m_embedding.numVertices;
+            vector<char> reached(n, 0);
+            vector<int> queue;
+            int previous = -1;
+            for (int start = 0; start < n; start++)
+            {
+                if (reached[start])
+                    continue;
+                if (previous != -1)
+                {
+                    int h = m_embedding.addEdge(previous, start);
+                    m_embedding.insertCcw(h, m_embedding.first[previous]);
+                    m_embedding.insertCcw(h ^ 1, m_embedding.first[start]);
+                    m_edges.insert(edgeKey(previous, start));
+                }
+                previous = start;
+
+                reached[start] = 1;
+                queue.assign(1, start);
+                for (size_t head = 0; head < queue.size(); head++)
+                {
+                    int v = queue[head];
+                    int first = m_embedding.first[v];
+                    for (int h = first; h != -1;)
+                    {
+                        int w = m_embedding.target[h];
+                        if (!reached[w])
+                        {
+                            reached[w] = 1;
+                            queue.push_back(w);
+                        }
+                        h = m_embedding.cw[h];
+                        if (h == first)
+                            break;
+                    }
+                }
+            }
+            m_visited.assign(m_embedding.numHalfEdges(), 0);
+        }
+
+        // Walk the face left of h0, adding an edge across every vertex met a
+        // second time so the face becomes a simple cycle. Returns its
+        // vertices, or nothing when the face was walked already.
+        vector<int> traceFace(int h0)
+        {
+            vector<int> face;
+            if (m_visited[h0])
+                return face;
+            m_visited[h0] = 1;
+            m_stamp++;
+            face.push_back(m_embedding.origin(h0));
+            m_onFace[face.back()] = m_stamp;
+
+            int h = h0;
+            int next = m_embedding.nextOnFace(h);
+            while (next != h0)
+            {
+                int v2 = m_embedding.target[h];
+                if (m_onFace[v2] == m_stamp)
+                {
+                    int chord = addEdge(m_embedding.origin(h), m_embedding.target[next], h, next ^ 1);
+                    m_visited[next] = 1;
+                    m_visited[chord ^ 1] = 1;
+                    h = chord;
+                }
+                else
+                {
+                    m_onFace[v2] = m_stamp;
+                    face.push_back(v2);
+                    h = next;
+                }
+                m_visited[h] = 1;
+                next = m_embedding.nextOnFace(h);
+            }
+            return face;
+        }
+
+        // Fan the face left of h12 into triangles, stepping past any corner
+        // whose diagonal is already an edge elsewhere
+        void triangulateFace(int h12)
+        {
+            int h23 = m_embedding.nextOnFace(h12);
+            int v1 = m_embedding.origin(h12);
+            if (v1 == m_embedding.target[h12] || v1 == m_embedding.target[h23])
+                return;
+
+            int v4 = m_embedding.target[m_embedding.nextOnFace(h23)];
+            while (v1 != v4)
+            {
+                int v3 = m_embedding.target[h23];
+                if (m_edges.count(edgeKey(v1, v3)))
+                    h12 = h23;
+                else
+                    h12 = addEdge(v1, v3, h12, h23 ^ 1);
+                h23 = m_embedding.nextOnFace(h12);
+                v1 = m_embedding.origin(h12);
+                v4 = m_embedding.target[m_embedding.nextOnFace(h23)];
+            }
+        }
+
+        PlanarEmbedding& m_embedding;
+        unordered_set<uint64_t> m_edges;
+        vector<char> m_visited;
+        vector<int> m_onFace;
+        int m_stamp = 0;
+    };
+
+    // Canonical ordering of an internally triangulated biconnected embedding
+    // (the contraction order read backwards). Vertex k > 1 comes with the
+    // stretch of the current contour it covers, wp first and wq last.
+    void canonicalOrdering(const PlanarEmbedding& embedding, const vector<int>& outerFace, vector<int>& order, vector<vector<int>>& contours)
+    {
+        int n = embedding.numVertices;
+        int v1 = outerFace[0];
+        int v2 = outerFace[1];
+
+        // Neighbours along the outer face; -1 where a vertex has none yet
+        vector<int> outerCcw(n, -1), outerCw(n, -1);
+        int previous = v2;
+        for (size_t i = 2; i < outerFace.size(); i++)
+        {
+            outerCcw[previous] = outerFace[i];
+            previous = outerFace[i];
+        }
+        outerCcw[previous] = v1;
+        previous = v1;
+        for (size_t i = outerFace.size() - 1; i >= 1; i--)
+        {
+            outerCw[previous] = outerFace[i];
+            previous = outerFace[i];
+        }
+
+        vector<char> marked(n, 0);
+        auto onOuterFace = [&](int x) { return !marked[x] && (outerCcw[x] != -1 || x == v1); };
+        auto outerNeighbours = [&](int x, int y)
+        {
+            if (outerCcw[x] == -1)
+                return outerCw[x] == y;
+            if (outerCw[x] == -1)
+                return outerCcw[x] == y;
+            return outerCw[x] == y || outerCcw[x] == y;
+        };
+        auto forEachNeighbour = [&](int x, auto fn)
+        {
+            int first = embedding.first[x];
+            int h = first;
+            do
+            {
+                fn(h);
+                h = embedding.cw[h];
+            } while (h != first);
+        };
+
+        // Outer vertices without chords are ready to be removed
+        vector<int> chords(n, 0);
+        vector<char> ready(n, 0);
+        vector<int> readyStack;
+        auto addReady = [&](int x)
+        {
+            if (!ready[x])
+            {
+                ready[x] = 1;
+                readyStack.push_back(x);
+            }
+        };
+        for (int v : outerFace)
+            addReady(v);
+        for (int v : outerFace)
+        {
+            forEachNeighbour(v, [&](int h)
+            {
+                int w = embedding.target[h];
+                if (onOuterFace(w) && !outerNeighbours(v, w))
+                {
+                    chords[v]++;
+                    ready[v] = 0;
+                }
+            });
+        }
+        ready[v1] = ready[v2] = 0;
+
+        order.assign(n, -1);
+        contours.assign(n, vector<int>());
+        order[0] = v1;
+        order[1] = v2;
+        vector<int> newFace(n, -1);
+        for (int k = n - 1; k > 1; k--)
+        {
+            while (!ready[readyStack.back()])
+                readyStack.pop_back();
+            int v = readyStack.back();
+            readyStack.pop_back();
+            ready[v] = 0;
+            marked[v] = 1;
+
+            // v has exactly two neighbours on the contour, wp and wq
+            int wp = -1, wq = -1, toWp = -1;
+            for (int h = embedding.first[v];; h = embedding.cw[h])
+            {
+                int w = embedding.target[h];
+                if (!marked[w] && onOuterFace(w))
+                {
+                    if (w == v1 || (w != v2 && outerCw[w] == v))
+                    {
+                        wp = w;
+                        toWp = h;
+                    }
+                    else
+                        wq = w;
+                }
+                if (wp != -1 && wq != -1)
+                    break;
+            }
+
+            // The neighbours of v from wp to wq join the contour
+            vector<int>& contour = contours[k];
+            contour.push_back(wp);
+            for (int h = toWp, w = wp; w != wq;)
+            {
+                h = embedding.ccw[h];
+                int next = embedding.target[h];
+                contour.push_back(next);
+                outerCw[w] = next;
+                outerCcw[next] = w;
+                w = next;
+            }
+
+            if (contour.size() == 2)
+            {
+                // The edge wp-wq was a chord
+                if (--chords[wp] == 0)
+                    addReady(wp);
+                if (--chords[wq] == 0)
+                    addReady(wq);
+            }
+            else
+            {
+                for (size_t i = 1; i + 1 < contour.size(); i++)
+                    newFace[contour[i]] = k;
+                for (size_t i = 1; i + 1 < contour.size(); i++)
+                {
+                    int w = contour[i];
+                    addReady(w);
+                    forEachNeighbour(w, [&](int h)
+                    {
+                        int x = embedding.target[h];
+                        if (onOuterFace(x) && !outerNeighbours(w, x))
+                        {
+                            chords[w]++;
+                            ready[w] = 0;
+                            if (newFace[x] != k)
+                            {
+                                chords[x]++;
+                                ready[x] = 0;
+                            }
+                        }
+                    });
+                }
+            }
+            order[k] = v;
+        }
+    }
+}
+
+vector<pair<int, int>> straightLineDrawing(PlanarEmbedding embedding)
+{
+    int n = embedding.numVertices;
+    vector<pair<int, int>> positions(n);
+    if (n < 4)
+    {
+        const pair<int, int> corners[] = {{0, 0}, {2, 0}, {1, 1}};
+        for (int v = 0; v < n; v++)
+            positions[v] = corners[v];
+        return positions;
+    }
+
+    vector<int> outerFace = Triangulator(embedding).run();
+    vector<int> order;
+    vector<vector<int>> contours;
+    canonicalOrdering(embedding, outerFace, order, contours);
+
+    // Shift method with x stored relative to the parent in a binary tree:
+    // moving a vertex right moves everything hanging off it for free
+    vector<int> leftChild(n, -1), rightChild(n, -1), deltaX(n, 0), y(n, 0);
+    int v1 = order[0], v2 = order[1], v3 = order[2];
+    deltaX[v2] = 1;
+    deltaX[v3] = 1;
+    y[v3] = 1;
+    rightChild[v1] = v3;
+    rightChild[v3] = v2;
+
+    for (int k = 3; k < n; k++)
+    {
+        int vk = order[k];
+        const vector<int>& contour = contours[k];
+        int wp = contour.front();
+        int wp1 = contour[1];
+        int wq = contour.back();
+        int wq1 = contour[contour.size() - 2];
+        bool coversMore = contour.size() > 2;
+
+        // Stretch the gaps either side of the covered stretch
+        deltaX[wp1]++;
+        deltaX[wq]++;
+        int width = 0;
+        for (size_t i = 1; i < contour.size(); i++)
+            width += deltaX[contour[i]];
+
+        // vk sits where lines of slope +1 and -1 from wp and wq meet
+        deltaX[vk] = (width - y[wp] + y[wq]) / 2;
+        y[vk] = (width + y[wp] + y[wq]) / 2;
+        deltaX[wq] = width - deltaX[vk];
+        if (coversMore)
+            deltaX[wp1] -= deltaX[vk];
+
+        rightChild[wp] = vk;
+        rightChild[vk] = wq;
+        if (coversMore)
+        {
+            leftChild[vk] = wp1;
+            rightChild[wq1] = -1;
+        }
+        else
+            leftChild[vk] = -1;
+    }
+
+    // Absolute x by adding the offsets down the tree
+    positions[v1] = make_pair(0, y[v1]);
+    vector<int> pending(1, v1);
+    while (!pending.empty())
+    {
+        int parent = pending.back();
+        pending.pop_back();
+        for (int child : {leftChild[parent], rightChild[parent]})
+        {
+            if (child == -1)
+                continue;
+            positions[child] = make_pair(positions[parent].first + deltaX[child], y[child]);
+            pending.push_back(child);
+        }
+    }
+    return positions;
+}
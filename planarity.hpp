@@ -0,0 +1,49 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "graph.hpp"
+
+// Combinatorial embedding as a rotation system over half-edges. Edge e is
+// the half-edges 2e and 2e + 1, one in each direction, so h ^ 1 is the way
+// back. Around each vertex the half-edges leaving it form a cyclic list.
+struct PlanarEmbedding
+{
+    int numVertices = 0;
+    std::vector<int> target; // vertex half-edge h runs to
+    std::vector<int> cw;     // next half-edge clockwise around the same origin
+    std::vector<int> ccw;    // next half-edge counter-clockwise
+    std::vector<int> first;  // one half-edge leaving each vertex, or -1
+
+    void reset(int vertices);
+    int numHalfEdges() const { return (int)target.size(); }
+    int origin(int h) const { return target[h ^ 1]; }
+
+    // New edge u-v, not yet placed in either rotation; returns half-edge u->v
+    int addEdge(int u, int v);
+
+    // Place half-edge h in its origin's rotation right after ref clockwise,
+    // or right before it, or as the first; ref -1 means the rotation is empty
+    void insertCw(int h, int ref);
+    void insertCcw(int h, int ref);
+    void insertFirst(int h);
+
+    // Half-edge following h around the face on its left
+    int nextOnFace(int h) const { return ccw[h ^ 1]; }
+};
+
+// Left-right planarity test (Brandes' formulation of de Fraysseix and
+// Rosenstiehl's criterion) in O(V + E), with explicit stacks instead of
+// recursion so long paths cannot overflow the thread stack. Fills embedding
+// and returns true when the graph is planar.
+bool planarEmbedding(const Graph& graph, PlanarEmbedding& embedding);
+
+bool isPlanar(const Graph& graph);
+
+// Crossing-free straight-line drawing of an embedded planar graph on the
+// (2n - 4) x (n - 2) grid by de Fraysseix, Pach and Pollack's shift method,
+// using Chrobak and Payne's relative offsets so it stays linear. The
+// embedding is made connected, biconnected and internally triangulated on a
+// copy first. Returns an (x, y) grid point per vertex, y upwards.
+std::vector<std::pair<int, int>> straightLineDrawing(PlanarEmbedding embedding);
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+// splitmix64 finaliser; spreads a seed (or a seed combined with a stream
+// number) over all 64 bits
+inline std::uint64_t mixSeed(std::uint64_t seed, std::uint64_t stream = 0)
+{
+    std::uint64_t x = seed + 0x9E3779B97F4A7C15ULL * (stream + 1);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// xoshiro256** (Blackman and Vigna). Every puzzle, layout and batch job owns
+// its generator, so there is no shared state between threads, and the same
+// seed gives the same numbers with every compiler and standard library.
+class Random
+{
+public:
+    using result_type = std::uint64_t;
+
+    explicit Random(std::uint64_t seed)
+    {
+        for (int i = 0; i < 4; i++)
+            m_state[i] = mixSeed(seed, (std::uint64_t)i);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~(result_type)0; }
+
+    result_type operator()()
+    {
+        std::uint64_t result = rotate(m_state[1] * 5, 7) * 9;
+        std::uint64_t t = m_state[1] << 17;
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotate(m_state[3], 45);
+        return result;
+    }
+
+    // Uniform integer in [0, bound), by Lemire's multiply and reject
+    std::uint32_t below(std::uint32_t bound)
+    {
+        std::uint64_t product = (std::uint64_t)(std::uint32_t)((*this)() >> 32) * bound;
+        std::uint32_t low = (std::uint32_t)product;
+        if (low < bound)
+        {
+            std::uint32_t threshold = (0u - bound) % bound;
+            while (low < threshold)
+            {
+                product = (std::uint64_t)(std::uint32_t)((*this)() >> 32) * bound;
+                low = (std::uint32_t)product;
+            }
+        }
+        return (std::uint32_t)(product >> 32);
+    }
+
+    // Uniform integer in [0, bound) for bounds past 32 bits: draws from the
+    // incomplete top stretch of the 64-bit range are rejected
+    std::uint64_t below64(std::uint64_t bound)
+    {
+        if (bound <= 0xFFFFFFFFu)
+            return below((std::uint32_t)bound);
+        std::uint64_t threshold = (0 - bound) % bound;
+        std::uint64_t value = (*this)();
+        while (value < threshold)
+            value = (*this)();
+        return value % bound;
+    }
+
+    // Uniform integer in [low, high]
+    int between(int low, int high) { return low + (int)below((std::uint32_t)(high - low) + 1u); }
+
+    // Uniform real in [low, high)
+    float uniform(float low, float high) { return low + (high - low) * ((float)((*this)() >> 40) * 0x1.0p-24f); }
+    double uniform(double low, double high) { return low + (high - low) * ((double)((*this)() >> 11) * 0x1.0p-53); }
+
+private:
+    static std::uint64_t rotate(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    std::uint64_t m_state[4];
+};
+
+// Fisher-Yates shuffle
+template <typename T>
+void permute(std::vector<T>& items, Random& rng)
+{
+    for (std::uint32_t i = (std::uint32_t)items.size(); i > 1; i--)
+        std::swap(items[i - 1], items[rng.below(i)]);
+}
+
+// Uniformly random permutation of 0 .. n - 1
+inline std::vector<int> randomPermutation(int n, Random& rng)
+{
+    std::vector<int> permutation(n);
+    for (int i = 0; i < n; i++)
+        permutation[i] = i;
+    permute(permutation, rng);
+    return permutation;
+}
+
+// Seed for a new puzzle when none is given; taken from the clock because
+// random_device is deterministic on some MinGW toolchains
+inline unsigned newPuzzleSeed()
+{
+    return (unsigned)mixSeed((std::uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count());
+}
+
+// Parse --seed <number> from the command line, or make a new seed
+inline unsigned seedFromArguments(int argc, char* argv[])
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (std::string(argv[i]) == "--seed")
+            return (unsigned)std::strtoul(argv[i + 1], nullptr, 10);
+    }
+    return newPuzzleSeed();
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstring>
+
+// Cursor over a mapped text file. Nothing is copied or allocated; tokens are
+// read straight out of the mapping.
+struct Scanner
+{
+    const char* pos;
+    const char* end;
+    long long line;
+
+    bool atEnd() const { return pos == end; }
+
+    void skipBlanks()
+    {
+        while (pos != end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == ','))
+            pos++;
+    }
+
+    bool atLineEnd()
+    {
+        skipBlanks();
+        return pos == end || *pos == '\n';
+    }
+
+    void nextLine()
+    {
+        const char* newline = (const char*)memchr(pos, '\n', end - pos);
+        pos = newline == nullptr ? end : newline + 1;
+        line++;
+    }
+
+    // Unsigned number no larger than limit
+    bool readNumber(long long& value, long long limit = 2147483647LL)
+    {
+        skipBlanks();
+        if (pos == end || *pos < '0' || *pos > '9')
+            return false;
+        value = 0;
+        while (pos != end && *pos >= '0' && *pos <= '9')
+        {
+            value = value * 10 + (*pos - '0');
+            if (value > limit)
+                return false;
+            pos++;
+        }
+        return true;
+    }
+
+    // Optionally signed decimal such as -12.5, without an exponent
+    bool readDecimal(double& value)
+    {
+        skipBlanks();
+        bool negative = pos != end && *pos == '-';
+        if (negative)
+            pos++;
+
+        long long whole;
+        if (!readNumber(whole))
+            return false;
+        value = (double)whole;
+        if (pos != end && *pos == '.')
+        {
+            pos++;
+            double scale = 0.1;
+            while (pos != end && *pos >= '0' && *pos <= '9')
+            {
+                value += (*pos++ - '0') * scale;
+                scale *= 0.1;
+            }
+        }
+        if (negative)
+            value = -value;
+        return true;
+    }
+
+    // Word of lower case letters, compared with the expected keyword
+    bool readWord(const char* word)
+    {
+        skipBlanks();
+        size_t length = strlen(word);
+        if ((size_t)(end - pos) < length || memcmp(pos, word, length) != 0)
+            return false;
+        pos += length;
+        return true;
+    }
+
+    // Rest of the current line, without the line break
+    const char* lineEnd() const
+    {
+        const char* newline = (const char*)memchr(pos, '\n', end - pos);
+        return newline == nullptr ? end : newline;
+    }
+};
@@ -0,0 +1,100 @@
+#include "scheduler.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+    // Which scheduler and deque the current thread works for, if any
+    thread_local const TaskScheduler* currentScheduler = nullptr;
+    thread_local int currentWorker = -1;
+}
+
+TaskScheduler::TaskScheduler(int threads) : m_pending(0), m_nextQueue(0), m_stopping(false)
+{
+    threads = max(threads, 1);
+    for (int i = 0; i < threads; i++)
+        m_queues.push_back(unique_ptr<Queue>(new Queue));
+    for (int i = 0; i < threads; i++)
+        m_threads.emplace_back(&TaskScheduler::run, this, i);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        lock_guard<mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+void TaskScheduler::submit(function<void()> task)
+{
+    int index = currentScheduler == this ? currentWorker : (int)(m_nextQueue++ % m_queues.size());
+    {
+        lock_guard<mutex> lock(m_queues[index]->mutex);
+        m_queues[index]->tasks.push_back(move(task));
+    }
+
+    // Bump the count under the sleep lock so a worker about to wait cannot miss it
+    {
+        lock_guard<mutex> lock(m_sleepMutex);
+        m_pending++;
+    }
+    m_wake.notify_one();
+}
+
+bool TaskScheduler::take(int index, function<void()>& task)
+{
+    // Own deque first, newest task
+    {
+        Queue& own = *m_queues[index];
+        lock_guard<mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Then steal the oldest task of the other workers
+    for (size_t offset = 1; offset < m_queues.size(); offset++)
+    {
+        Queue& victim = *m_queues[(index + offset) % m_queues.size()];
+        lock_guard<mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TaskScheduler::run(int index)
+{
+    currentScheduler = this;
+    currentWorker = index;
+
+    while (true)
+    {
+        function<void()> task;
+        if (take(index, task))
+        {
+            m_pending--;
+            task();
+            continue;
+        }
+
+        unique_lock<mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this]() { return m_stopping || m_pending > 0; });
+        if (m_stopping)
+            return;
+    }
+}
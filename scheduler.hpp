@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cancel.hpp"
+#include "parallel.hpp"
+
+// Work-stealing scheduler for analysis jobs (isomorphism checks, layouts,
+// invariants, exports) so the render thread never waits on graph work.
+// Every worker owns a deque: it takes its newest task from the back and,
+// when empty, steals the oldest task from the front of another worker.
+class TaskScheduler
+{
+public:
+    explicit TaskScheduler(int threads = workerCount());
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Queue a task. Tasks submitted from a worker stay on that worker's deque.
+    void submit(std::function<void()> task);
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void run(int index);
+    bool take(int index, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::atomic<int> m_pending;
+    std::atomic<unsigned> m_nextQueue;
+    std::atomic<bool> m_stopping;
+};
+
+// Lock-free multi-producer single-consumer queue (Vyukov's intrusive list).
+// Analysis jobs push results from any thread; only the render thread pops.
+template <typename T>
+class ResultQueue
+{
+public:
+    ResultQueue() : m_head(new Node), m_tail(m_head.load()) {}
+
+    ~ResultQueue()
+    {
+        T value;
+        while (pop(value))
+            ;
+        delete m_tail;
+    }
+
+    ResultQueue(const ResultQueue&) = delete;
+    ResultQueue& operator=(const ResultQueue&) = delete;
+
+    void push(T value)
+    {
+        Node* node = new Node;
+        node->value = std::move(value);
+        Node* previous = m_head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // Consumer side only
+    bool pop(T& value)
+    {
+        Node* tail = m_tail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr)
+            return false;
+        value = std::move(next->value);
+        m_tail = next;
+        delete tail;
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        T value;
+        std::atomic<Node*> next{nullptr};
+    };
+
+    std::atomic<Node*> m_head;
+    Node* m_tail;
+};
@@ -0,0 +1,265 @@
+#include "session.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "exporter.hpp"
+
+using namespace std;
+
+namespace
+{
+    const char sessionMagic[4] = {'I', 'S', 'E', 'S'};
+    const uint32_t sessionVersion = 1;
+
+    // Section order in the table; a later version may only add to the end
+    enum Section
+    {
+        Vertices,
+        Colours,
+        Edges,
+        EdgeKinds,
+        Multiplicities,
+        MultiplicityIndex,
+        CurvePoints,
+        UndoEdgeCounts,
+        UndoEdgeKinds,
+        UndoMultiplicityIndex,
+        Panel1,
+        Panel2,
+        Fingerprint,
+        UnionParents,
+        UnionRanks,
+        UnionParities,
+        SectionCount
+    };
+
+    const uint32_t completeFlag = 1;
+
+    struct SectionEntry
+    {
+        uint64_t offset; // from the start of the file, a multiple of 8
+        uint64_t size;   // in bytes, without the padding
+    };
+
+    // Written as it is laid out in memory, which is the file layout on a
+    // little-endian machine; no field needs padding
+    struct FileHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t seed;
+        uint32_t numVertices;
+        uint32_t numEdges;
+        uint32_t flags;
+        uint32_t layoutMode2;
+        float vertexRadius;
+        uint32_t oddCycleEdges;
+        uint32_t reserved; // zero, keeps the 64-bit fields aligned
+        int64_t drawingCrossings;
+        int64_t crossings1;
+        int64_t crossings2;
+        SectionEntry sections[SectionCount];
+    };
+    static_assert(sizeof(FileHeader) == 64 + 16 * SectionCount, "session header must not be padded");
+    static_assert(sizeof(sf::Vector2f) == 8 && sizeof(EdgeKind) == 1, "session arrays are stored as they are in memory");
+
+    // The format is little-endian and arrays are used in place, so a
+    // big-endian machine could neither write nor read it as it stands
+    bool littleEndian()
+    {
+        uint16_t probe = 1;
+        unsigned char first;
+        memcpy(&first, &probe, 1);
+        return first == 1;
+    }
+
+    uint64_t paddedSize(uint64_t size)
+    {
+        return (size + 7) & ~(uint64_t)7;
+    }
+
+    template <typename T>
+    ArrayView<T> sectionView(const char* data, const SectionEntry& entry)
+    {
+        return ArrayView<T>((const T*)(data + entry.offset), (size_t)(entry.size / sizeof(T)));
+    }
+
+    template <typename T>
+    bool allBelow(const ArrayView<T>& values, uint64_t limit)
+    {
+        for (const T& value : values)
+        {
+            if ((uint64_t)value >= limit)
+                return false;
+        }
+        return true;
+    }
+}
+
+bool saveSession(const string& path, const Session& session)
+{
+    if (!littleEndian() || session.numVertices > sessionSizeLimit || session.numEdges > sessionSizeLimit)
+        return false;
+
+    struct Part
+    {
+        const void* data;
+        uint64_t size;
+    };
+    const Part parts[SectionCount] = {
+        {session.vertices.data, session.vertices.size * sizeof(sf::Vector2f)},
+        {session.colours.data, session.colours.size * sizeof(int32_t)},
+        {session.edges.data, session.edges.size * sizeof(uint32_t)},
+        {session.edgeKinds.data, session.edgeKinds.size * sizeof(EdgeKind)},
+        {session.multiplicities.data, session.multiplicities.size * sizeof(uint32_t)},
+        {session.multiplicityIndex.data, session.multiplicityIndex.size * sizeof(uint32_t)},
+        {session.curvePoints.data, session.curvePoints.size * sizeof(sf::Vector2f)},
+        {session.undoEdgeCounts.data, session.undoEdgeCounts.size * sizeof(uint32_t)},
+        {session.undoEdgeKinds.data, session.undoEdgeKinds.size * sizeof(EdgeKind)},
+        {session.undoMultiplicityIndex.data, session.undoMultiplicityIndex.size * sizeof(uint32_t)},
+        {session.panel1.data, session.panel1.size * sizeof(sf::Vector2f)},
+        {session.panel2.data, session.panel2.size * sizeof(sf::Vector2f)},
+        {session.fingerprint.data, session.fingerprint.size},
+        {session.unionParents.data, session.unionParents.size * sizeof(int32_t)},
+        {session.unionRanks.data, session.unionRanks.size * sizeof(int32_t)},
+        {session.unionParities.data, session.unionParities.size}
+    };
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, sessionMagic, 4);
+    header.version = sessionVersion;
+    header.seed = session.seed;
+    header.numVertices = (uint32_t)session.numVertices;
+    header.numEdges = (uint32_t)session.numEdges;
+    header.flags = session.complete ? completeFlag : 0;
+    header.layoutMode2 = (uint32_t)session.layoutMode2;
+    header.vertexRadius = session.vertexRadius;
+    header.oddCycleEdges = (uint32_t)session.oddCycleEdges;
+    header.drawingCrossings = session.drawingCrossings;
+    header.crossings1 = session.crossings1;
+    header.crossings2 = session.crossings2;
+    uint64_t offset = paddedSize(sizeof(FileHeader));
+    for (int i = 0; i < SectionCount; i++)
+    {
+        header.sections[i] = SectionEntry{offset, parts[i].size};
+        offset += paddedSize(parts[i].size);
+    }
+
+    BufferedWriter out(path);
+    if (!out.isOpen())
+        return false;
+    out.write((const char*)&header, sizeof(header));
+    out.fill(0, paddedSize(sizeof(header)) - sizeof(header));
+    for (const Part& part : parts)
+    {
+        if (part.size > 0)
+            out.write((const char*)part.data, (size_t)part.size);
+        out.fill(0, (size_t)(paddedSize(part.size) - part.size));
+    }
+    return out.close();
+}
+
+bool SessionFile::open(const string& path, string& error)
+{
+    m_session = Session();
+    m_file = make_unique<MappedFile>(path);
+    if (!m_file->isOpen())
+    {
+        error = "Could not open session " + path;
+        return false;
+    }
+    if (!littleEndian())
+    {
+        error = "Session files can only be read on a little-endian machine";
+        return false;
+    }
+
+    FileHeader header;
+    if (m_file->size() < sizeof(header))
+    {
+        error = path + " is not a session file";
+        return false;
+    }
+    memcpy(&header, m_file->data(), sizeof(header));
+    if (memcmp(header.magic, sessionMagic, 4) != 0)
+    {
+        error = path + " is not a session file";
+        return false;
+    }
+    if (header.version != sessionVersion)
+    {
+        error = path + " is a version " + to_string(header.version) + " session; this build reads version " + to_string(sessionVersion);
+        return false;
+    }
+
+    // Sections must be aligned, inside the file and whole numbers of elements
+    const size_t elementSizes[SectionCount] = {sizeof(sf::Vector2f), sizeof(int32_t), sizeof(uint32_t), sizeof(EdgeKind), sizeof(uint32_t),
+                                               sizeof(uint32_t), sizeof(sf::Vector2f), sizeof(uint32_t), sizeof(EdgeKind), sizeof(uint32_t),
+                                               sizeof(sf::Vector2f), sizeof(sf::Vector2f), 1, sizeof(int32_t), sizeof(int32_t), 1};
+    for (int i = 0; i < SectionCount; i++)
+    {
+        const SectionEntry& entry = header.sections[i];
+        if (entry.offset % 8 != 0 || entry.offset > m_file->size() || entry.size > m_file->size() - entry.offset ||
+            entry.size % elementSizes[i] != 0)
+        {
+            error = path + " is damaged: section " + to_string(i) + " is out of bounds";
+            return false;
+        }
+    }
+
+    Session& session = m_session;
+    const char* data = m_file->data();
+    session.seed = header.seed;
+    session.numVertices = (int)header.numVertices;
+    session.numEdges = (int)header.numEdges;
+    session.complete = (header.flags & completeFlag) != 0;
+    session.layoutMode2 = (int)header.layoutMode2;
+    session.vertexRadius = header.vertexRadius;
+    session.oddCycleEdges = (int)header.oddCycleEdges;
+    session.drawingCrossings = header.drawingCrossings;
+    session.crossings1 = header.crossings1;
+    session.crossings2 = header.crossings2;
+    session.vertices = sectionView<sf::Vector2f>(data, header.sections[Vertices]);
+    session.colours = sectionView<int32_t>(data, header.sections[Colours]);
+    session.edges = sectionView<uint32_t>(data, header.sections[Edges]);
+    session.edgeKinds = sectionView<EdgeKind>(data, header.sections[EdgeKinds]);
+    session.multiplicities = sectionView<uint32_t>(data, header.sections[Multiplicities]);
+    session.multiplicityIndex = sectionView<uint32_t>(data, header.sections[MultiplicityIndex]);
+    session.curvePoints = sectionView<sf::Vector2f>(data, header.sections[CurvePoints]);
+    session.undoEdgeCounts = sectionView<uint32_t>(data, header.sections[UndoEdgeCounts]);
+    session.undoEdgeKinds = sectionView<EdgeKind>(data, header.sections[UndoEdgeKinds]);
+    session.undoMultiplicityIndex = sectionView<uint32_t>(data, header.sections[UndoMultiplicityIndex]);
+    session.panel1 = sectionView<sf::Vector2f>(data, header.sections[Panel1]);
+    session.panel2 = sectionView<sf::Vector2f>(data, header.sections[Panel2]);
+    session.fingerprint = sectionView<char>(data, header.sections[Fingerprint]);
+    session.unionParents = sectionView<int32_t>(data, header.sections[UnionParents]);
+    session.unionRanks = sectionView<int32_t>(data, header.sections[UnionRanks]);
+    session.unionParities = sectionView<char>(data, header.sections[UnionParities]);
+
+    // The counts have to agree with each other, and every index has to point
+    // at something, so the game can use the arrays without checking again.
+    // The connectivity forest is checked as it is put back.
+    size_t n = header.numVertices, m = header.numEdges;
+    size_t placed = session.vertices.size, drawn = session.edges.size / 2;
+    size_t depth = session.undoEdgeCounts.size;
+    bool consistent = header.numVertices <= (uint32_t)sessionSizeLimit && header.numEdges <= (uint32_t)sessionSizeLimit &&
+                      placed <= n && session.colours.size == n && session.edges.size % 2 == 0 && drawn <= m &&
+                      session.edgeKinds.size == m && session.multiplicities.size == m && session.multiplicityIndex.size == m &&
+                      (session.panel1.size == 0 || session.panel1.size == n) && session.panel2.size == session.panel1.size &&
+                      (m == 0 ? session.undoEdgeKinds.size == 0 && session.undoMultiplicityIndex.size == 0
+                              : session.undoEdgeKinds.size % m == 0 && session.undoMultiplicityIndex.size % m == 0 &&
+                                session.undoEdgeKinds.size / m <= depth && session.undoMultiplicityIndex.size / m <= depth) &&
+                      depth <= drawn && (!session.complete || (placed == n && drawn == m)) &&
+                      session.unionRanks.size == session.unionParents.size && session.unionParities.size == session.unionParents.size &&
+                      (session.unionParents.size == 0 || session.unionParents.size == n) && header.oddCycleEdges <= header.numEdges;
+    consistent = consistent && allBelow(session.edges, placed) && allBelow(session.colours, (uint64_t)INT32_MAX) && allBelow(session.multiplicityIndex, max<size_t>(m, 1)) &&
+                 allBelow(session.undoMultiplicityIndex, max<size_t>(m, 1)) && allBelow(session.undoEdgeCounts, drawn);
+    if (!consistent)
+    {
+        error = path + " is damaged: its arrays do not fit together";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mappedfile.hpp"
+
+// Session file written by Ctrl+S unless --session names another
+const char* const defaultSessionPath = "saved.session";
+
+// Largest vertex or edge count a session may hold. The game sizes its arrays
+// from the header alone, so larger counts are refused rather than allocated.
+const int sessionSizeLimit = 1 << 20;
+
+// Kind of each edge slot, as the game keeps it in isLoopOrLine. Curved
+// repeats of an edge leave their slot as it was.
+enum class EdgeKind : uint8_t
+{
+    None,
+    Line,
+    Loop
+};
+
+// Read-only array, either in memory or in place in a mapped session file
+template <typename T>
+struct ArrayView
+{
+    const T* data = nullptr;
+    size_t size = 0;
+
+    ArrayView() = default;
+    ArrayView(const T* data, size_t size) : data(data), size(size) {}
+    ArrayView(const std::vector<T>& values) : data(values.data()), size(values.size()) {}
+
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
+    const T& operator[](size_t i) const { return data[i]; }
+};
+
+// Everything a game session is restored from. The arrays are flat so they
+// are written out as they are and used straight from the mapped file.
+struct Session
+{
+    unsigned seed = 0;
+    int numVertices = 0; // vertices and edges the puzzle asks for
+    int numEdges = 0;
+    bool complete = false;
+    int layoutMode2 = 0;
+    float vertexRadius = 10.f;
+    long long drawingCrossings = 0;
+    long long crossings1 = 0;
+    long long crossings2 = 0;
+    int oddCycleEdges = 0;
+
+    ArrayView<sf::Vector2f> vertices;           // corners of the placed vertices
+    ArrayView<int32_t> colours;                 // colour class of every vertex, numVertices long
+    ArrayView<uint32_t> edges;                  // start and end vertex of every edge, in drawing order
+    ArrayView<EdgeKind> edgeKinds;              // numEdges long, like the multiplicity arrays
+    ArrayView<uint32_t> multiplicities;         // edges counted against each slot (updatingDegree)
+    ArrayView<uint32_t> multiplicityIndex;      // slot each edge is counted against (degreeIndex)
+    ArrayView<sf::Vector2f> curvePoints;        // the strip the curved repeats are drawn with
+    ArrayView<uint32_t> undoEdgeCounts;         // undo stack, oldest first: the edge count before each edge
+    ArrayView<EdgeKind> undoEdgeKinds;          // saved edgeKinds arrays, oldest first, numEdges each
+    ArrayView<uint32_t> undoMultiplicityIndex;  // saved multiplicityIndex arrays, oldest first, numEdges each
+    ArrayView<sf::Vector2f> panel1;             // corners of the generated panels' vertices, numVertices
+    ArrayView<sf::Vector2f> panel2;             // long or empty when the panels are skipped
+    ArrayView<char> fingerprint;                // spectral fingerprint shown under the drawing
+    ArrayView<int32_t> unionParents;            // the connectivity forest, numVertices long each or
+    ArrayView<int32_t> unionRanks;              // empty, put back as it is when there is no undo
+    ArrayView<char> unionParities;              // history that needs the edges replayed
+};
+
+// Write a session as a little-endian file: a fixed header with the scalar
+// fields and a table of sections, then each array padded to 8 bytes so it
+// stays aligned when mapped. Returns false if the file could not be written
+// or the counts are above sessionSizeLimit.
+bool saveSession(const std::string& path, const Session& session);
+
+// A session file mapped into memory. Opening checks the header, that every
+// section lies inside the file with the size the counts call for, and that
+// every index is in range; the arrays are then read in place, never copied.
+class SessionFile
+{
+public:
+    // False with error set if the file is missing, damaged or of another version
+    bool open(const std::string& path, std::string& error);
+
+    const Session& session() const { return m_session; }
+
+private:
+    std::unique_ptr<MappedFile> m_file;
+    Session m_session;
+};
@@ -0,0 +1,348 @@
+#include "spectrum.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+#include "parallel.hpp"
+#include "random.hpp"
+
+using namespace std;
+
+namespace
+{
+    // Rows per parallel chunk in the Householder steps
+    const int rowGrain = 64;
+
+    // Largest Krylov basis Lanczos keeps, in doubles
+    const size_t lanczosMemoryLimit = 20000000;
+
+    double dot(const double* a, const double* b, int n)
+    {
+        double sum = 0.0;
+        for (int i = 0; i < n; i++)
+            sum += a[i] * b[i];
+        return sum;
+    }
+
+    // y -= factor * x
+    void subtractScaled(double* y, const double* x, double factor, int n)
+    {
+        for (int i = 0; i < n; i++)
+            y[i] -= factor * x[i];
+    }
+
+    // Sparse product y = M x for the adjacency or Laplacian matrix
+    void multiply(const Graph& graph, SpectrumMatrix which, const double* x, double* y)
+    {
+        parallelFor(graph.numVertices, [&](int begin, int end, int)
+        {
+            for (int v = begin; v < end; v++)
+            {
+                double sum = 0.0;
+                for (const int* it = graph.neighboursBegin(v); it != graph.neighboursEnd(v); ++it)
+                    sum += x[*it];
+                y[v] = which == SpectrumMatrix::Adjacency ? sum : graph.degree(v) * x[v] - sum;
+            }
+        });
+    }
+}
+
+bool tridiagonalEigenvalues(vector<double>& d, vector<double> e)
+{
+    int n = (int)d.size();
+    e.resize(n, 0.0);
+    if (n > 0)
+        e[n - 1] = 0.0;
+
+    // Implicit QL with Wilkinson shifts, deflating from the top
+    const double epsilon = numeric_limits<double>::epsilon();
+    bool converged = true;
+    for (int l = 0; l < n; l++)
+    {
+        int iterations = 0;
+        int m;
+        do
+        {
+            for (m = l; m < n - 1; m++)
+            {
+                double scale = fabs(d[m]) + fabs(d[m + 1]);
+                if (fabs(e[m]) <= epsilon * scale)
+                    break;
+            }
+            if (m == l)
+                break;
+            if (iterations++ == 60)
+            {
+                converged = false;
+                break;
+            }
+
+            double g = (d[l + 1] - d[l]) / (2.0 * e[l]);
+            double r = hypot(g, 1.0);
+            g = d[m] - d[l] + e[l] / (g + copysign(r, g));
+            double s = 1.0, c = 1.0, p = 0.0;
+            int i;
+            for (i = m - 1; i >= l; i--)
+            {
+                double f = s * e[i];
+                double b = c * e[i];
+                r = hypot(f, g);
+                e[i + 1] = r;
+                if (r == 0.0)
+                {
+                    // Split off a block and start this one again
+                    d[i + 1] -= p;
+                    e[m] = 0.0;
+                    break;
+                }
+                s = f / r;
+                c = g / r;
+                g = d[i + 1] - p;
+                r = (d[i] - g) * s + 2.0 * c * b;
+                p = s * r;
+                d[i + 1] = g + p;
+                g = c * r - b;
+            }
+            if (r == 0.0 && i >= l)
+                continue;
+            d[l] -= p;
+            e[l] = g;
+            e[m] = 0.0;
+        } while (m != l);
+    }
+
+    sort(d.begin(), d.end());
+    return converged;
+}
+
+bool symmetricEigenvalues(vector<double> a, int n, vector<double>& values)
+{
+    vector<double> diagonal(n), offDiagonal(n, 0.0);
+    vector<double> v(n), p(n);
+
+    for (int k = 0; k + 2 < n; k++)
+    {
+        // Householder vector v zeroing column k below the subdiagonal
+        int first = k + 1;
+        int size = n - first;
+        double norm = 0.0;
+        for (int i = first; i < n; i++)
+            norm += a[(size_t)i * n + k] * a[(size_t)i * n + k];
+        norm = sqrt(norm);
+
+        diagonal[k] = a[(size_t)k * n + k];
+        double x0 = a[(size_t)first * n + k];
+        double alpha = x0 > 0.0 ? -norm : norm;
+        offDiagonal[k] = alpha;
+
+        double vNorm = 0.0;
+        for (int i = first; i < n; i++)
+        {
+            v[i] = a[(size_t)i * n + k] - (i == first ? alpha : 0.0);
+            vNorm += v[i] * v[i];
+        }
+        if (vNorm == 0.0)
+        {
+            offDiagonal[k] = x0;
+            continue;
+        }
+        vNorm = 1.0 / sqrt(vNorm);
+        for (int i = first; i < n; i++)
+            v[i] *= vNorm;
+
+        // p = A v on the trailing block, then w = p - (v.p) v
+        const double* vTail = v.data() + first;
+        parallelFor(size, [&](int begin, int end, int)
+        {
+            for (int i = first + begin; i < first + end; i++)
+                p[i] = dot(&a[(size_t)i * n + first], vTail, size);
+        }, rowGrain);
+        double c = dot(vTail, p.data() + first, size);
+        for (int i = first; i < n; i++)
+            p[i] -= c * v[i];
+
+        // A -= 2 (v w^T + w v^T), row by row
+        const double* wTail = p.data() + first;
+        parallelFor(size, [&](int begin, int end, int)
+        {
+            for (int i = first + begin; i < first + end; i++)
+            {
+                double* row = &a[(size_t)i * n + first];
+                double vi = 2.0 * v[i];
+                double wi = 2.0 * p[i];
+                for (int j = 0; j < size; j++)
+                    row[j] -= vi * wTail[j] + wi * vTail[j];
+            }
+        }, rowGrain);
+    }
+
+    if (n >= 2)
+    {
+        diagonal[n - 2] = a[(size_t)(n - 2) * n + n - 2];
+        offDiagonal[n - 2] = a[(size_t)(n - 1) * n + n - 2];
+    }
+    if (n >= 1)
+        diagonal[n - 1] = a[(size_t)(n - 1) * n + n - 1];
+    values = move(diagonal);
+    return tridiagonalEigenvalues(values, move(offDiagonal));
+}
+
+bool topEigenvalues(const Graph& graph, SpectrumMatrix which, int count, vector<double>& values, unsigned seed)
+{
+    values.clear();
+    int n = graph.numVertices;
+    if (n == 0 || count <= 0)
+        return true;
+
+    // One start vector per wanted value: a single Krylov sequence only ever
+    // sees one direction of each eigenspace, so repeated eigenvalues would
+    // come back once
+    int block = min(count, n);
+    int steps = min(n, 2 * count + 20 * block);
+    steps = max(min(steps, (int)(lanczosMemoryLimit / n)), min(n, count + 5));
+    block = min(block, steps);
+    vector<double> basis((size_t)steps * n);
+    vector<double> projected((size_t)steps * steps, 0.0);
+    vector<double> w(n);
+    int size = 0;
+
+    // Orthogonalise w against the basis twice and append it unless nothing
+    // new is left of it
+    auto append = [&](double scale)
+    {
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (int i = 0; i < size; i++)
+            {
+                const double* qi = basis.data() + (size_t)i * n;
+                subtractScaled(w.data(), qi, dot(qi, w.data(), n), n);
+            }
+        }
+        double norm = sqrt(dot(w.data(), w.data(), n));
+        if (norm <= 1e-10 * scale)
+            return;
+        double* q = basis.data() + (size_t)size * n;
+        for (int i = 0; i < n; i++)
+            q[i] = w[i] / norm;
+        size++;
+    };
+
+    Random rng(seed);
+    for (int b = 0; b < block; b++)
+    {
+        for (int i = 0; i < n; i++)
+            w[i] = rng.uniform(-1.0, 1.0);
+        append(sqrt(dot(w.data(), w.data(), n)));
+    }
+
+    // Basis vector j + block comes from A q_j, so the basis spans the block
+    // Krylov space. Everything is orthogonal, so the projected matrix is
+    // filled from the same products rather than kept tridiagonal.
+    for (int j = 0; j < size; j++)
+    {
+        const double* q = basis.data() + (size_t)j * n;
+        multiply(graph, which, q, w.data());
+        for (int i = 0; i <= j; i++)
+        {
+            double value = dot(basis.data() + (size_t)i * n, w.data(), n);
+            projected[(size_t)i * steps + j] = value;
+            projected[(size_t)j * steps + i] = value;
+        }
+        if (size < steps)
+            append(sqrt(dot(w.data(), w.data(), n)));
+    }
+
+    vector<double> matrix((size_t)size * size);
+    for (int i = 0; i < size; i++)
+        copy(projected.begin() + (size_t)i * steps, projected.begin() + (size_t)i * steps + size, matrix.begin() + (size_t)i * size);
+    bool converged = symmetricEigenvalues(move(matrix), size, values);
+    reverse(values.begin(), values.end());
+    if ((int)values.size() > count)
+        values.resize(count);
+    return converged;
+}
+
+Spectra graphSpectra(const vector<vector<int>>& adjacencyMatrix)
+{
+    int n = (int)adjacencyMatrix.size();
+    vector<double> adjacency((size_t)n * n), laplacian((size_t)n * n);
+    for (int i = 0; i < n; i++)
+    {
+        double degree = 0.0;
+        for (int j = 0; j < n; j++)
+        {
+            adjacency[(size_t)i * n + j] = adjacencyMatrix[i][j];
+            laplacian[(size_t)i * n + j] = -adjacencyMatrix[i][j];
+            degree += adjacencyMatrix[i][j];
+        }
+        // Rows of the Laplacian sum to zero, so loops cancel out
+        laplacian[(size_t)i * n + i] += degree;
+    }
+
+    Spectra spectra;
+    bool adjacencyConverged = symmetricEigenvalues(move(adjacency), n, spectra.adjacency);
+    bool laplacianConverged = symmetricEigenvalues(move(laplacian), n, spectra.laplacian);
+    spectra.converged = adjacencyConverged && laplacianConverged;
+    return spectra;
+}
+
+bool cospectral(const Spectra& a, const Spectra& b)
+{
+    if (!a.converged || !b.converged)
+        return true;
+
+    auto same = [](const vector<double>& x, const vector<double>& y)
+    {
+        if (x.size() != y.size())
+            return false;
+        for (size_t i = 0; i < x.size(); i++)
+        {
+            if (fabs(x[i] - y[i]) > 1e-6 * max(1.0, fabs(x[i])))
+                return false;
+        }
+        return true;
+    };
+    return same(a.adjacency, b.adjacency) && same(a.laplacian, b.laplacian);
+}
+
+string spectralFingerprint(const Spectra& spectra)
+{
+    if (spectra.adjacency.empty())
+        return string();
+
+    double energy = 0.0;
+    for (double value : spectra.adjacency)
+        energy += fabs(value);
+    double connectivity = spectra.laplacian.size() > 1 ? spectra.laplacian[1] : 0.0;
+
+    char text[128];
+    snprintf(text, sizeof(text), "Spectral radius %.3f  Energy %.2f  Connectivity %.3f%s", spectra.adjacency.back(), energy,
+             max(connectivity, 0.0), spectra.converged ? "" : "  (approximate)");
+    return text;
+}
+
+Spectra SpectrumCache::get(const vector<vector<int>>& adjacencyMatrix)
+{
+    uint64_t key = mixSeed(adjacencyMatrix.size());
+    for (const auto& row : adjacencyMatrix)
+    {
+        for (int value : row)
+            key = mixSeed(key, (uint64_t)value);
+    }
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_valid && m_key == key && m_matrix == adjacencyMatrix)
+            return m_spectra;
+    }
+
+    Spectra spectra = graphSpectra(adjacencyMatrix);
+    lock_guard<mutex> lock(m_mutex);
+    m_valid = true;
+    m_key = key;
+    m_matrix = adjacencyMatrix;
+    m_spectra = spectra;
+    return spectra;
+}
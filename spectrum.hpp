@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "graph.hpp"
+
+// Eigenvalues of a dense symmetric n x n matrix stored row by row, in
+// ascending order. Householder reduction to tridiagonal form, then implicit
+// QL. The O(n^3) reduction is a matrix-vector product and a rank-2 update
+// per column, both over contiguous rows split across the worker threads so
+// the compiler can vectorise the inner loops. False if QL did not converge.
+bool symmetricEigenvalues(std::vector<double> matrix, int n, std::vector<double>& values);
+
+// Eigenvalues of the symmetric tridiagonal matrix with the given diagonal and
+// offDiagonal[i] joining rows i and i + 1, left in diagonal in ascending
+// order. False if some eigenvalue was still moving after 60 QL sweeps; the
+// values are then only approximate.
+bool tridiagonalEigenvalues(std::vector<double>& diagonal, std::vector<double> offDiagonal);
+
+enum class SpectrumMatrix
+{
+    Adjacency,
+    Laplacian // degree matrix minus adjacency
+};
+
+// Largest count eigenvalues of a sparse graph's adjacency or Laplacian matrix,
+// in descending order. Block Lanczos from count random start vectors with
+// full reorthogonalisation, so an eigenvalue repeated up to count times is
+// returned that many times. The Krylov basis is capped so very large graphs
+// stay within a few hundred megabytes. False if the projected problem did
+// not converge.
+bool topEigenvalues(const Graph& graph, SpectrumMatrix which, int count, std::vector<double>& values, unsigned seed = 1);
+
+// Adjacency and Laplacian spectra, both ascending
+struct Spectra
+{
+    std::vector<double> adjacency;
+    std::vector<double> laplacian;
+    bool converged = true;
+};
+
+// Spectra of the matrix filled in when the drawing completes; repeated edges
+// count with multiplicity and loops sit on the diagonal
+Spectra graphSpectra(const std::vector<std::vector<int>>& adjacencyMatrix);
+
+// Whether two graphs have the same spectra to rounding. Graphs that are not
+// cospectral cannot be isomorphic; spectra that did not converge never rule
+// a pair out.
+bool cospectral(const Spectra& a, const Spectra& b);
+
+// One line summary shown to players: spectral radius, graph energy and
+// algebraic connectivity, marked approximate if the solver did not converge
+std::string spectralFingerprint(const Spectra& spectra);
+
+// Spectra of the last graph asked for, reused until the matrix changes.
+// Safe to call from several analysis jobs at once.
+class SpectrumCache
+{
+public:
+    Spectra get(const std::vector<std::vector<int>>& adjacencyMatrix);
+
+private:
+    std::mutex m_mutex;
+    bool m_valid = false;
+    std::uint64_t m_key = 0;
+    std::vector<std::vector<int>> m_matrix;
+    Spectra m_spectra;
+};
@@ -0,0 +1,745 @@
+#include "subgraph.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <queue>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "bits.hpp"
+#include "generators.hpp"
+#include "importer.hpp"
+#include "logger.hpp"
+#include "random.hpp"
+
+using namespace std;
+
+namespace
+{
+    // Arc consistency passes over the pattern edges; later passes rarely
+    // remove anything once the first few have
+    const int maxConsistencyPasses = 4;
+
+    // Host adjacency entries the arc consistency passes may look at in all
+    const long long consistencyBudget = 100000000;
+
+    // Search nodes between looks at the cancel token
+    const long long nodesPerCancelCheck = 1024;
+
+    // Cap on the number of matches one found match can stand for
+    const long long maxSymmetry = 1LL << 62;
+
+    // Neighbour degrees of every vertex, largest first
+    vector<vector<int>> sortedNeighbourDegrees(const Graph& graph)
+    {
+        vector<vector<int>> degrees(graph.numVertices);
+        for (int v = 0; v < graph.numVertices; v++)
+        {
+            degrees[v].reserve(graph.degree(v));
+            graph.forEachNeighbour(v, [&](int w) { degrees[v].push_back(graph.degree(w)); });
+            sort(degrees[v].begin(), degrees[v].end(), greater<int>());
+        }
+        return degrees;
+    }
+
+    int domainSize(const uint64_t* words, int count)
+    {
+        int size = 0;
+        for (int i = 0; i < count; i++)
+            size += popcount64(words[i]);
+        return size;
+    }
+
+    string mappingText(const vector<int>& mapping)
+    {
+        string text;
+        for (int u = 0; u < (int)mapping.size(); u++)
+            text += (u == 0 ? "" : " ") + to_string(u + 1) + "->" + to_string(mapping[u] + 1);
+        return text;
+    }
+}
+
+SubgraphMatcher::SubgraphMatcher(const Graph& pattern, const Graph& host, bool induced) : m_pattern(pattern), m_host(host), m_induced(induced)
+{
+}
+
+void SubgraphMatcher::prepare()
+{
+    if (m_prepared)
+        return;
+    m_prepared = true;
+
+    m_feasible = m_pattern.numVertices <= m_host.numVertices && m_pattern.numEdges() <= m_host.numEdges() && filterDomains();
+    if (m_feasible)
+        chooseOrder();
+}
+
+bool SubgraphMatcher::filterDomains()
+{
+    int patternSize = m_pattern.numVertices;
+    int hostSize = m_host.numVertices;
+    m_words = (hostSize + 63) / 64;
+    m_domains.assign((size_t)patternSize * m_words, 0);
+
+    // A host vertex can stand in for u only if it has at least u's degree and
+    // its neighbours, largest degree first, each have at least the degree of
+    // u's neighbour in the same place
+    vector<vector<int>> patternDegrees = sortedNeighbourDegrees(m_pattern);
+    vector<vector<int>> hostDegrees = sortedNeighbourDegrees(m_host);
+    for (int u = 0; u < patternSize; u++)
+    {
+        uint64_t* domain = &m_domains[(size_t)u * m_words];
+        const vector<int>& need = patternDegrees[u];
+        for (int v = 0; v < hostSize; v++)
+        {
+            const vector<int>& have = hostDegrees[v];
+            if (have.size() < need.size())
+                continue;
+            bool dominates = true;
+            for (size_t i = 0; i < need.size() && dominates; i++)
+                dominates = have[i] >= need[i];
+            if (dominates)
+                domain[v >> 6] |= bitOf(v & 63);
+        }
+        if (domainSize(domain, m_words) == 0)
+            return false;
+    }
+
+    // Arc consistency: along every pattern edge u-w, u can only go to a host
+    // neighbour of somewhere w can go. Passes stop early once they have
+    // looked at enough host edges; whatever was narrowed by then still holds.
+    vector<uint64_t> reach(m_words);
+    long long work = 0;
+    for (int pass = 0; pass < maxConsistencyPasses && work < consistencyBudget; pass++)
+    {
+        bool changed = false;
+        for (int w = 0; w < patternSize && work < consistencyBudget; w++)
+        {
+            if (m_pattern.degree(w) == 0)
+                continue;
+            const uint64_t* domain = &m_domains[(size_t)w * m_words];
+            fill(reach.begin(), reach.end(), 0);
+            for (int i = 0; i < m_words; i++)
+            {
+                for (uint64_t bits = domain[i]; bits != 0; bits &= bits - 1)
+                {
+                    int v = i * 64 + lowestBit(bits);
+                    work += m_host.degree(v);
+                    m_host.forEachNeighbour(v, [&](int x) { reach[x >> 6] |= bitOf(x & 63); });
+                }
+            }
+
+            for (const int* it = m_pattern.neighboursBegin(w); it != m_pattern.neighboursEnd(w); ++it)
+            {
+                uint64_t* narrowed = &m_domains[(size_t)*it * m_words];
+                bool empty = true;
+                for (int i = 0; i < m_words; i++)
+                {
+                    uint64_t bits = narrowed[i] & reach[i];
+                    changed |= bits != narrowed[i];
+                    narrowed[i] = bits;
+                    empty &= bits == 0;
+                }
+                if (empty)
+                    return false;
+            }
+        }
+        if (!changed)
+            break;
+    }
+    return true;
+}
+
+void SubgraphMatcher::chooseOrder()
+{
+    int patternSize = m_pattern.numVertices;
+    vector<int> sizes(patternSize);
+    for (int u = 0; u < patternSize; u++)
+        sizes[u] = domainSize(&m_domains[(size_t)u * m_words], m_words);
+
+    // VF2++ order: start each component at its rarest vertex, then always
+    // take the vertex with the most neighbours already ordered, then the
+    // highest degree, then the one next to the most recently ordered vertex,
+    // then the fewest candidates. Unlike a strict breadth first order this
+    // closes a cycle as soon as it can and fills in around a vertex right
+    // after placing it, so a dead end shows up before unrelated vertices are
+    // placed and it is not retried under every arrangement of those.
+    vector<int> roots(patternSize);
+    for (int u = 0; u < patternSize; u++)
+        roots[u] = u;
+    sort(roots.begin(), roots.end(), [&](int a, int b) {
+        if (sizes[a] != sizes[b])
+            return sizes[a] < sizes[b];
+        return m_pattern.degree(a) > m_pattern.degree(b);
+    });
+
+    // Queue entries are (ordered neighbours, degree, latest ordered
+    // neighbour, -candidates, vertex); an entry goes stale when the vertex
+    // gains another ordered neighbour
+    typedef tuple<int, int, int, int, int> Entry;
+    priority_queue<Entry> queue;
+    m_position.assign(patternSize, -1);
+    vector<int> orderedNeighbours(patternSize, 0);
+    m_order.clear();
+    m_order.reserve(patternSize);
+    size_t nextRoot = 0;
+    while ((int)m_order.size() < patternSize)
+    {
+        if (queue.empty())
+        {
+            while (m_position[roots[nextRoot]] != -1)
+                nextRoot++;
+            int root = roots[nextRoot];
+            queue.push(Entry(0, m_pattern.degree(root), 0, -sizes[root], root));
+        }
+
+        Entry entry = queue.top();
+        queue.pop();
+        int u = get<4>(entry);
+        if (m_position[u] != -1 || get<0>(entry) != orderedNeighbours[u])
+            continue;
+
+        m_position[u] = (int)m_order.size();
+        m_order.push_back(u);
+        m_pattern.forEachNeighbour(u, [&](int w) {
+            if (m_position[w] == -1)
+                queue.push(Entry(++orderedNeighbours[w], m_pattern.degree(w), m_position[u], -sizes[w], w));
+        });
+    }
+
+    // Twins, vertices with the same neighbours (adjacent to each other or
+    // not), can swap images in any match. Each must go to a higher host
+    // vertex than the twin ordered before it, and every match found stands
+    // for the factorial of each class size.
+    map<vector<int>, vector<int>> openClasses, closedClasses;
+    for (int u = 0; u < patternSize; u++)
+        openClasses[vector<int>(m_pattern.neighboursBegin(u), m_pattern.neighboursEnd(u))].push_back(u);
+    for (int u = 0; u < patternSize; u++)
+    {
+        vector<int> closed(m_pattern.neighboursBegin(u), m_pattern.neighboursEnd(u));
+        closed.insert(lower_bound(closed.begin(), closed.end(), u), u);
+        closedClasses[closed].push_back(u);
+    }
+    m_twinBefore.assign(patternSize, -1);
+    m_symmetry = 1;
+    for (auto* classes : {&openClasses, &closedClasses})
+    {
+        for (auto& twins : *classes)
+        {
+            vector<int>& members = twins.second;
+            sort(members.begin(), members.end(), [&](int a, int b) { return m_position[a] < m_position[b]; });
+            // Swapping twins turns a match into a match, so each can only
+            // go where all of them can
+            uint64_t* shared = &m_domains[(size_t)members[0] * m_words];
+            for (size_t i = 1; i < members.size(); i++)
+            {
+                const uint64_t* domain = &m_domains[(size_t)members[i] * m_words];
+                for (int j = 0; j < m_words; j++)
+                    shared[j] &= domain[j];
+            }
+            for (size_t i = 1; i < members.size(); i++)
+                copy(shared, shared + m_words, &m_domains[(size_t)members[i] * m_words]);
+
+            for (size_t i = 1; i < members.size(); i++)
+            {
+                m_twinBefore[members[i]] = members[i - 1];
+                m_symmetry = m_symmetry > maxSymmetry / (long long)(i + 1) ? maxSymmetry : m_symmetry * (long long)(i + 1);
+            }
+        }
+    }
+
+    // Candidates for u come from the image of its earliest ordered
+    // neighbour; the other earlier neighbours are checked edge by edge
+    m_parent.assign(patternSize, -1);
+    m_checks.assign(patternSize, vector<int>());
+    m_earlierNeighbours.assign(patternSize, 0);
+    m_laterNeighbours.assign(patternSize, 0);
+    m_laterLinks.assign(patternSize, 0);
+    for (int u = 0; u < patternSize; u++)
+    {
+        m_pattern.forEachNeighbour(u, [&](int w) {
+            if (m_position[w] > m_position[u])
+            {
+                m_laterNeighbours[u]++;
+                return;
+            }
+            m_earlierNeighbours[u]++;
+            if (m_parent[u] == -1 || m_position[w] < m_position[m_parent[u]])
+                m_parent[u] = w;
+        });
+        m_pattern.forEachNeighbour(u, [&](int w) {
+            if (m_position[w] < m_position[u] && w != m_parent[u])
+                m_checks[u].push_back(w);
+        });
+    }
+    m_laterDomains.assign((size_t)patternSize * m_words, 0);
+    for (int u = 0; u < patternSize; u++)
+    {
+        uint64_t* reach = &m_laterDomains[(size_t)u * m_words];
+        m_pattern.forEachNeighbour(u, [&](int w) {
+            if (m_position[w] < m_position[u])
+                return;
+            m_laterLinks[u] = max(m_laterLinks[u], m_earlierNeighbours[w]);
+            const uint64_t* domain = &m_domains[(size_t)w * m_words];
+            for (int i = 0; i < m_words; i++)
+                reach[i] |= domain[i];
+        });
+    }
+}
+
+void SubgraphMatcher::blameMapped(uint64_t* conflict, int v) const
+{
+    // Depths that placed a host neighbour of v
+    m_host.forEachNeighbour(v, [&](int x) {
+        if (m_depthOf[x] != -1)
+            blame(conflict, m_depthOf[x]);
+    });
+}
+
+bool SubgraphMatcher::enoughRoom(int u, int v, int needed, int pending, uint64_t* conflict) const
+{
+    // Neighbours of u placed after it need that many free host neighbours of
+    // v, each in the domain of one of them. For an induced match a free one
+    // also has no more placed neighbours, counting the pending placement of v
+    // itself, than the most those neighbours of u will have once placed.
+    const uint64_t* reach = &m_laterDomains[(size_t)u * m_words];
+    auto reachable = [&](int x) { return (reach[x >> 6] >> (x & 63)) & 1; };
+    auto fenced = [&](int x) { return m_induced && m_mappedNeighbours[x] + pending > m_laterLinks[u]; };
+    int free = 0;
+    for (const int* it = m_host.neighboursBegin(v); it != m_host.neighboursEnd(v) && free < needed; ++it)
+        free += m_depthOf[*it] == -1 && reachable(*it) && !fenced(*it);
+    if (free >= needed)
+        return true;
+
+    // Short of room: blame whatever took or fenced off the missing ones
+    m_host.forEachNeighbour(v, [&](int x) {
+        if (!reachable(x))
+            return;
+        if (m_depthOf[x] != -1)
+            blame(conflict, m_depthOf[x]);
+        else if (fenced(x))
+            blameMapped(conflict, x);
+    });
+    return false;
+}
+
+bool SubgraphMatcher::tryCandidate(int depth, int u, int v)
+{
+    uint64_t* conflict = conflictSet(depth);
+    if (m_depthOf[v] != -1)
+    {
+        blame(conflict, m_depthOf[v]);
+        return true;
+    }
+    if (!inDomain(u, v))
+        return true;
+    if (m_twinBefore[u] != -1 && v < m_mapping[m_twinBefore[u]])
+    {
+        blame(conflict, m_position[m_twinBefore[u]]);
+        return true;
+    }
+    for (int w : m_checks[u])
+    {
+        if (!m_host.adjacent(m_mapping[w], v))
+        {
+            blame(conflict, m_position[w]);
+            return true;
+        }
+    }
+    // v is already adjacent to the images of all earlier neighbours of u, so
+    // any further placed neighbour would be an edge the pattern lacks
+    if (m_induced && m_mappedNeighbours[v] != m_earlierNeighbours[u])
+    {
+        blameMapped(conflict, v);
+        return true;
+    }
+    if (m_laterNeighbours[u] > 0 && !enoughRoom(u, v, m_laterNeighbours[u], 1, conflict))
+        return true;
+
+    m_mapping[u] = v;
+    m_depthOf[v] = depth;
+    if (m_parent[u] != -1)
+        m_placedLater[m_parent[u]]++;
+    for (int w : m_checks[u])
+        m_placedLater[w]++;
+    if (m_laterNeighbours[u] > 0)
+        m_open.push_back(u);
+    if (m_induced)
+        m_host.forEachNeighbour(v, [&](int x) { m_mappedNeighbours[x]++; });
+
+    extend(depth + 1);
+
+    if (m_induced)
+        m_host.forEachNeighbour(v, [&](int x) { m_mappedNeighbours[x]--; });
+    if (m_laterNeighbours[u] > 0)
+        m_open.pop_back();
+    for (int w : m_checks[u])
+        m_placedLater[w]--;
+    if (m_parent[u] != -1)
+        m_placedLater[m_parent[u]]--;
+    m_depthOf[v] = -1;
+    m_mapping[u] = -1;
+    if (m_stopped)
+        return false;
+
+    // Conflict-directed backjumping: if the failure below never involved
+    // this depth, no other candidate here can fix it, so pass it straight up
+    const uint64_t* below = conflictSet(depth + 1);
+    if ((below[depth >> 6] >> (depth & 63)) & 1)
+    {
+        for (int i = 0; i < m_depthWords; i++)
+            conflict[i] |= below[i];
+        conflict[depth >> 6] &= ~bitOf(depth & 63);
+        return true;
+    }
+    copy(below, below + m_depthWords, conflict);
+    return false;
+}
+
+void SubgraphMatcher::extend(int depth)
+{
+    uint64_t* conflict = conflictSet(depth);
+    fill(conflict, conflict + m_depthWords, 0);
+    if (++m_nodes % nodesPerCancelCheck == 0 && m_cancel != nullptr && m_cancel->cancelled())
+    {
+        m_stopped = true;
+        return;
+    }
+
+    if (depth == m_pattern.numVertices)
+    {
+        if (m_matches == 0)
+            m_firstMatch = m_mapping;
+        m_matches = m_matches > m_limit - m_symmetry ? m_limit : m_matches + m_symmetry;
+        m_stopped = m_matches >= m_limit;
+
+        // Counting goes on: every depth above has to try its other candidates
+        fill(conflict, conflict + m_depthWords, ~(uint64_t)0);
+        return;
+    }
+
+    // Forward check: later placements may have used up or fenced off the host
+    // neighbours that the unplaced neighbours of an earlier vertex need
+    for (int w : m_open)
+    {
+        int needed = m_laterNeighbours[w] - m_placedLater[w];
+        if (needed > 0 && !enoughRoom(w, m_mapping[w], needed, 0, conflict))
+        {
+            blame(conflict, m_position[w]);
+            return;
+        }
+    }
+
+    int u = m_order[depth];
+    int parent = m_parent[u];
+    if (parent != -1)
+    {
+        // Candidates are the host neighbours of the parent's image
+        blame(conflict, m_position[parent]);
+        int image = m_mapping[parent];
+        for (const int* it = m_host.neighboursBegin(image); it != m_host.neighboursEnd(image); ++it)
+        {
+            if (!tryCandidate(depth, u, *it))
+                return;
+        }
+    }
+    else
+    {
+        // First vertex of a pattern component: anywhere in its domain
+        const uint64_t* domain = &m_domains[(size_t)u * m_words];
+        for (int i = 0; i < m_words; i++)
+        {
+            for (uint64_t bits = domain[i]; bits != 0; bits &= bits - 1)
+            {
+                if (!tryCandidate(depth, u, i * 64 + lowestBit(bits)))
+                    return;
+            }
+        }
+    }
+}
+
+long long SubgraphMatcher::search(long long limit, const CancelToken* cancel)
+{
+    prepare();
+    m_limit = limit;
+    m_matches = 0;
+    m_nodes = 0;
+    m_stopped = false;
+    m_cancel = cancel;
+    m_firstMatch.clear();
+    if (!m_feasible || limit <= 0)
+        return 0;
+
+    int patternSize = m_pattern.numVertices;
+    m_mapping.assign(patternSize, -1);
+    m_depthOf.assign(m_host.numVertices, -1);
+    m_placedLater.assign(patternSize, 0);
+    m_open.clear();
+    if (m_induced)
+        m_mappedNeighbours.assign(m_host.numVertices, 0);
+    m_depthWords = (patternSize + 63) / 64;
+    m_conflicts.assign((size_t)(patternSize + 1) * m_depthWords, 0);
+    extend(0);
+    return m_matches;
+}
+
+bool SubgraphMatcher::find(vector<int>& mapping, const CancelToken* cancel)
+{
+    if (search(1, cancel) == 0)
+        return false;
+    mapping = m_firstMatch;
+    return true;
+}
+
+long long SubgraphMatcher::count(long long limit, const CancelToken* cancel)
+{
+    return search(limit, cancel);
+}
+
+bool isSubgraphMatch(const Graph& pattern, const Graph& host, bool induced, const vector<int>& mapping)
+{
+    if ((int)mapping.size() != pattern.numVertices)
+        return false;
+    vector<int> inverse(host.numVertices, -1);
+    for (int u = 0; u < pattern.numVertices; u++)
+    {
+        int v = mapping[u];
+        if (v < 0 || v >= host.numVertices || inverse[v] != -1)
+            return false;
+        inverse[v] = u;
+    }
+
+    for (int u = 0; u < pattern.numVertices; u++)
+    {
+        for (const int* it = pattern.neighboursBegin(u); it != pattern.neighboursEnd(u); ++it)
+        {
+            if (!host.adjacent(mapping[u], mapping[*it]))
+                return false;
+        }
+    }
+    if (!induced)
+        return true;
+
+    // Every pattern edge is present, so the image is induced exactly when it
+    // spans no more host edges than the pattern has
+    long long spanned = 0;
+    for (int v : mapping)
+        host.forEachNeighbour(v, [&](int x) { spanned += inverse[x] != -1; });
+    return spanned / 2 == pattern.numEdges();
+}
+
+namespace
+{
+    // Vertices within reach of start in breadth-first order, at most size
+    vector<int> breadthFirstBall(const Graph& graph, int start, int size)
+    {
+        vector<int> ball = {start};
+        vector<char> seen(graph.numVertices, 0);
+        seen[start] = 1;
+        for (size_t i = 0; i < ball.size() && (int)ball.size() < size; i++)
+        {
+            for (const int* it = graph.neighboursBegin(ball[i]); it != graph.neighboursEnd(ball[i]) && (int)ball.size() < size; ++it)
+            {
+                if (!seen[*it])
+                {
+                    seen[*it] = 1;
+                    ball.push_back(*it);
+                }
+            }
+        }
+        return ball;
+    }
+
+    // Pattern cut out of the host around a random vertex, shuffled so the
+    // matcher cannot lean on the original numbering. Non-induced patterns
+    // also lose about a quarter of their edges.
+    Graph plantedPattern(const Graph& host, int size, bool induced, Random& rng)
+    {
+        vector<int> ball = breadthFirstBall(host, (int)rng.below((uint32_t)host.numVertices), size);
+        vector<int> label(host.numVertices, -1);
+        vector<int> shuffle = randomPermutation((int)ball.size(), rng);
+        for (size_t i = 0; i < ball.size(); i++)
+            label[ball[i]] = shuffle[i];
+
+        vector<pair<int, int>> edgeList;
+        for (int v : ball)
+        {
+            host.forEachNeighbour(v, [&](int x) {
+                if (label[x] != -1 && v < x && (induced || rng.below(4) != 0))
+                    edgeList.push_back({label[v], label[x]});
+            });
+        }
+        return buildGraph((int)ball.size(), edgeList);
+    }
+
+    Graph gridGraph(int side)
+    {
+        vector<pair<int, int>> edgeList;
+        for (int row = 0; row < side; row++)
+        {
+            for (int column = 0; column < side; column++)
+            {
+                int v = row * side + column;
+                if (column + 1 < side)
+                    edgeList.push_back({v, v + 1});
+                if (row + 1 < side)
+                    edgeList.push_back({v, v + side});
+            }
+        }
+        return buildGraph(side * side, edgeList);
+    }
+
+    Graph completeGraph(int n)
+    {
+        vector<pair<int, int>> edgeList;
+        for (int u = 0; u < n; u++)
+        {
+            for (int v = u + 1; v < n; v++)
+                edgeList.push_back({u, v});
+        }
+        return buildGraph(n, edgeList);
+    }
+
+    // One timed search; false if a match was expected but missing, or a
+    // match came back that does not check out
+    bool benchmarkSearch(const string& name, const Graph& pattern, const Graph& host, bool induced, bool expected)
+    {
+        auto started = chrono::steady_clock::now();
+        SubgraphMatcher matcher(pattern, host, induced);
+        vector<int> mapping;
+        bool found = matcher.find(mapping);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+        bool valid = !found || isSubgraphMatch(pattern, host, induced, mapping);
+        logInfo(name + ", " + to_string(pattern.numVertices) + " vertex " + (induced ? "induced" : "non-induced") + " pattern: " +
+                (found ? (valid ? "found" : "INVALID MATCH") : "not found") + " after " + to_string(matcher.nodes()) + " nodes in " +
+                to_string(seconds) + " s");
+        return valid && (found || !expected);
+    }
+
+    int runBenchmark(unsigned seed)
+    {
+        const int hostSize = 10000;
+        Random rng(seed);
+        vector<pair<string, Graph>> hosts;
+        hosts.push_back({"G(n, m) 10000/50000", buildGraph(hostSize, randomGnm(hostSize, 50000, rng))});
+        hosts.push_back({"Preferential attachment 10000/3", buildGraph(hostSize, randomPreferentialAttachment(hostSize, 3, rng))});
+        vector<pair<int, int>> regularEdges;
+        if (randomRegular(hostSize, 4, rng, regularEdges))
+            hosts.push_back({"4-regular 10000", buildGraph(hostSize, regularEdges)});
+        hosts.push_back({"Grid 100x100", gridGraph(100)});
+
+        logInfo("Subgraph benchmark, seed " + to_string(seed));
+        auto started = chrono::steady_clock::now();
+        bool passed = true;
+        Graph clique = completeGraph(5);
+        for (const auto& host : hosts)
+        {
+            for (int size : {8, 16, 32})
+            {
+                for (bool induced : {false, true})
+                    passed &= benchmarkSearch(host.first, plantedPattern(host.second, size, induced, rng), host.second, induced, true);
+            }
+            // K5 is absent from all but the unluckiest of these hosts, so
+            // this times a full refutation
+            passed &= benchmarkSearch(host.first + ", K5", clique, host.second, false, false);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        logInfo(string(passed ? "Subgraph benchmark passed" : "Subgraph benchmark FAILED") + " in " + to_string(seconds) + " s");
+        return passed ? 0 : 1;
+    }
+
+    bool loadGraph(const string& path, Graph& graph)
+    {
+        int numVertices = 0;
+        vector<pair<int, int>> edgeList;
+        string error;
+        if (!importGraph(path, numVertices, edgeList, error))
+        {
+            logError(error);
+            return false;
+        }
+        graph = buildGraph(numVertices, edgeList);
+        return true;
+    }
+}
+
+bool subgraphModeRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        string argument = argv[i];
+        if (argument == "--find-subgraph" || argument == "--subgraph-benchmark")
+            return true;
+    }
+    return false;
+}
+
+int runSubgraphMode(int argc, char* argv[])
+{
+    string patternPath, hostPath;
+    bool benchmark = false, induced = false;
+    long long limit = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        string argument = argv[i];
+        if (argument == "--find-subgraph" && i + 2 < argc)
+        {
+            patternPath = argv[++i];
+            hostPath = argv[++i];
+        }
+        else if (argument == "--subgraph-benchmark")
+            benchmark = true;
+        else if (argument == "--induced")
+            induced = true;
+        else if (argument == "--count" && i + 1 < argc)
+            limit = atoll(argv[++i]);
+    }
+    if (benchmark)
+        return runBenchmark(seedFromArguments(argc, argv));
+    if (patternPath.empty() || hostPath.empty())
+    {
+        logError("Usage: main --find-subgraph <pattern file> <host file> [--induced] [--count LIMIT] | --subgraph-benchmark [--seed S]");
+        return 1;
+    }
+
+    Graph pattern, host;
+    if (!loadGraph(patternPath, pattern) || !loadGraph(hostPath, host))
+        return 1;
+
+    auto started = chrono::steady_clock::now();
+    SubgraphMatcher matcher(pattern, host, induced);
+    string kind = induced ? "induced copies" : "copies";
+    if (limit > 0)
+    {
+        long long matches = matcher.count(limit);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        logInfo("Found " + to_string(matches) + (matches >= limit ? " or more " : " ") + kind + " of " + patternPath + " in " + hostPath + " in " +
+                to_string(seconds) + " s");
+        return 0;
+    }
+
+    vector<int> mapping;
+    bool found = matcher.find(mapping);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    if (!found)
+    {
+        logInfo("No " + kind + " of " + patternPath + " in " + hostPath + " (" + to_string(seconds) + " s)");
+        return 0;
+    }
+    logInfo("Found " + patternPath + " in " + hostPath + " in " + to_string(seconds) + " s: " + mappingText(mapping));
+    return 0;
+}
+
+string patternMatchSummary(const Graph& pattern, const Graph& host, bool induced, const CancelToken* cancel)
+{
+    SubgraphMatcher matcher(pattern, host, induced);
+    vector<int> mapping;
+    if (!matcher.find(mapping, cancel))
+        return cancel != nullptr && cancel->cancelled() ? "" : "The pattern does not occur in the graph.";
+    return string(induced ? "Induced pattern" : "Pattern") + " vertices map to " + mappingText(mapping);
+}
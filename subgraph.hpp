@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cancel.hpp"
+#include "graph.hpp"
+
+// Finds copies of a pattern graph inside a host graph, VF2++ style. A
+// non-induced match maps every pattern edge onto a host edge; an induced
+// match must also map non-edges onto non-edges. Both graphs are simple.
+//
+// Each pattern vertex gets a bitset domain of host vertices that pass the
+// degree and neighbour degree tests, narrowed by arc consistency along the
+// pattern edges. Pattern vertices are then matched starting from the rarest
+// domain and always taking the vertex most connected to those already
+// placed. A vertex with a placed neighbour only looks at the host neighbours
+// of that neighbour's image. Twin pattern vertices, which have the same
+// neighbours, are only tried in one of their interchangeable arrangements.
+class SubgraphMatcher
+{
+public:
+    SubgraphMatcher(const Graph& pattern, const Graph& host, bool induced);
+
+    // First match found, as the host vertex of each pattern vertex. False if
+    // there is none or the token was cancelled first.
+    bool find(std::vector<int>& mapping, const CancelToken* cancel = nullptr);
+
+    // Number of matches (automorphic copies counted separately), at most
+    // limit, stopping once it is reached
+    long long count(long long limit, const CancelToken* cancel = nullptr);
+
+    // Search nodes visited by the last find or count
+    long long nodes() const { return m_nodes; }
+
+private:
+    void prepare();
+    bool filterDomains();
+    void chooseOrder();
+    bool inDomain(int u, int v) const { return (m_domains[(size_t)u * m_words + (v >> 6)] >> (v & 63)) & 1; }
+    bool enoughRoom(int u, int v, int needed, int pending, std::uint64_t* conflict) const;
+    bool tryCandidate(int depth, int u, int v);
+    void extend(int depth);
+    std::uint64_t* conflictSet(int depth) { return m_conflicts.data() + (size_t)depth * m_depthWords; }
+    static void blame(std::uint64_t* conflict, int depth) { conflict[depth >> 6] |= std::uint64_t(1) << (depth & 63); }
+    void blameMapped(std::uint64_t* conflict, int v) const;
+    long long search(long long limit, const CancelToken* cancel);
+
+    const Graph& m_pattern;
+    const Graph& m_host;
+    bool m_induced;
+    bool m_prepared = false;
+    bool m_feasible = true;
+
+    int m_words = 0;
+    std::vector<std::uint64_t> m_domains; // pattern vertex by host vertex bits
+    std::vector<int> m_order;
+    std::vector<int> m_position;           // depth of each pattern vertex in m_order
+    std::vector<int> m_parent;             // earlier neighbour whose image candidates come from
+    std::vector<std::vector<int>> m_checks; // other earlier neighbours of each pattern vertex
+    std::vector<int> m_earlierNeighbours;
+    std::vector<int> m_laterNeighbours;
+    std::vector<int> m_laterLinks;          // most earlier neighbours any later neighbour has
+    std::vector<std::uint64_t> m_laterDomains; // union of the domains of the later neighbours
+    std::vector<int> m_twinBefore;          // twin that must map to a lower host vertex, or -1
+    long long m_symmetry = 1;               // matches each match found stands for
+
+    std::vector<int> m_mapping;
+    std::vector<int> m_depthOf;          // depth that placed each host vertex, or -1
+    std::vector<int> m_placedLater;      // neighbours placed after each placed pattern vertex
+    std::vector<int> m_open;             // placed pattern vertices that had neighbours still to place
+    std::vector<int> m_mappedNeighbours; // induced only: placed host neighbours of each host vertex
+    std::vector<int> m_firstMatch;
+    int m_depthWords = 0;
+    std::vector<std::uint64_t> m_conflicts; // per depth, the earlier depths its failure depends on
+    long long m_limit = 1;
+    long long m_matches = 0;
+    long long m_nodes = 0;
+    bool m_stopped = false;
+    const CancelToken* m_cancel = nullptr;
+};
+
+// Whether mapping is an (induced) subgraph match of pattern into host: one
+// host lookup per pattern edge, plus for induced matches a pass over the host
+// neighbours of the image to count the edges it spans. This is the check for
+// a player's answer.
+bool isSubgraphMatch(const Graph& pattern, const Graph& host, bool induced, const std::vector<int>& mapping);
+
+// One line for the log: where the pattern sits in the host (1-based, as
+// vertices are numbered on screen), that it does not occur, or empty if the
+// token was cancelled first
+std::string patternMatchSummary(const Graph& pattern, const Graph& host, bool induced, const CancelToken* cancel = nullptr);
+
+// Whether the command line asks for a headless subgraph run
+// (--find-subgraph or --subgraph-benchmark)
+bool subgraphModeRequested(int argc, char* argv[]);
+
+// Headless command line mode, no window is opened:
+//   --find-subgraph <pattern file> <host file> [--induced] [--count LIMIT]
+//       prints a match of the pattern in the host, or counts them
+//   --subgraph-benchmark [--seed S]
+//       times planted and absent patterns in 10000 vertex hosts, checking
+//       every match found
+// Returns the process exit code.
+int runSubgraphMode(int argc, char* argv[]);
@@ -0,0 +1,71 @@
+#include "verify.hpp"
+
+using namespace std;
+
+PartialMapping::PartialMapping(const vector<vector<int>>& source, const vector<vector<int>>& target)
+    : m_sourceMatrix(source), m_targetMatrix(target), m_source(buildGraph(source)), m_target(buildGraph(target)),
+      m_image(m_source.numVertices, -1), m_preimage(m_target.numVertices, -1), m_conflictsAt(m_source.numVertices, 0),
+      m_sourceMarks(m_source.numVertices, 0)
+{
+}
+
+bool PartialMapping::assign(int v, int w)
+{
+    if (m_image[v] != -1 || m_preimage[w] != -1)
+        return false;
+    countConflicts(v, w, 1);
+    m_image[v] = w;
+    m_preimage[w] = v;
+    m_mapped++;
+    return true;
+}
+
+void PartialMapping::unassign(int v)
+{
+    int w = m_image[v];
+    if (w == -1)
+        return;
+    m_image[v] = -1;
+    m_preimage[w] = -1;
+    m_mapped--;
+    countConflicts(v, w, -1);
+}
+
+bool PartialMapping::complete() const
+{
+    return m_mapped == m_source.numVertices && m_source.numVertices == m_target.numVertices && m_conflicts == 0;
+}
+
+// Add delta for every conflict between the pair v -> w, neither of them
+// mapped yet, and itself or the pairs already mapped. Marking the source
+// neighbourhood first tells which target edges were compared already.
+void PartialMapping::countConflicts(int v, int w, int delta)
+{
+    if (m_sourceMatrix[v][v] != m_targetMatrix[w][w])
+    {
+        m_conflictsAt[v] += delta;
+        m_conflicts += delta;
+    }
+
+    m_stamp++;
+    m_source.forEachNeighbour(v, [&](int u) { m_sourceMarks[u] = m_stamp; });
+
+    auto conflict = [&](int u)
+    {
+        m_conflictsAt[u] += delta;
+        m_conflictsAt[v] += delta;
+        m_conflicts += delta;
+    };
+
+    // Edges of the source whose images are missing or repeated another
+    // number of times in the target
+    m_source.forEachNeighbour(v, [&](int u) {
+        if (m_image[u] != -1 && m_sourceMatrix[v][u] != m_targetMatrix[w][m_image[u]])
+            conflict(u);
+    });
+    // Edges of the target with no edge of the source behind them
+    m_target.forEachNeighbour(w, [&](int x) {
+        if (m_preimage[x] != -1 && m_sourceMarks[m_preimage[x]] != m_stamp)
+            conflict(m_preimage[x]);
+    });
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "graph.hpp"
+
+// A partial vertex mapping from a source graph (the drawing) to a target
+// graph (a generated panel), built up one pair at a time. Both come as
+// adjacency matrices of edge counts with loops on the diagonal. A conflict
+// is a pair of mapped vertices, or a mapped vertex and itself, joined by a
+// different number of edges than their images. Mapping or unmapping a
+// vertex only looks at its own neighbours and its image's, so each step
+// costs O(deg) no matter how big the graphs are.
+class PartialMapping
+{
+public:
+    PartialMapping(const std::vector<std::vector<int>>& source, const std::vector<std::vector<int>>& target);
+
+    // Map source vertex v to target vertex w. False, changing nothing, if
+    // either is already mapped.
+    bool assign(int v, int w);
+
+    // Forget where source vertex v goes, if anywhere
+    void unassign(int v);
+
+    int imageOf(int v) const { return m_image[v]; }
+    int preimageOf(int w) const { return m_preimage[w]; }
+    int mappedCount() const { return m_mapped; }
+
+    // Conflicting pairs in all, and those involving source vertex v
+    int conflicts() const { return m_conflicts; }
+    int conflictsAt(int v) const { return m_conflictsAt[v]; }
+
+    // Whether the mapping so far can still grow into an isomorphism as far
+    // as the mapped vertices can tell, and whether it already is one
+    bool consistent() const { return m_conflicts == 0; }
+    bool complete() const;
+
+private:
+    void countConflicts(int v, int w, int delta);
+
+    const std::vector<std::vector<int>>& m_sourceMatrix;
+    const std::vector<std::vector<int>>& m_targetMatrix;
+    Graph m_source;                 // neighbour lists of the matrices, loops left out
+    Graph m_target;
+    std::vector<int> m_image;       // target vertex of each source vertex, or -1
+    std::vector<int> m_preimage;    // source vertex of each target vertex, or -1
+    std::vector<int> m_conflictsAt;
+    std::vector<int> m_sourceMarks; // stamps of the neighbours being compared
+    int m_stamp = 0;
+    int m_mapped = 0;
+    int m_conflicts = 0;
+};